@@ -22,6 +22,7 @@
 
 #include "gui/EventRecorder.h"
 
+#include "common/config-manager.h"
 #include "common/util.h"
 #include "common/system.h"
 #include "common/textconsole.h"
@@ -44,7 +45,7 @@ namespace Audio {
  */
 class Channel {
 public:
-	Channel(Mixer *mixer, Mixer::SoundType type, AudioStream *stream, DisposeAfterUse::Flag autofreeStream, bool reverseStereo, int id, bool permanent);
+	Channel(Mixer *mixer, Mixer::SoundType type, AudioStream *stream, DisposeAfterUse::Flag autofreeStream, RateConverter *converter, int id, bool permanent);
 	~Channel();
 
 	/**
@@ -61,7 +62,7 @@ public:
 	/**
 	 * Queries whether the channel is still playing or not.
 	 */
-	bool isFinished() const { return _stream->endOfStream(); }
+	bool isFinished() const { return _stream->endOfStream() && _drained; }
 
 	/**
 	 * Queries whether the channel is a permanent channel.
@@ -166,19 +167,71 @@ private:
 	uint32 _pauseTime;
 
 	RateConverter *_converter;
+	bool _drained;
 	Common::DisposablePtr<AudioStream> _stream;
 };
 
+#pragma mark -
+#pragma mark --- Mixing helpers ---
+#pragma mark -
+
+// The helpers below are deliberately kept as plain loops over contiguous
+// buffers without any aliasing or early exits, so that the compiler is able
+// to vectorize them (SSE2 on x86, NEON on ARM) when optimizing.
+
+/**
+ * Fill a buffer with silence, as understood by clampedAdd().
+ */
+static void clearSamples(int16 *buf, uint count) {
+#ifdef OUTPUT_UNSIGNED_AUDIO
+	for (uint i = 0; i < count; ++i)
+		buf[i] = (int16)0x8000;
+#else
+	memset(buf, 0, count * sizeof(int16));
+#endif
+}
+
+/**
+ * Add the samples of a single channel to the 32-bit mix buffer.
+ */
+static void accumulateSamples(int32 *dst, const int16 *src, uint count) {
+	for (uint i = 0; i < count; ++i) {
+#ifdef OUTPUT_UNSIGNED_AUDIO
+		dst[i] += (int16)(src[i] ^ 0x8000);
+#else
+		dst[i] += src[i];
+#endif
+	}
+}
+
+/**
+ * Clamp the 32-bit mix buffer down to the 16-bit output format.
+ */
+static void clampSamples(int16 *dst, const int32 *src, uint count) {
+	for (uint i = 0; i < count; ++i) {
+		const int32 val = CLIP<int32>(src[i], ST_SAMPLE_MIN, ST_SAMPLE_MAX);
+#ifdef OUTPUT_UNSIGNED_AUDIO
+		dst[i] = (int16)val ^ 0x8000;
+#else
+		dst[i] = (int16)val;
+#endif
+	}
+}
+
 #pragma mark -
 #pragma mark --- Mixer ---
 #pragma mark -
 
 // TODO: parameter "system" is unused
 MixerImpl::MixerImpl(OSystem *system, uint sampleRate)
-	: _mutex(), _sampleRate(sampleRate), _mixerReady(false), _handleSeed(0), _soundTypeSettings() {
+	: _mutex(), _sampleRate(sampleRate), _mixerReady(false), _handleSeed(0), _resamplingQuality(kResamplingFast),
+	  _soundTypeSettings(), _mixBuffer(0), _channelBuffer(0), _mixBufferSize(0) {
 
 	assert(sampleRate > 0);
 
+	if (ConfMan.hasKey("resampling_quality"))
+		_resamplingQuality = (ResamplingQuality)CLIP<int>(ConfMan.getInt("resampling_quality"), kResamplingFast, kResamplingBest);
+
 	for (int i = 0; i != NUM_CHANNELS; i++)
 		_channels[i] = 0;
 }
@@ -186,6 +239,24 @@ MixerImpl::MixerImpl(OSystem *system, uint sampleRate)
 MixerImpl::~MixerImpl() {
 	for (int i = 0; i != NUM_CHANNELS; i++)
 		delete _channels[i];
+
+	free(_mixBuffer);
+	free(_channelBuffer);
+}
+
+void MixerImpl::allocateMixBuffers(uint len) {
+	if (len <= _mixBufferSize)
+		return;
+
+	free(_mixBuffer);
+	free(_channelBuffer);
+
+	_mixBuffer = (int32 *)malloc(2 * len * sizeof(int32));
+	_channelBuffer = (int16 *)malloc(2 * len * sizeof(int16));
+	if (!_mixBuffer || !_channelBuffer)
+		error("MixerImpl::allocateMixBuffers: Cannot allocate memory for %u samples", len);
+
+	_mixBufferSize = len;
 }
 
 void MixerImpl::setReady(bool ready) {
@@ -229,13 +300,24 @@ void MixerImpl::playStream(
 			DisposeAfterUse::Flag autofreeStream,
 			bool permanent,
 			bool reverseStereo) {
-	Common::StackLock lock(_mutex);
-
 	if (stream == 0) {
 		warning("stream is 0");
 		return;
 	}
 
+#ifdef AUDIO_REVERSE_STEREO
+	reverseStereo = !reverseStereo;
+#endif
+
+	// Building the rate converter may take a while, so it is done without
+	// holding the mutex the mixer callback needs
+	RateConverter *converter;
+	{
+		Common::StackLock converterLock(_converterMutex);
+		converter = makeRateConverter(stream->getRate(), getOutputRate(), stream->isStereo(), reverseStereo, _resamplingQuality);
+	}
+
+	Common::StackLock lock(_mutex);
 
 	assert(_mixerReady);
 
@@ -251,16 +333,13 @@ void MixerImpl::playStream(
 				// try to play QueuingAudioStreams with a sound id.
 				if (autofreeStream == DisposeAfterUse::YES)
 					delete stream;
+				delete converter;
 				return;
 			}
 	}
 
-#ifdef AUDIO_REVERSE_STEREO
-	reverseStereo = !reverseStereo;
-#endif
-
 	// Create the channel
-	Channel *chan = new Channel(this, type, stream, autofreeStream, reverseStereo, id, permanent);
+	Channel *chan = new Channel(this, type, stream, autofreeStream, converter, id, permanent);
 	chan->setVolume(volume);
 	chan->setBalance(balance);
 	insertChannel(handle, chan);
@@ -269,67 +348,107 @@ void MixerImpl::playStream(
 int MixerImpl::mixCallback(byte *samples, uint len) {
 	assert(samples);
 
-	Common::StackLock lock(_mutex);
-
 	int16 *buf = (int16 *)samples;
 	// we store stereo, 16-bit samples
 	assert(len % 4 == 0);
 	len >>= 2;
 
-	// Since the mixer callback has been called, the mixer must be ready...
-	_mixerReady = true;
+	// Finished channels are only unlinked while the mutex is held. They are
+	// destroyed after it has been released, so that tearing down their
+	// streams does not stall other threads waiting on the mixer.
+	Channel *finished[NUM_CHANNELS];
+	int numFinished = 0;
 
-	//  zero the buf
-	memset(buf, 0, 2 * len * sizeof(int16));
-
-	// mix all channels
 	int res = 0, tmp;
-	for (int i = 0; i != NUM_CHANNELS; i++)
-		if (_channels[i]) {
-			if (_channels[i]->isFinished()) {
-				delete _channels[i];
-				_channels[i] = 0;
-			} else if (!_channels[i]->isPaused()) {
-				tmp = _channels[i]->mix(buf, len);
 
-				if (tmp > res)
-					res = tmp;
+	{
+		Common::StackLock lock(_mutex);
+
+		// Since the mixer callback has been called, the mixer must be ready...
+		_mixerReady = true;
+
+		allocateMixBuffers(len);
+
+		//  zero the intermediate buffer
+		memset(_mixBuffer, 0, 2 * len * sizeof(int32));
+
+		// mix all channels
+		for (int i = 0; i != NUM_CHANNELS; i++)
+			if (_channels[i]) {
+				if (_channels[i]->isFinished()) {
+					finished[numFinished++] = _channels[i];
+					_channels[i] = 0;
+				} else if (!_channels[i]->isPaused()) {
+					clearSamples(_channelBuffer, 2 * len);
+					tmp = _channels[i]->mix(_channelBuffer, len);
+					accumulateSamples(_mixBuffer, _channelBuffer, 2 * tmp);
+
+					if (tmp > res)
+						res = tmp;
+				}
 			}
-		}
+
+		clampSamples(buf, _mixBuffer, 2 * len);
+	}
+
+	for (int i = 0; i < numFinished; i++)
+		delete finished[i];
 
 	return res;
 }
 
 void MixerImpl::stopAll() {
-	Common::StackLock lock(_mutex);
-	for (int i = 0; i != NUM_CHANNELS; i++) {
-		if (_channels[i] != 0 && !_channels[i]->isPermanent()) {
-			delete _channels[i];
-			_channels[i] = 0;
+	Channel *stopped[NUM_CHANNELS];
+	int numStopped = 0;
+
+	{
+		Common::StackLock lock(_mutex);
+		for (int i = 0; i != NUM_CHANNELS; i++) {
+			if (_channels[i] != 0 && !_channels[i]->isPermanent()) {
+				stopped[numStopped++] = _channels[i];
+				_channels[i] = 0;
+			}
 		}
 	}
+
+	for (int i = 0; i < numStopped; i++)
+		delete stopped[i];
 }
 
 void MixerImpl::stopID(int id) {
-	Common::StackLock lock(_mutex);
-	for (int i = 0; i != NUM_CHANNELS; i++) {
-		if (_channels[i] != 0 && _channels[i]->getId() == id) {
-			delete _channels[i];
-			_channels[i] = 0;
+	Channel *stopped[NUM_CHANNELS];
+	int numStopped = 0;
+
+	{
+		Common::StackLock lock(_mutex);
+		for (int i = 0; i != NUM_CHANNELS; i++) {
+			if (_channels[i] != 0 && _channels[i]->getId() == id) {
+				stopped[numStopped++] = _channels[i];
+				_channels[i] = 0;
+			}
 		}
 	}
+
+	for (int i = 0; i < numStopped; i++)
+		delete stopped[i];
 }
 
 void MixerImpl::stopHandle(SoundHandle handle) {
-	Common::StackLock lock(_mutex);
+	Channel *stopped;
 
-	// Simply ignore stop requests for handles of sounds that already terminated
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
-		return;
+	{
+		Common::StackLock lock(_mutex);
+
+		// Simply ignore stop requests for handles of sounds that already terminated
+		const int index = handle._val % NUM_CHANNELS;
+		if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+			return;
+
+		stopped = _channels[index];
+		_channels[index] = 0;
+	}
 
-	delete _channels[index];
-	_channels[index] = 0;
+	delete stopped;
 }
 
 void MixerImpl::muteSoundType(SoundType type, bool mute) {
@@ -500,16 +619,14 @@ int MixerImpl::getVolumeForSoundType(SoundType type) const {
 #pragma mark -
 
 Channel::Channel(Mixer *mixer, Mixer::SoundType type, AudioStream *stream,
-                 DisposeAfterUse::Flag autofreeStream, bool reverseStereo, int id, bool permanent)
+                 DisposeAfterUse::Flag autofreeStream, RateConverter *converter, int id, bool permanent)
     : _type(type), _mixer(mixer), _id(id), _permanent(permanent), _volume(Mixer::kMaxChannelVolume),
       _balance(0), _pauseLevel(0), _samplesConsumed(0), _samplesDecoded(0), _mixerTimeStamp(0),
-      _pauseStartTime(0), _pauseTime(0), _converter(0), _volL(0), _volR(0),
+      _pauseStartTime(0), _pauseTime(0), _converter(converter), _drained(false), _volL(0), _volR(0),
       _stream(stream, autofreeStream) {
 	assert(mixer);
 	assert(stream);
-
-	// Get a rate converter instance
-	_converter = makeRateConverter(_stream->getRate(), mixer->getOutputRate(), _stream->isStereo(), reverseStereo);
+	assert(converter);
 }
 
 Channel::~Channel() {
@@ -611,9 +728,7 @@ int Channel::mix(int16 *data, uint len) {
 	assert(_stream);
 
 	int res = 0;
-	if (_stream->endOfData()) {
-		// TODO: call drain method
-	} else {
+	if (!_stream->endOfData()) {
 		assert(_converter);
 		_samplesConsumed = _samplesDecoded;
 		_mixerTimeStamp = g_system->getMillis(true);
@@ -622,6 +737,13 @@ int Channel::mix(int16 *data, uint len) {
 		_samplesDecoded += res;
 	}
 
+	// Once the stream has ended, output what the converter still holds
+	if (_stream->endOfStream() && (uint)res < len) {
+		const int drained = _converter->drain(data + 2 * res, len - res, _volL, _volR);
+		_drained = ((uint)drained < len - res);
+		res += drained;
+	}
+
 	return res;
 }
 
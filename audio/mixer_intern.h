@@ -26,6 +26,7 @@
 #include "common/scummsys.h"
 #include "common/mutex.h"
 #include "audio/mixer.h"
+#include "audio/rate.h"
 
 namespace Audio {
 
@@ -56,9 +57,13 @@ private:
 
 	Common::Mutex _mutex;
 
+	/** Serializes the creation of rate converters, which share tables */
+	Common::Mutex _converterMutex;
+
 	const uint _sampleRate;
 	bool _mixerReady;
 	uint32 _handleSeed;
+	ResamplingQuality _resamplingQuality;
 
 	struct SoundTypeSettings {
 		SoundTypeSettings() : mute(false), volume(kMaxMixerVolume) {}
@@ -70,6 +75,18 @@ private:
 	SoundTypeSettings _soundTypeSettings[4];
 	Channel *_channels[NUM_CHANNELS];
 
+	/**
+	 * Intermediate buffer all channels are accumulated into. Samples are
+	 * kept at 32-bit precision and only clamped once per callback, after
+	 * every channel has been mixed.
+	 */
+	int32 *_mixBuffer;
+
+	/** Scratch buffer a single channel's rate converter writes into. */
+	int16 *_channelBuffer;
+
+	/** Capacity of _mixBuffer and _channelBuffer, in sample pairs. */
+	uint _mixBufferSize;
 
 public:
 
@@ -121,6 +138,12 @@ public:
 protected:
 	void insertChannel(SoundHandle *handle, Channel *chan);
 
+	/**
+	 * Make sure the intermediate mixing buffers can hold at least the
+	 * given number of sample pairs.
+	 */
+	void allocateMixBuffers(uint len);
+
 public:
 	/**
 	 * The mixer callback function, to be called at regular intervals by
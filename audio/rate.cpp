@@ -70,7 +70,7 @@ protected:
 public:
 	SimpleRateConverter(st_rate_t inrate, st_rate_t outrate);
 	int flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r);
-	int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol) {
+	int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
 		return ST_SUCCESS;
 	}
 };
@@ -176,7 +176,7 @@ protected:
 public:
 	LinearRateConverter(st_rate_t inrate, st_rate_t outrate);
 	int flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r);
-	int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol) {
+	int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
 		return ST_SUCCESS;
 	}
 };
@@ -322,7 +322,7 @@ public:
 		return (obuf - ostart) / 2;
 	}
 
-	virtual int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol) {
+	virtual int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
 		return ST_SUCCESS;
 	}
 };
@@ -346,7 +346,10 @@ RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate) {
 /**
  * Create and return a RateConverter object for the specified input and output rates.
  */
-RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo) {
+RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo, ResamplingQuality quality) {
+	if (inrate != outrate && quality != kResamplingFast)
+		return makePolyphaseRateConverter(inrate, outrate, stereo, reverseStereo, quality);
+
 	if (stereo) {
 		if (reverseStereo)
 			return makeRateConverter<true, true>(inrate, outrate);
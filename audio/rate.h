@@ -45,6 +45,21 @@ enum {
 	ST_SUCCESS = 0
 };
 
+/**
+ * Quality levels of the rate conversion.
+ *
+ * kResamplingFast uses nearest neighbour or linear interpolation, which is
+ * cheap but aliases audibly when upsampling low rate samples. The other
+ * levels use a band-limited polyphase (windowed sinc) converter with
+ * increasingly long filters.
+ */
+enum ResamplingQuality {
+	kResamplingFast = 0,
+	kResamplingMedium = 1,
+	kResamplingHigh = 2,
+	kResamplingBest = 3
+};
+
 static inline void clampedAdd(int16& a, int b) {
 	register int val;
 #ifdef OUTPUT_UNSIGNED_AUDIO
@@ -75,10 +90,27 @@ public:
 	 */
 	virtual int flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) = 0;
 
-	virtual int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol) = 0;
+	/**
+	 * Output the samples which the converter still holds back once the
+	 * input stream has ended.
+	 *
+	 * @return Number of sample pairs written into the buffer, less than
+	 *         osamp once the converter is empty.
+	 */
+	virtual int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) = 0;
 };
 
-RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo = false);
+RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo = false, ResamplingQuality quality = kResamplingFast);
+
+/**
+ * Create a band-limited polyphase RateConverter for the specified input and
+ * output rates. Used by makeRateConverter() for all quality levels above
+ * kResamplingFast.
+ *
+ * The filter tables are shared between the converters, so they must not be
+ * created from several threads at the same time.
+ */
+RateConverter *makePolyphaseRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo, ResamplingQuality quality);
 
 } // End of namespace Audio
 
@@ -96,7 +96,7 @@ protected:
 public:
 	SimpleRateConverter(st_rate_t inrate, st_rate_t outrate);
 	int flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r);
-	int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol) {
+	int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
 		return (ST_SUCCESS);
 	}
 };
@@ -270,7 +270,7 @@ protected:
 public:
 	LinearRateConverter(st_rate_t inrate, st_rate_t outrate);
 	int flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r);
-	int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol) {
+	int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
 		return (ST_SUCCESS);
 	}
 };
@@ -424,7 +424,7 @@ public:
 		return (obuf - ostart) / 2;
 	}
 
-	virtual int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol) {
+	virtual int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
 		return (ST_SUCCESS);
 	}
 };
@@ -436,7 +436,10 @@ public:
 /**
  * Create and return a RateConverter object for the specified input and output rates.
  */
-RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo) {
+RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo, ResamplingQuality quality) {
+	if (inrate != outrate && quality != kResamplingFast)
+		return makePolyphaseRateConverter(inrate, outrate, stereo, reverseStereo, quality);
+
 	if (inrate != outrate) {
 		if ((inrate % outrate) == 0) {
 			if (stereo) {
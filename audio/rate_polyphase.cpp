@@ -0,0 +1,440 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+/*
+ * Band-limited polyphase rate converter.
+ *
+ * The converter interpolates between input samples with a windowed sinc
+ * (Kaiser window) low pass filter. The filter is precomputed as a table of
+ * fixed point coefficients, one row per phase, so that producing an output
+ * sample only takes a single integer dot product per channel. Floating
+ * point arithmetic is only used while building the table, and converters
+ * with the same rates and quality share their table.
+ *
+ * If the ratio of the input and the output rate can be expressed with at
+ * most MAX_PHASES phases the conversion is exact, otherwise the position
+ * between two input samples is quantized to MAX_PHASES steps.
+ */
+
+#include "audio/audiostream.h"
+#include "audio/rate.h"
+#include "audio/mixer.h"
+#include "common/algorithm.h"
+#include "common/frac.h"
+#include "common/textconsole.h"
+#include "common/util.h"
+
+namespace Audio {
+
+/**
+ * The size of the intermediate input cache.
+ */
+#define INTERMEDIATE_BUFFER_SIZE 512
+
+/** Maximum number of phases (rows) of a filter table, must be a power of 2. */
+#define MAX_PHASES_BITS 10
+#define MAX_PHASES (1 << MAX_PHASES_BITS)
+
+/** Maximum number of filter taps, used to bound downsampling filters. */
+#define MAX_TAPS 256
+
+/** Fixed point precision of the filter coefficients. */
+#define COEF_BITS 14
+
+/** Number of filter tables which are kept for later converters. */
+#define MAX_CACHED_FILTERS 8
+
+namespace {
+
+struct FilterParameters {
+	/** Number of taps when upsampling. */
+	uint taps;
+	/** Kaiser window shape parameter. */
+	double beta;
+	/** Cutoff frequency, relative to the lower of the two Nyquist rates. */
+	double cutoff;
+};
+
+const FilterParameters &getFilterParameters(ResamplingQuality quality) {
+	static const FilterParameters params[] = {
+		{ 16,  6.0, 0.85 }, // kResamplingMedium
+		{ 32,  8.0, 0.90 }, // kResamplingHigh
+		{ 64, 10.0, 0.94 }  // kResamplingBest
+	};
+
+	switch (quality) {
+	case kResamplingHigh:
+		return params[1];
+	case kResamplingBest:
+		return params[2];
+	default:
+		return params[0];
+	}
+}
+
+/**
+ * Zeroth order modified Bessel function of the first kind, as needed by the
+ * Kaiser window.
+ */
+double besselI0(double x) {
+	double sum = 1.0, term = 1.0;
+	const double halfX = x / 2.0;
+
+	for (int k = 1; k < 64; ++k) {
+		term *= halfX / k;
+		const double squared = term * term;
+		sum += squared;
+		if (squared < sum * 1e-12)
+			break;
+	}
+
+	return sum;
+}
+
+/**
+ * Dot product of filter coefficients and input samples. Kept as a plain
+ * loop over contiguous arrays so the compiler is able to vectorize it.
+ */
+inline int32 dotProduct(const int16 *coefs, const int16 *samples, uint taps) {
+	int32 sum = 0;
+	for (uint i = 0; i < taps; ++i)
+		sum += coefs[i] * samples[i];
+	return sum;
+}
+
+/**
+ * Build a filter table of numPhases rows of taps coefficients.
+ */
+int16 *buildFilter(st_rate_t inrate, st_rate_t outrate, const FilterParameters &params, uint numPhases, uint taps) {
+	int16 *table = (int16 *)malloc(numPhases * taps * sizeof(int16));
+	double *row = (double *)malloc(taps * sizeof(double));
+	if (!table || !row)
+		error("[PolyphaseRateConverter] Cannot allocate memory for filter table");
+
+	// Cutoff relative to the input Nyquist rate.
+	const double cutoff = params.cutoff * MIN<double>(1.0, (double)outrate / inrate);
+	const double halfWidth = taps / 2;
+	const double windowScale = 1.0 / besselI0(params.beta);
+	const int one = 1 << COEF_BITS;
+
+	for (uint phase = 0; phase < numPhases; ++phase) {
+		const double frac = (double)phase / numPhases;
+
+		double sum = 0.0;
+		for (uint tap = 0; tap < taps; ++tap) {
+			// Distance of this tap from the interpolated position
+			const double dist = (double)tap - (halfWidth - 1.0) - frac;
+			const double x = dist / halfWidth;
+
+			double value = 0.0;
+			if (x > -1.0 && x < 1.0) {
+				const double window = besselI0(params.beta * sqrt(1.0 - x * x)) * windowScale;
+				const double arg = M_PI * cutoff * dist;
+				const double sinc = (dist == 0.0) ? 1.0 : sin(arg) / arg;
+				value = cutoff * sinc * window;
+			}
+
+			row[tap] = value;
+			sum += value;
+		}
+
+		// Normalize every phase to unity gain and make sure the rounded
+		// coefficients sum up exactly, to avoid any DC ripple.
+		int16 *coefs = table + phase * taps;
+		int total = 0;
+		uint largest = 0;
+		for (uint tap = 0; tap < taps; ++tap) {
+			coefs[tap] = (int16)floor(row[tap] / sum * one + 0.5);
+			total += coefs[tap];
+			if (ABS(coefs[tap]) > ABS(coefs[largest]))
+				largest = tap;
+		}
+		coefs[largest] += one - total;
+	}
+
+	free(row);
+	return table;
+}
+
+struct CachedFilter {
+	st_rate_t inrate;
+	st_rate_t outrate;
+	ResamplingQuality quality;
+	const int16 *table;
+};
+
+/**
+ * Filter tables shared between converters. A game only uses a few rates,
+ * so the tables are kept until the program exits.
+ */
+CachedFilter s_filterCache[MAX_CACHED_FILTERS];
+uint s_filterCacheSize = 0;
+
+/**
+ * Look up the filter table for the given rates and quality, or build it.
+ *
+ * @param shared	set to whether the table belongs to the cache, otherwise
+ *                  the caller has to free it
+ */
+const int16 *getFilter(st_rate_t inrate, st_rate_t outrate, ResamplingQuality quality, uint numPhases, uint taps, bool &shared) {
+	for (uint i = 0; i < s_filterCacheSize; ++i) {
+		const CachedFilter &filter = s_filterCache[i];
+		if (filter.inrate == inrate && filter.outrate == outrate && filter.quality == quality) {
+			shared = true;
+			return filter.table;
+		}
+	}
+
+	const int16 *table = buildFilter(inrate, outrate, getFilterParameters(quality), numPhases, taps);
+
+	shared = (s_filterCacheSize < MAX_CACHED_FILTERS);
+	if (shared) {
+		CachedFilter &filter = s_filterCache[s_filterCacheSize++];
+		filter.inrate = inrate;
+		filter.outrate = outrate;
+		filter.quality = quality;
+		filter.table = table;
+	}
+
+	return table;
+}
+
+} // End of anonymous namespace
+
+template<bool stereo, bool reverseStereo>
+class PolyphaseRateConverter : public RateConverter {
+protected:
+	st_sample_t inBuf[INTERMEDIATE_BUFFER_SIZE];
+	const st_sample_t *inPtr;
+	int inLen;
+
+	/** Filter table, _numPhases rows of _taps coefficients. */
+	const int16 *_coefs;
+	bool _sharedCoefs;
+	uint _taps;
+	uint _numPhases;
+
+	/**
+	 * Position between the two input samples in the middle of the history
+	 * window, in units of 1 / _phaseMod input samples.
+	 */
+	uint32 _phase;
+	uint32 _phaseInc;
+	uint32 _phaseMod;
+	/** Shift turning a phase into a row of the filter table. */
+	uint _phaseShift;
+
+	/**
+	 * Input history of each channel. Every sample is stored twice, _taps
+	 * entries apart, so that the last _taps samples are always available
+	 * as a contiguous block starting at _histPos.
+	 */
+	int16 *_hist0, *_hist1;
+	uint _histPos;
+
+	/**
+	 * Silent samples which drain() still has to feed in, so that the
+	 * input samples in the second half of the history get output.
+	 */
+	uint _drainLeft;
+
+	void pushSample(st_sample_t sample0, st_sample_t sample1);
+	st_sample_t filter(const int16 *hist, const int16 *coefs) const;
+
+public:
+	PolyphaseRateConverter(st_rate_t inrate, st_rate_t outrate, ResamplingQuality quality);
+	~PolyphaseRateConverter();
+
+	int flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r);
+	int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r);
+};
+
+template<bool stereo, bool reverseStereo>
+PolyphaseRateConverter<stereo, reverseStereo>::PolyphaseRateConverter(st_rate_t inrate, st_rate_t outrate, ResamplingQuality quality)
+	: inPtr(0), inLen(0), _coefs(0), _sharedCoefs(false), _taps(0), _numPhases(0), _phase(0), _phaseInc(0), _phaseMod(0), _phaseShift(0),
+	  _hist0(0), _hist1(0), _histPos(0), _drainLeft(0) {
+	if (inrate >= 65536 || outrate >= 65536) {
+		error("rate effect can only handle rates < 65536");
+	}
+
+	const st_rate_t divisor = Common::gcd(inrate, outrate);
+	if (outrate / divisor <= MAX_PHASES) {
+		// Exact conversion: every phase gets its own table row.
+		_phaseMod = outrate / divisor;
+		_phaseInc = inrate / divisor;
+		_numPhases = _phaseMod;
+		_phaseShift = 0;
+	} else {
+		// Quantize the position between two input samples.
+		_phaseMod = FRAC_ONE;
+		_phaseInc = (inrate << FRAC_BITS) / outrate;
+		_numPhases = MAX_PHASES;
+		_phaseShift = FRAC_BITS - MAX_PHASES_BITS;
+	}
+
+	const FilterParameters &params = getFilterParameters(quality);
+
+	// When downsampling, the filter has to be stretched to keep the same
+	// number of zero crossings at the lower cutoff frequency.
+	_taps = params.taps;
+	if (outrate < inrate) {
+		_taps = (_taps * inrate + outrate - 1) / outrate;
+		_taps = MIN<uint>((_taps + 1) & ~1, MAX_TAPS);
+	}
+
+	_coefs = getFilter(inrate, outrate, quality, _numPhases, _taps, _sharedCoefs);
+
+	_hist0 = (int16 *)calloc(2 * _taps, sizeof(int16));
+	_hist1 = stereo ? (int16 *)calloc(2 * _taps, sizeof(int16)) : 0;
+	if (!_hist0 || (stereo && !_hist1))
+		error("[PolyphaseRateConverter] Cannot allocate memory for history buffer");
+
+	// Make the converter read enough input before the first output sample,
+	// so that the first input sample sits in the middle of the history
+	// window. This way the output is not delayed against the input.
+	_phase = _phaseMod * (_taps / 2 + 1);
+	_drainLeft = _taps / 2;
+}
+
+template<bool stereo, bool reverseStereo>
+PolyphaseRateConverter<stereo, reverseStereo>::~PolyphaseRateConverter() {
+	if (!_sharedCoefs)
+		free(const_cast<int16 *>(_coefs));
+	free(_hist0);
+	free(_hist1);
+}
+
+template<bool stereo, bool reverseStereo>
+inline void PolyphaseRateConverter<stereo, reverseStereo>::pushSample(st_sample_t sample0, st_sample_t sample1) {
+	_hist0[_histPos] = _hist0[_histPos + _taps] = sample0;
+	if (stereo)
+		_hist1[_histPos] = _hist1[_histPos + _taps] = sample1;
+
+	if (++_histPos == _taps)
+		_histPos = 0;
+}
+
+template<bool stereo, bool reverseStereo>
+inline st_sample_t PolyphaseRateConverter<stereo, reverseStereo>::filter(const int16 *hist, const int16 *coefs) const {
+	const int32 val = (dotProduct(coefs, hist + _histPos, _taps) + (1 << (COEF_BITS - 1))) >> COEF_BITS;
+	return (st_sample_t)CLIP<int32>(val, ST_SAMPLE_MIN, ST_SAMPLE_MAX);
+}
+
+/*
+ * Processed signed long samples from ibuf to obuf.
+ * Return number of sample pairs processed.
+ */
+template<bool stereo, bool reverseStereo>
+int PolyphaseRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
+	st_sample_t *ostart, *oend;
+
+	ostart = obuf;
+	oend = obuf + osamp * 2;
+
+	while (obuf < oend) {
+
+		// read enough input samples so that the position lies between
+		// the two samples in the middle of the history window
+		while (_phase >= _phaseMod) {
+			// Check if we have to refill the buffer
+			if (inLen == 0) {
+				inPtr = inBuf;
+				inLen = input.readBuffer(inBuf, ARRAYSIZE(inBuf));
+				if (inLen <= 0)
+					return (obuf - ostart) / 2;
+			}
+			inLen -= (stereo ? 2 : 1);
+			if (stereo) {
+				pushSample(inPtr[0], inPtr[1]);
+				inPtr += 2;
+			} else {
+				pushSample(*inPtr++, 0);
+			}
+			_phase -= _phaseMod;
+		}
+
+		const int16 *coefs = _coefs + (_phase >> _phaseShift) * _taps;
+
+		st_sample_t out0, out1;
+		out0 = filter(_hist0, coefs);
+		out1 = (stereo ? filter(_hist1, coefs) : out0);
+
+		// output left channel
+		clampedAdd(obuf[reverseStereo    ], (out0 * (int)vol_l) / Audio::Mixer::kMaxMixerVolume);
+
+		// output right channel
+		clampedAdd(obuf[reverseStereo ^ 1], (out1 * (int)vol_r) / Audio::Mixer::kMaxMixerVolume);
+
+		obuf += 2;
+
+		// Increment output position
+		_phase += _phaseInc;
+	}
+	return (obuf - ostart) / 2;
+}
+
+template<bool stereo, bool reverseStereo>
+int PolyphaseRateConverter<stereo, reverseStereo>::drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
+	st_sample_t *ostart, *oend;
+
+	ostart = obuf;
+	oend = obuf + osamp * 2;
+
+	while (obuf < oend) {
+
+		// pad the input with silence until the last input sample has
+		// passed the middle of the history window
+		while (_phase >= _phaseMod) {
+			if (_drainLeft == 0)
+				return (obuf - ostart) / 2;
+
+			pushSample(0, 0);
+			_drainLeft--;
+			_phase -= _phaseMod;
+		}
+
+		const int16 *coefs = _coefs + (_phase >> _phaseShift) * _taps;
+
+		st_sample_t out0, out1;
+		out0 = filter(_hist0, coefs);
+		out1 = (stereo ? filter(_hist1, coefs) : out0);
+
+		clampedAdd(obuf[reverseStereo    ], (out0 * (int)vol_l) / Audio::Mixer::kMaxMixerVolume);
+		clampedAdd(obuf[reverseStereo ^ 1], (out1 * (int)vol_r) / Audio::Mixer::kMaxMixerVolume);
+
+		obuf += 2;
+		_phase += _phaseInc;
+	}
+	return (obuf - ostart) / 2;
+}
+
+RateConverter *makePolyphaseRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo, ResamplingQuality quality) {
+	if (stereo) {
+		if (reverseStereo)
+			return new PolyphaseRateConverter<true, true>(inrate, outrate, quality);
+		else
+			return new PolyphaseRateConverter<true, false>(inrate, outrate, quality);
+	} else
+		return new PolyphaseRateConverter<false, false>(inrate, outrate, quality);
+}
+
+} // End of namespace Audio
@@ -159,6 +159,17 @@ public:
 	 */
 	virtual bool isWritable() const = 0;
 
+	/**
+	 * Retrieves the size and the time of the last modification of the file
+	 * referred by this node, without opening it.
+	 *
+	 * The modification time is only meant to be compared against earlier
+	 * values for the same file; its epoch is up to the implementation.
+	 *
+	 * @return true if the information is available, false otherwise.
+	 */
+	virtual bool getFileInfo(uint32 &size, uint32 &modificationTime) const { return false; }
+
 
 	/**
 	 * Creates a SeekableReadStream instance corresponding to the file
@@ -169,6 +180,15 @@ public:
 	 */
 	virtual Common::SeekableReadStream *createReadStream() = 0;
 
+	/**
+	 * Creates a SeekableReadStream instance for the file referred by this
+	 * node, which may map the file into memory. By default, this is the
+	 * same as createReadStream().
+	 *
+	 * @return pointer to the stream object, 0 in case of a failure
+	 */
+	virtual Common::SeekableReadStream *createMappedReadStream() { return createReadStream(); }
+
 	/**
 	 * Creates a WriteStream instance corresponding to the file
 	 * referred by this node. This assumes that the node actually refers
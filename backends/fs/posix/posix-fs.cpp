@@ -31,6 +31,7 @@
 #define FORBIDDEN_SYMBOL_EXCEPTION_exit		//Needed for IRIX's unistd.h
 
 #include "backends/fs/posix/posix-fs.h"
+#include "backends/fs/posix/posix-mappedstream.h"
 #include "backends/fs/stdiostream.h"
 #include "common/algorithm.h"
 
@@ -52,6 +53,17 @@ void POSIXFilesystemNode::setFlags() {
 	_isDirectory = _isValid ? S_ISDIR(st.st_mode) : false;
 }
 
+bool POSIXFilesystemNode::getFileInfo(uint32 &size, uint32 &modificationTime) const {
+	struct stat st;
+
+	if (stat(_path.c_str(), &st) != 0 || !S_ISREG(st.st_mode))
+		return false;
+
+	size = (uint32)st.st_size;
+	modificationTime = (uint32)st.st_mtime;
+	return true;
+}
+
 POSIXFilesystemNode::POSIXFilesystemNode(const Common::String &p) {
 	assert(p.size() > 0);
 
@@ -247,6 +259,25 @@ Common::SeekableReadStream *POSIXFilesystemNode::createReadStream() {
 	return StdioStream::makeFromPath(getPath(), false);
 }
 
+/**
+ * Files of at least this size are mapped into memory, if requested. Small
+ * files, for which mapping is not worth it, still use stdio.
+ */
+static const uint32 kMinMappedFileSize = 256 * 1024;
+
+Common::SeekableReadStream *POSIXFilesystemNode::createMappedReadStream() {
+#ifdef USE_MMAP
+	// Large mappings quickly use up the address space of 32-bit systems
+	if (sizeof(void *) >= 8) {
+		Common::SeekableReadStream *stream = PosixMappedStream::makeFromPath(getPath(), kMinMappedFileSize);
+		if (stream)
+			return stream;
+	}
+#endif
+
+	return createReadStream();
+}
+
 Common::WriteStream *POSIXFilesystemNode::createWriteStream() {
 	return StdioStream::makeFromPath(getPath(), true);
 }
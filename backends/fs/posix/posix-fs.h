@@ -66,12 +66,14 @@ public:
 	virtual bool isDirectory() const { return _isDirectory; }
 	virtual bool isReadable() const { return access(_path.c_str(), R_OK) == 0; }
 	virtual bool isWritable() const { return access(_path.c_str(), W_OK) == 0; }
+	virtual bool getFileInfo(uint32 &size, uint32 &modificationTime) const;
 
 	virtual AbstractFSNode *getChild(const Common::String &n) const;
 	virtual bool getChildren(AbstractFSList &list, ListMode mode, bool hidden) const;
 	virtual AbstractFSNode *getParent() const;
 
 	virtual Common::SeekableReadStream *createReadStream();
+	virtual Common::SeekableReadStream *createMappedReadStream();
 	virtual Common::WriteStream *createWriteStream();
 
 private:
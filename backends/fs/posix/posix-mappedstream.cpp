@@ -0,0 +1,114 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+// Re-enable some forbidden symbols to avoid clashes with stat.h and unistd.h.
+// Also with clock() in sys/time.h in some Mac OS X SDKs.
+#define FORBIDDEN_SYMBOL_EXCEPTION_time_h
+#define FORBIDDEN_SYMBOL_EXCEPTION_unistd_h
+#define FORBIDDEN_SYMBOL_EXCEPTION_mkdir
+#define FORBIDDEN_SYMBOL_EXCEPTION_exit		//Needed for IRIX's unistd.h
+
+#include "backends/fs/posix/posix-mappedstream.h"
+
+#ifdef USE_MMAP
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+PosixMappedStream *PosixMappedStream::makeFromPath(const Common::String &path, uint32 minSize) {
+	const int fd = open(path.c_str(), O_RDONLY);
+	if (fd == -1)
+		return 0;
+
+	struct stat st;
+	void *data = MAP_FAILED;
+
+	// Files which do not fit the stream size can not be mapped either
+	if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size >= (off_t)minSize && st.st_size > 0 && st.st_size <= 0x7FFFFFFF)
+		data = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+	// The mapping stays valid after closing the file
+	close(fd);
+
+	if (data == MAP_FAILED)
+		return 0;
+
+	return new PosixMappedStream(data, st.st_size);
+}
+
+PosixMappedStream::PosixMappedStream(void *data, uint32 size)
+	: _mapping(data), _size(size), _pos(0), _eos(false) {
+}
+
+PosixMappedStream::~PosixMappedStream() {
+	munmap(_mapping, _size);
+}
+
+uint32 PosixMappedStream::read(void *dataPtr, uint32 dataSize) {
+	const uint32 available = ((uint32)_pos < _size) ? _size - _pos : 0;
+	if (dataSize > available) {
+		dataSize = available;
+		_eos = true;
+	}
+
+	memcpy(dataPtr, (const byte *)_mapping + _pos, dataSize);
+	_pos += dataSize;
+	return dataSize;
+}
+
+const byte *PosixMappedStream::borrowData(uint32 dataSize) {
+	if ((uint32)_pos > _size || dataSize > _size - _pos)
+		return 0;
+
+	const byte *result = (const byte *)_mapping + _pos;
+	_pos += dataSize;
+	return result;
+}
+
+bool PosixMappedStream::seek(int32 offs, int whence) {
+	int32 newPos;
+
+	switch (whence) {
+	case SEEK_END:
+		newPos = _size + offs;
+		break;
+	case SEEK_CUR:
+		newPos = _pos + offs;
+		break;
+	case SEEK_SET:
+	default:
+		newPos = offs;
+		break;
+	}
+
+	// Like fseek, fail for negative positions but allow seeking past the end
+	if (newPos < 0)
+		return false;
+
+	_pos = newPos;
+	_eos = false;
+	return true;
+}
+
+#endif
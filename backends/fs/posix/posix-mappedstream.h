@@ -0,0 +1,81 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef BACKENDS_FS_POSIX_MAPPEDSTREAM_H
+#define BACKENDS_FS_POSIX_MAPPEDSTREAM_H
+
+#include "common/stream.h"
+#include "common/str.h"
+
+/**
+ * Read stream for a file which is mapped into memory with mmap().
+ *
+ * Reading from it does not require any system calls, and the data can be
+ * accessed without copying it through borrowData(). Mapped files are
+ * shared through the page cache of the operating system, so several
+ * processes running the same game only keep one copy of its data in
+ * memory.
+ *
+ * Seeking behaves like for a StdioStream: seeking past the end of the file
+ * succeeds, and the next read then reports the end of the stream. If the
+ * file is truncated while it is mapped, reading the missing part raises
+ * SIGBUS, which is why mapping is only done on request, through
+ * FSNode::createMappedReadStream().
+ */
+class PosixMappedStream : public Common::SeekableReadStream {
+public:
+	/**
+	 * Map the file with the given path into memory. This fails for files
+	 * which are not regular files, are smaller than minSize bytes or can
+	 * not be mapped, in which case callers should fall back to a
+	 * StdioStream.
+	 *
+	 * @param path		the path of the file
+	 * @param minSize	the minimum size of files to map
+	 * @return the stream, or 0 on failure
+	 */
+	static PosixMappedStream *makeFromPath(const Common::String &path, uint32 minSize);
+
+	virtual ~PosixMappedStream();
+
+	virtual uint32 read(void *dataPtr, uint32 dataSize);
+	virtual const byte *borrowData(uint32 dataSize);
+
+	virtual bool eos() const { return _eos; }
+	virtual void clearErr() { _eos = false; }
+
+	virtual int32 pos() const { return _pos; }
+	virtual int32 size() const { return _size; }
+
+	virtual bool seek(int32 offs, int whence = SEEK_SET);
+
+private:
+	PosixMappedStream(void *data, uint32 size);
+
+	void *_mapping;
+	uint32 _size;
+	/** The current position, which may lie beyond the end of the file. */
+	int32 _pos;
+	bool _eos;
+};
+
+#endif
@@ -55,6 +55,21 @@ bool WindowsFilesystemNode::isWritable() const {
 	return _access(_path.c_str(), W_OK) == 0;
 }
 
+bool WindowsFilesystemNode::getFileInfo(uint32 &size, uint32 &modificationTime) const {
+	WIN32_FILE_ATTRIBUTE_DATA data;
+
+	if (!GetFileAttributesEx(toUnicode(_path.c_str()), GetFileExInfoStandard, &data))
+		return false;
+	if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+		return false;
+
+	// FILETIME counts 100 nanosecond intervals, convert it to seconds
+	const uint64 time = ((uint64)data.ftLastWriteTime.dwHighDateTime << 32) | data.ftLastWriteTime.dwLowDateTime;
+	size = data.nFileSizeLow;
+	modificationTime = (uint32)(time / 10000000);
+	return true;
+}
+
 void WindowsFilesystemNode::addFile(AbstractFSList &list, ListMode mode, const char *base, bool hidden, WIN32_FIND_DATA* find_data) {
 	WindowsFilesystemNode entry;
 	char *asciiName = toAscii(find_data->cFileName);
@@ -26,6 +26,8 @@
 #include "backends/graphics/opengl/debug.h"
 #include "backends/graphics/opengl/extensions.h"
 
+#include "common/config-manager.h"
+#include "common/debug.h"
 #include "common/textconsole.h"
 #include "common/translation.h"
 #include "common/algorithm.h"
@@ -47,7 +49,7 @@ OpenGLGraphicsManager::OpenGLGraphicsManager()
     : _currentState(), _oldState(), _transactionMode(kTransactionNone), _screenChangeID(1 << (sizeof(int) * 8 - 2)),
       _outputScreenWidth(0), _outputScreenHeight(0), _displayX(0), _displayY(0),
       _displayWidth(0), _displayHeight(0), _defaultFormat(), _defaultFormatAlpha(),
-      _gameScreen(nullptr), _gameScreenShakeOffset(0), _overlay(nullptr),
+      _gameScreen(nullptr), _gameScreenShakeOffset(0), _skipUnchangedRows(true), _overlay(nullptr),
       _overlayVisible(false), _cursor(nullptr),
       _cursorX(0), _cursorY(0), _cursorDisplayX(0),_cursorDisplayY(0), _cursorHotspotX(0), _cursorHotspotY(0),
       _cursorHotspotXScaled(0), _cursorHotspotYScaled(0), _cursorWidthScaled(0), _cursorHeightScaled(0),
@@ -57,6 +59,10 @@ OpenGLGraphicsManager::OpenGLGraphicsManager()
 #endif
     {
 	memset(_gamePalette, 0, sizeof(_gamePalette));
+	memset(&_screenCopyStats, 0, sizeof(_screenCopyStats));
+
+	if (ConfMan.hasKey("skip_unchanged_rows"))
+		_skipUnchangedRows = ConfMan.getBool("skip_unchanged_rows");
 }
 
 OpenGLGraphicsManager::~OpenGLGraphicsManager() {
@@ -330,7 +336,10 @@ int16 OpenGLGraphicsManager::getHeight() {
 }
 
 void OpenGLGraphicsManager::copyRectToScreen(const void *buf, int pitch, int x, int y, int w, int h) {
-	_gameScreen->copyRectToTexture(x, y, w, h, buf, pitch);
+	const uint copiedRows = _gameScreen->copyRectToTexture(x, y, w, h, buf, pitch, _skipUnchangedRows);
+
+	_screenCopyStats.copiedPixels += w * h;
+	_screenCopyStats.changedPixels += w * copiedRows;
 }
 
 void OpenGLGraphicsManager::fillScreen(uint32 col) {
@@ -351,6 +360,12 @@ void OpenGLGraphicsManager::updateScreen() {
 		return;
 	}
 
+	if (_screenCopyStats.copiedPixels) {
+		debug(9, "Screen copies: %d pixels copied, %d pixels changed",
+		      _screenCopyStats.copiedPixels, _screenCopyStats.changedPixels);
+		memset(&_screenCopyStats, 0, sizeof(_screenCopyStats));
+	}
+
 	// Clear the screen buffer.
 	GLCALL(glClear(GL_COLOR_BUFFER_BIT));
 
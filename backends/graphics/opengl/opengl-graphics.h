@@ -355,6 +355,24 @@ private:
 	 */
 	int _gameScreenShakeOffset;
 
+	/**
+	 * Whether copyRectToScreen() compares the new data against the game
+	 * screen and skips rows which did not change.
+	 */
+	bool _skipUnchangedRows;
+
+	/**
+	 * Statistics about the data passed to copyRectToScreen() since the
+	 * last screen update.
+	 */
+	struct ScreenCopyStats {
+		/** Number of pixels passed to copyRectToScreen() */
+		uint32 copiedPixels;
+		/** Number of those pixels in rows which actually changed */
+		uint32 changedPixels;
+	};
+	ScreenCopyStats _screenCopyStats;
+
 	//
 	// Overlay
 	//
@@ -128,11 +128,38 @@ void Texture::allocate(uint width, uint height) {
 	_userPixelData = _textureData.getSubArea(Common::Rect(width, height));
 }
 
-void Texture::copyRectToTexture(uint x, uint y, uint w, uint h, const void *srcPtr, uint srcPitch) {
+uint Texture::copyRectToTexture(uint x, uint y, uint w, uint h, const void *srcPtr, uint srcPitch, bool skipUnchanged) {
 	Graphics::Surface *dstSurf = getSurface();
 	assert(x + w <= dstSurf->w);
 	assert(y + h <= dstSurf->h);
 
+	const byte *src = (const byte *)srcPtr;
+	byte *dst = (byte *)dstSurf->getBasePtr(x, y);
+	const uint pitch = dstSurf->pitch;
+	const uint bytesPerPixel = dstSurf->format.bytesPerPixel;
+
+	if (skipUnchanged) {
+		// The texture is uploaded in whole rows from the top to the bottom
+		// of the dirty area anyway, so only trim unchanged rows from the
+		// top and the bottom of the rect.
+		const uint rowSize = w * bytesPerPixel;
+
+		while (h > 0 && !memcmp(dst, src, rowSize)) {
+			++y;
+			--h;
+			dst += pitch;
+			src += srcPitch;
+		}
+
+		while (h > 0 && !memcmp(dst + (h - 1) * pitch, src + (h - 1) * srcPitch, rowSize)) {
+			--h;
+		}
+
+		if (!h) {
+			return 0;
+		}
+	}
+
 	// *sigh* Common::Rect::extend behaves unexpected whenever one of the two
 	// parameters is an empty rect. Thus, we check whether the current dirty
 	// area is valid. In case it is not we simply use the parameters as new
@@ -143,10 +170,7 @@ void Texture::copyRectToTexture(uint x, uint y, uint w, uint h, const void *srcP
 		_dirtyArea.extend(Common::Rect(x, y, x + w, y + h));
 	}
 
-	const byte *src = (const byte *)srcPtr;
-	byte *dst = (byte *)dstSurf->getBasePtr(x, y);
-	const uint pitch = dstSurf->pitch;
-	const uint bytesPerPixel = dstSurf->format.bytesPerPixel;
+	const uint copiedRows = h;
 
 	if (srcPitch == pitch && x == 0 && w == dstSurf->w) {
 		memcpy(dst, src, h * pitch);
@@ -157,6 +181,8 @@ void Texture::copyRectToTexture(uint x, uint y, uint w, uint h, const void *srcP
 			src += srcPitch;
 		}
 	}
+
+	return copiedRows;
 }
 
 void Texture::fill(uint32 color) {
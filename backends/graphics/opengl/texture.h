@@ -75,7 +75,15 @@ public:
 	 */
 	virtual void allocate(uint width, uint height);
 
-	void copyRectToTexture(uint x, uint y, uint w, uint h, const void *src, uint srcPitch);
+	/**
+	 * Copy a rect into the texture and mark it dirty.
+	 *
+	 * @param skipUnchanged Whether to compare the rows at the top and
+	 *                      bottom of the rect against the texture data and
+	 *                      leave out those which did not change.
+	 * @return The number of rows which were copied.
+	 */
+	uint copyRectToTexture(uint x, uint y, uint w, uint h, const void *src, uint srcPitch, bool skipUnchanged = false);
 
 	void fill(uint32 color);
 
@@ -25,6 +25,7 @@
 #if defined(SDL_BACKEND)
 
 #include "backends/graphics/surfacesdl/surfacesdl-graphics.h"
+#include "backends/graphics/surfacesdl/surfacesdl-scalerpool.h"
 #include "backends/events/sdl/sdl-events.h"
 #include "backends/platform/sdl/sdl.h"
 #include "common/config-manager.h"
@@ -133,7 +134,7 @@ SurfaceSdlGraphicsManager::SurfaceSdlGraphicsManager(SdlEventSource *sdlEventSou
 #endif
 	_overlayVisible(false),
 	_overlayscreen(0), _tmpscreen2(0),
-	_scalerProc(0), _screenChangeCount(0),
+	_scalerProc(0), _scalerPool(0), _screenChangeCount(0), _numDirtyRects(0), _skipUnchangedRows(true),
 	_mouseVisible(false), _mouseNeedsRedraw(false), _mouseData(0), _mouseSurface(0),
 	_mouseOrigSurface(0), _cursorDontScale(false), _cursorPaletteDisabled(true),
 	_currentShakePos(0), _newShakePos(0),
@@ -153,6 +154,8 @@ SurfaceSdlGraphicsManager::SurfaceSdlGraphicsManager(SdlEventSource *sdlEventSou
 	_mouseBackup.x = _mouseBackup.y = _mouseBackup.w = _mouseBackup.h = 0;
 
 	memset(&_mouseCurState, 0, sizeof(_mouseCurState));
+	memset(&_dirtyRectStats, 0, sizeof(_dirtyRectStats));
+	memset(&_screenCopyStats, 0, sizeof(_screenCopyStats));
 
 	_graphicsMutex = g_system->createMutex();
 
@@ -161,6 +164,19 @@ SurfaceSdlGraphicsManager::SurfaceSdlGraphicsManager(SdlEventSource *sdlEventSou
 		_enableFocusRectDebugCode = ConfMan.getBool("use_sdl_debug_focusrect");
 #endif
 
+	// Spread the scaling work over all CPU cores by default. The thread
+	// updating the screen takes part in the scaling as well.
+	int scalerThreads = 0;
+#if SDL_VERSION_ATLEAST(2, 0, 0)
+	scalerThreads = CLIP(SDL_GetCPUCount() - 1, 0, 7);
+#endif
+	if (ConfMan.hasKey("scaler_threads"))
+		scalerThreads = MAX(ConfMan.getInt("scaler_threads"), 0);
+	_scalerPool = new SdlScalerPool(scalerThreads);
+
+	if (ConfMan.hasKey("skip_unchanged_rows"))
+		_skipUnchangedRows = ConfMan.getBool("skip_unchanged_rows");
+
 	memset(&_oldVideoMode, 0, sizeof(_oldVideoMode));
 	memset(&_videoMode, 0, sizeof(_videoMode));
 	memset(&_transactionDetails, 0, sizeof(_transactionDetails));
@@ -196,6 +212,8 @@ SurfaceSdlGraphicsManager::~SurfaceSdlGraphicsManager() {
 	_mouseOrigSurface = 0;
 	g_system->deleteMutex(_graphicsMutex);
 
+	delete _scalerPool;
+
 	free(_currentPalette);
 	free(_cursorPalette);
 	free(_mouseData);
@@ -989,6 +1007,35 @@ void SurfaceSdlGraphicsManager::updateScreen() {
 	Common::StackLock lock(_graphicsMutex);	// Lock the mutex until this function ends
 
 	internUpdateScreen();
+
+	// Reset the statistics here rather than in internUpdateScreen, which
+	// several derived graphics managers override
+	memset(&_dirtyRectStats, 0, sizeof(_dirtyRectStats));
+	memset(&_screenCopyStats, 0, sizeof(_screenCopyStats));
+}
+
+bool SurfaceSdlGraphicsManager::isScalerReentrant(ScalerProc *scalerProc) const {
+#if defined(USE_HQ_SCALERS) && defined(USE_NASM)
+	// The assembler versions of the HQ scalers keep their state in global
+	// variables.
+	if (scalerProc == HQ2x || scalerProc == HQ3x)
+		return false;
+#endif
+	return true;
+}
+
+/**
+ * Checks whether any two of the given rects share pixels.
+ */
+static bool dirtyRectsOverlap(const SDL_Rect *first, const SDL_Rect *last) {
+	for (const SDL_Rect *a = first; a != last; ++a) {
+		for (const SDL_Rect *b = a + 1; b != last; ++b) {
+			if (a->x < b->x + b->w && b->x < a->x + a->w &&
+			    a->y < b->y + b->h && b->y < a->y + a->h)
+				return true;
+		}
+	}
+	return false;
 }
 
 void SurfaceSdlGraphicsManager::internUpdateScreen() {
@@ -1079,6 +1126,19 @@ void SurfaceSdlGraphicsManager::internUpdateScreen() {
 		_dirtyRectList[0].y = 0;
 		_dirtyRectList[0].w = width;
 		_dirtyRectList[0].h = height;
+	} else if (_dirtyRectStats.addedRects) {
+		uint32 drawnArea = 0;
+		for (int i = 0; i < _numDirtyRects; ++i)
+			drawnArea += _dirtyRectList[i].w * _dirtyRectList[i].h;
+
+		debug(9, "Dirty rects: %d added covering %d pixels, %d merged (%d forced), %d drawn covering %d pixels",
+		      _dirtyRectStats.addedRects, _dirtyRectStats.addedArea, _dirtyRectStats.mergedRects,
+		      _dirtyRectStats.forcedMerges, _numDirtyRects, drawnArea);
+	}
+
+	if (_screenCopyStats.copiedPixels) {
+		debug(9, "Screen copies: %d pixels copied, %d pixels changed",
+		      _screenCopyStats.copiedPixels, _screenCopyStats.changedPixels);
 	}
 
 	// Only draw anything if necessary
@@ -1103,6 +1163,16 @@ void SurfaceSdlGraphicsManager::internUpdateScreen() {
 		srcPitch = srcSurf->pitch;
 		dstPitch = _hwscreen->pitch;
 
+		// The aspect ratio correction stretches the scaled output in place,
+		// so each rect has to be stretched before the next one is scaled.
+		// Otherwise all dirty rects are scaled in one go, which allows the
+		// scaler pool to spread them over multiple threads. The scaled rects
+		// are only written concurrently if they don't share any pixels.
+		const bool aspectRatioCorrection = _videoMode.aspectRatioCorrection && !_overlayVisible;
+		const bool concurrent = isScalerReentrant(scalerProc) &&
+			(aspectRatioCorrection || !dirtyRectsOverlap(_dirtyRectList, lastRect));
+
+		assert(scalerProc != NULL);
 		for (r = _dirtyRectList; r != lastRect; ++r) {
 			register int dst_y = r->y + _currentShakePos;
 			register int dst_h = 0;
@@ -1121,12 +1191,14 @@ void SurfaceSdlGraphicsManager::internUpdateScreen() {
 #endif
 				dst_y = dst_y * scale1;
 
-				if (_videoMode.aspectRatioCorrection && !_overlayVisible)
+				if (aspectRatioCorrection)
 					dst_y = real2Aspect(dst_y);
 
-				assert(scalerProc != NULL);
-				scalerProc((byte *)srcSurf->pixels + (r->x * 2 + 2) + (r->y + 1) * srcPitch, srcPitch,
-					(byte *)_hwscreen->pixels + rx1 * 2 + dst_y * dstPitch, dstPitch, r->w, dst_h);
+				_scalerPool->addJob(scalerProc, (byte *)srcSurf->pixels + (r->x * 2 + 2) + (r->y + 1) * srcPitch, srcPitch,
+					(byte *)_hwscreen->pixels + rx1 * 2 + dst_y * dstPitch, dstPitch, r->w, dst_h, scale1);
+
+				if (aspectRatioCorrection)
+					_scalerPool->run(concurrent);
 			}
 
 			r->x = rx1;
@@ -1135,10 +1207,14 @@ void SurfaceSdlGraphicsManager::internUpdateScreen() {
 			r->h = dst_h * scale1;
 
 #ifdef USE_SCALERS
-			if (_videoMode.aspectRatioCorrection && orig_dst_y < height && !_overlayVisible)
+			if (aspectRatioCorrection && orig_dst_y < height)
 				r->h = stretch200To240((uint8 *) _hwscreen->pixels, dstPitch, r->w, r->h, r->x, r->y, orig_dst_y * scale1);
 #endif
 		}
+
+		if (!aspectRatioCorrection)
+			_scalerPool->run(concurrent);
+
 		SDL_UnlockSurface(srcSurf);
 		SDL_UnlockSurface(_hwscreen);
 
@@ -1287,12 +1363,21 @@ void SurfaceSdlGraphicsManager::copyRectToScreen(const void *buf, int pitch, int
 	assert(h > 0 && y + h <= _videoMode.screenHeight);
 	assert(w > 0 && x + w <= _videoMode.screenWidth);
 
-	addDirtyRect(x, y, w, h);
-
 	// Try to lock the screen surface
 	if (SDL_LockSurface(_screen) == -1)
 		error("SDL_LockSurface failed: %s", SDL_GetError());
 
+	_screenCopyStats.copiedPixels += w * h;
+
+	if (_skipUnchangedRows) {
+		copyChangedRowsToScreen((const byte *)buf, pitch, x, y, w, h);
+		SDL_UnlockSurface(_screen);
+		return;
+	}
+
+	_screenCopyStats.changedPixels += w * h;
+	addDirtyRect(x, y, w, h);
+
 #ifdef USE_RGB_COLOR
 	byte *dst = (byte *)_screen->pixels + y * _screen->pitch + x * _screenFormat.bytesPerPixel;
 	if (_videoMode.screenWidth == w && pitch == _screen->pitch) {
@@ -1323,6 +1408,37 @@ void SurfaceSdlGraphicsManager::copyRectToScreen(const void *buf, int pitch, int
 	SDL_UnlockSurface(_screen);
 }
 
+void SurfaceSdlGraphicsManager::copyChangedRowsToScreen(const byte *src, int pitch, int x, int y, int w, int h) {
+#ifdef USE_RGB_COLOR
+	const int rowSize = w * _screenFormat.bytesPerPixel;
+	byte *dst = (byte *)_screen->pixels + y * _screen->pitch + x * _screenFormat.bytesPerPixel;
+#else
+	const int rowSize = w;
+	byte *dst = (byte *)_screen->pixels + y * _screen->pitch + x;
+#endif
+
+	// Compare every row against the current screen contents and only copy
+	// and mark dirty the runs of rows which actually changed. Many engines
+	// redraw the whole screen every frame although only parts of it change.
+	int changedStart = -1;
+	for (int row = 0; row <= h; ++row) {
+		const bool changed = (row < h) && memcmp(dst, src, rowSize) != 0;
+
+		if (changed) {
+			memcpy(dst, src, rowSize);
+			if (changedStart < 0)
+				changedStart = row;
+		} else if (changedStart >= 0) {
+			addDirtyRect(x, y + changedStart, w, row - changedStart);
+			_screenCopyStats.changedPixels += w * (row - changedStart);
+			changedStart = -1;
+		}
+
+		src += pitch;
+		dst += _screen->pitch;
+	}
+}
+
 Graphics::Surface *SurfaceSdlGraphicsManager::lockScreen() {
 	assert(_transactionMode == kTransactionNone);
 
@@ -1376,9 +1492,11 @@ void SurfaceSdlGraphicsManager::addDirtyRect(int x, int y, int w, int h, bool re
 	if (_forceFull)
 		return;
 
+	// Instead of falling back to a full redraw, make room by merging the
+	// two cheapest rects if the list is full.
 	if (_numDirtyRects == NUM_DIRTY_RECT) {
-		_forceFull = true;
-		return;
+		mergeCheapestDirtyRects();
+		_dirtyRectStats.forcedMerges++;
 	}
 
 	int height, width;
@@ -1437,9 +1555,95 @@ void SurfaceSdlGraphicsManager::addDirtyRect(int x, int y, int w, int h, bool re
 		r->y = y;
 		r->w = w;
 		r->h = h;
+
+		_dirtyRectStats.addedRects++;
+		_dirtyRectStats.addedArea += w * h;
+
+		r = &_dirtyRectList[coalesceDirtyRect(_numDirtyRects - 1)];
+		if (r->w == width && r->h == height)
+			_forceFull = true;
 	}
 }
 
+/**
+ * Number of pixels which are redrawn needlessly when replacing the two
+ * given rects by their bounding box.
+ */
+static int dirtyRectMergeWaste(const SDL_Rect &a, const SDL_Rect &b) {
+	const int left = MIN<int>(a.x, b.x);
+	const int top = MIN<int>(a.y, b.y);
+	const int right = MAX<int>(a.x + a.w, b.x + b.w);
+	const int bottom = MAX<int>(a.y + a.h, b.y + b.h);
+
+	int covered = a.w * a.h + b.w * b.h;
+
+	const int overlapW = MIN<int>(a.x + a.w, b.x + b.w) - MAX<int>(a.x, b.x);
+	const int overlapH = MIN<int>(a.y + a.h, b.y + b.h) - MAX<int>(a.y, b.y);
+	if (overlapW > 0 && overlapH > 0)
+		covered -= overlapW * overlapH;
+
+	return (right - left) * (bottom - top) - covered;
+}
+
+int SurfaceSdlGraphicsManager::coalesceDirtyRect(int idx) {
+	// Merging grows the rect, which may make it worth merging with rects
+	// checked before, so start over after every merge.
+	bool merged;
+	do {
+		merged = false;
+		for (int i = 0; i < _numDirtyRects; ++i) {
+			if (i != idx && dirtyRectMergeWaste(_dirtyRectList[i], _dirtyRectList[idx]) <= DIRTY_RECT_COST) {
+				idx = mergeDirtyRects(i, idx);
+				merged = true;
+				break;
+			}
+		}
+	} while (merged);
+
+	return idx;
+}
+
+void SurfaceSdlGraphicsManager::mergeCheapestDirtyRects() {
+	assert(_numDirtyRects >= 2);
+
+	int bestDst = 0, bestSrc = 1;
+	int bestWaste = -1;
+
+	for (int i = 0; i < _numDirtyRects; ++i) {
+		for (int j = i + 1; j < _numDirtyRects; ++j) {
+			const int waste = dirtyRectMergeWaste(_dirtyRectList[i], _dirtyRectList[j]);
+			if (bestWaste < 0 || waste < bestWaste) {
+				bestWaste = waste;
+				bestDst = i;
+				bestSrc = j;
+			}
+		}
+	}
+
+	coalesceDirtyRect(mergeDirtyRects(bestDst, bestSrc));
+}
+
+int SurfaceSdlGraphicsManager::mergeDirtyRects(int dst, int src) {
+	assert(dst != src);
+
+	SDL_Rect &d = _dirtyRectList[dst];
+	const SDL_Rect &s = _dirtyRectList[src];
+
+	const int right = MAX<int>(d.x + d.w, s.x + s.w);
+	const int bottom = MAX<int>(d.y + d.h, s.y + s.h);
+	d.x = MIN(d.x, s.x);
+	d.y = MIN(d.y, s.y);
+	d.w = right - d.x;
+	d.h = bottom - d.y;
+
+	_dirtyRectStats.mergedRects++;
+
+	// The order of the dirty rects does not matter, so simply move the
+	// last one into the slot of the removed rect.
+	_dirtyRectList[src] = _dirtyRectList[--_numDirtyRects];
+	return (dst == _numDirtyRects) ? src : dst;
+}
+
 int16 SurfaceSdlGraphicsManager::getHeight() {
 	return _videoMode.screenHeight;
 }
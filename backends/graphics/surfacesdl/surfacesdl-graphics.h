@@ -60,6 +60,8 @@ enum {
 };
 
 
+class SdlScalerPool;
+
 class AspectRatio {
 	int _kw, _kh;
 public:
@@ -240,6 +242,7 @@ protected:
 	bool _forceFull;
 
 	ScalerProc *_scalerProc;
+	SdlScalerPool *_scalerPool;
 	int _scalerType;
 	int _transactionMode;
 
@@ -253,13 +256,53 @@ protected:
 
 	enum {
 		NUM_DIRTY_RECT = 100,
-		MAX_SCALING = 3
+		MAX_SCALING = 3,
+
+		/**
+		 * Overhead of drawing a single dirty rect (blitting, scaler setup,
+		 * screen update), expressed in pixels. Two dirty rects are merged
+		 * when their bounding box wastes at most this many pixels.
+		 */
+		DIRTY_RECT_COST = 256
 	};
 
 	// Dirty rect management
 	SDL_Rect _dirtyRectList[NUM_DIRTY_RECT];
 	int _numDirtyRects;
 
+	/**
+	 * Statistics about the dirty rects of the current frame.
+	 */
+	struct DirtyRectStats {
+		/** Number of rects passed to addDirtyRect() */
+		uint32 addedRects;
+		/** Number of rects merged into another one */
+		uint32 mergedRects;
+		/** Number of merges forced by the dirty rect list being full */
+		uint32 forcedMerges;
+		/** Sum of the areas of all added rects */
+		uint32 addedArea;
+	};
+	DirtyRectStats _dirtyRectStats;
+
+	/**
+	 * Whether copyRectToScreen() compares the new data against the current
+	 * screen contents and skips rows which did not change.
+	 */
+	bool _skipUnchangedRows;
+
+	/**
+	 * Statistics about the data passed to copyRectToScreen() in the
+	 * current frame.
+	 */
+	struct ScreenCopyStats {
+		/** Number of pixels passed to copyRectToScreen() */
+		uint32 copiedPixels;
+		/** Number of those pixels in rows which actually changed */
+		uint32 changedPixels;
+	};
+	ScreenCopyStats _screenCopyStats;
+
 	struct MousePos {
 		// The mouse position, using either virtual (game) or real
 		// (overlay) coordinates.
@@ -328,12 +371,46 @@ protected:
 
 	virtual void addDirtyRect(int x, int y, int w, int h, bool realCoordinates = false);
 
+	/**
+	 * Copy a rect to the screen surface like copyRectToScreen(), but only
+	 * copy and mark dirty the rows which differ from the current contents.
+	 * The screen surface needs to be locked.
+	 */
+	void copyChangedRowsToScreen(const byte *src, int pitch, int x, int y, int w, int h);
+
+	/**
+	 * Merge the dirty rect at the given index with all dirty rects it is
+	 * worth merging with.
+	 *
+	 * @return the index of the resulting dirty rect
+	 */
+	int coalesceDirtyRect(int idx);
+
+	/**
+	 * Merge the pair of dirty rects whose bounding box wastes the fewest
+	 * pixels. Used to make room in a full dirty rect list.
+	 */
+	void mergeCheapestDirtyRects();
+
+	/**
+	 * Merge the dirty rect at index src into the one at index dst.
+	 *
+	 * @return the new index of the merged dirty rect
+	 */
+	int mergeDirtyRects(int dst, int src);
+
 	virtual void drawMouse();
 	virtual void undrawMouse();
 	virtual void blitCursor();
 
 	virtual void internUpdateScreen();
 
+	/**
+	 * Returns whether the given scaler may be run on multiple threads
+	 * at once.
+	 */
+	bool isScalerReentrant(ScalerProc *scalerProc) const;
+
 	virtual bool loadGFXMode();
 	virtual void unloadGFXMode();
 	virtual bool hotswapGFXMode();
@@ -0,0 +1,180 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "common/scummsys.h"
+
+#if defined(SDL_BACKEND)
+
+#include "backends/graphics/surfacesdl/surfacesdl-scalerpool.h"
+#include "common/textconsole.h"
+#include "common/util.h"
+
+enum {
+	/**
+	 * Jobs are not split into bands smaller than this (in source rows), to
+	 * keep the synchronization overhead low compared to the scaling work.
+	 */
+	kMinBandHeight = 16
+};
+
+SdlScalerPool::SdlScalerPool(uint numThreads)
+	: _mutex(0), _workCond(0), _doneCond(0),
+	  _numActiveJobs(0), _nextJob(0), _numFinishedJobs(0), _quit(false) {
+
+	if (!numThreads)
+		return;
+
+	_mutex = SDL_CreateMutex();
+	_workCond = SDL_CreateCond();
+	_doneCond = SDL_CreateCond();
+	if (!_mutex || !_workCond || !_doneCond) {
+		warning("SdlScalerPool: Could not create synchronization objects: %s", SDL_GetError());
+		return;
+	}
+
+	for (uint i = 0; i < numThreads; ++i) {
+#if SDL_VERSION_ATLEAST(2, 0, 0)
+		SDL_Thread *thread = SDL_CreateThread(workerThreadEntry, "ScummVM Scaler", this);
+#else
+		SDL_Thread *thread = SDL_CreateThread(workerThreadEntry, this);
+#endif
+		if (!thread) {
+			warning("SdlScalerPool: Could not create worker thread: %s", SDL_GetError());
+			break;
+		}
+		_threads.push_back(thread);
+	}
+}
+
+SdlScalerPool::~SdlScalerPool() {
+	if (!_threads.empty()) {
+		// Signal the workers to end, and wait for them to actually finish.
+		SDL_LockMutex(_mutex);
+		_quit = true;
+		SDL_CondBroadcast(_workCond);
+		SDL_UnlockMutex(_mutex);
+
+		for (uint i = 0; i < _threads.size(); ++i)
+			SDL_WaitThread(_threads[i], NULL);
+	}
+
+	if (_mutex)
+		SDL_DestroyMutex(_mutex);
+	if (_workCond)
+		SDL_DestroyCond(_workCond);
+	if (_doneCond)
+		SDL_DestroyCond(_doneCond);
+}
+
+void SdlScalerPool::addJob(ScalerProc *scaler, const uint8 *srcPtr, uint32 srcPitch,
+                           uint8 *dstPtr, uint32 dstPitch, int width, int height, int scaleFactor) {
+	assert(scaler);
+
+	// Split large jobs into one band per thread. The band height is kept a
+	// multiple of 4, so that scalers drawing row patterns (DotMatrix) stay
+	// aligned across bands.
+	int bandHeight = height;
+	const int numBands = _threads.size() + 1;
+	if (numBands > 1 && height >= 2 * kMinBandHeight) {
+		bandHeight = (height + numBands - 1) / numBands;
+		bandHeight = MAX<int>(kMinBandHeight, (bandHeight + 3) & ~3);
+	}
+
+	for (int y = 0; y < height; y += bandHeight) {
+		Job job;
+		job.scaler = scaler;
+		job.srcPtr = srcPtr + y * srcPitch;
+		job.srcPitch = srcPitch;
+		job.dstPtr = dstPtr + y * scaleFactor * dstPitch;
+		job.dstPitch = dstPitch;
+		job.width = width;
+		job.height = MIN(bandHeight, height - y);
+		_jobs.push_back(job);
+	}
+}
+
+void SdlScalerPool::run(bool concurrent) {
+	if (_threads.empty() || !concurrent || _jobs.size() < 2) {
+		for (uint i = 0; i < _jobs.size(); ++i)
+			_jobs[i].run();
+		_jobs.clear();
+		return;
+	}
+
+	SDL_LockMutex(_mutex);
+	_numActiveJobs = _jobs.size();
+	_nextJob = 0;
+	_numFinishedJobs = 0;
+	SDL_CondBroadcast(_workCond);
+
+	// Help out with the jobs instead of idling
+	processJobs();
+
+	while (_numFinishedJobs < _numActiveJobs)
+		SDL_CondWait(_doneCond, _mutex);
+
+	// The workers only look at the jobs while _nextJob < _numActiveJobs,
+	// hence the job list may be modified without holding the mutex again
+	// until the next run.
+	_numActiveJobs = 0;
+	_nextJob = 0;
+	SDL_UnlockMutex(_mutex);
+
+	_jobs.clear();
+}
+
+void SdlScalerPool::processJobs() {
+	while (_nextJob < _numActiveJobs) {
+		const Job &job = _jobs[_nextJob++];
+
+		SDL_UnlockMutex(_mutex);
+		job.run();
+		SDL_LockMutex(_mutex);
+
+		if (++_numFinishedJobs == _numActiveJobs)
+			SDL_CondSignal(_doneCond);
+	}
+}
+
+void SdlScalerPool::workerThread() {
+	SDL_LockMutex(_mutex);
+	while (true) {
+		// Wait till there is work to do
+		while (!_quit && _nextJob >= _numActiveJobs)
+			SDL_CondWait(_workCond, _mutex);
+
+		if (_quit)
+			break;
+
+		processJobs();
+	}
+	SDL_UnlockMutex(_mutex);
+}
+
+int SDLCALL SdlScalerPool::workerThreadEntry(void *arg) {
+	SdlScalerPool *pool = (SdlScalerPool *)arg;
+	assert(pool);
+	pool->workerThread();
+	return 0;
+}
+
+#endif
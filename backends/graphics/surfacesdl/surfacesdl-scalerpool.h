@@ -0,0 +1,121 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef BACKENDS_GRAPHICS_SURFACESDL_SCALERPOOL_H
+#define BACKENDS_GRAPHICS_SURFACESDL_SCALERPOOL_H
+
+#include "backends/platform/sdl/sdl-sys.h"
+#include "graphics/scaler.h"
+#include "common/array.h"
+
+/**
+ * Pool of worker threads running scaler procs for the SDL surface
+ * graphics manager.
+ *
+ * Scaler jobs are queued with addJob() and executed by run(), which
+ * distributes them over the worker threads and the calling thread and
+ * only returns once all of them have finished. Large jobs are split into
+ * horizontal bands, so that even a single full screen update is spread
+ * over all threads.
+ *
+ * Splitting is safe since the scalers only read from the source buffer,
+ * which is not modified while run() is active, and every band writes to
+ * its own range of destination rows. Filters which look at the rows
+ * around a pixel (2xSaI, HQ, AdvMame, ...) simply read the neighbouring
+ * band's source rows, exactly as they do for a single rectangle.
+ * Jobs which write to the same destination pixels must not run
+ * concurrently, so the caller has to pass concurrent = false to run() for
+ * them.
+ *
+ * A pool without worker threads runs all jobs on the calling thread.
+ */
+class SdlScalerPool {
+public:
+	/**
+	 * Create a pool.
+	 *
+	 * @param numThreads	number of worker threads to start in addition
+	 *						to the thread calling run()
+	 */
+	SdlScalerPool(uint numThreads);
+	~SdlScalerPool();
+
+	/**
+	 * Returns the number of worker threads of the pool.
+	 */
+	uint getNumThreads() const { return _threads.size(); }
+
+	/**
+	 * Queue a scaler job. The parameters are the same as the ones of the
+	 * scaler proc, plus the scale factor needed to split up the job.
+	 */
+	void addJob(ScalerProc *scaler, const uint8 *srcPtr, uint32 srcPitch,
+	            uint8 *dstPtr, uint32 dstPitch, int width, int height, int scaleFactor);
+
+	/**
+	 * Run all queued jobs and wait for them to finish.
+	 *
+	 * @param concurrent	whether the jobs may run concurrently. This
+	 *						should be false for scalers which are not
+	 *						reentrant.
+	 */
+	void run(bool concurrent = true);
+
+private:
+	struct Job {
+		ScalerProc *scaler;
+		const uint8 *srcPtr;
+		uint32 srcPitch;
+		uint8 *dstPtr;
+		uint32 dstPitch;
+		int width;
+		int height;
+
+		void run() const { scaler(srcPtr, srcPitch, dstPtr, dstPitch, width, height); }
+	};
+
+	Common::Array<Job> _jobs;
+	Common::Array<SDL_Thread *> _threads;
+
+	SDL_mutex *_mutex;
+	SDL_cond *_workCond;
+	SDL_cond *_doneCond;
+
+	/** Number of jobs handed to the workers by the current run() call. */
+	uint _numActiveJobs;
+	/** Index of the next job to pick up. */
+	uint _nextJob;
+	/** Number of jobs which have been finished. */
+	uint _numFinishedJobs;
+	bool _quit;
+
+	/**
+	 * Pick up and execute jobs until none are left. Needs to be called with
+	 * the mutex locked.
+	 */
+	void processJobs();
+
+	void workerThread();
+	static int SDLCALL workerThreadEntry(void *arg);
+};
+
+#endif
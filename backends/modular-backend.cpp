@@ -143,6 +143,7 @@ void ModularBackend::fillScreen(uint32 col) {
 
 void ModularBackend::updateScreen() {
 #ifdef ENABLE_EVENTRECORDER
+	g_eventRec.processUpdateScreen();
 	g_eventRec.preDrawOverlayGui();
 #endif
 
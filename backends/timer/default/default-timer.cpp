@@ -31,81 +31,120 @@ struct TimerSlot {
 	Common::String id;
 	uint32 interval;	// in microseconds
 
-	uint32 nextFireTime;	// in milliseconds
-	uint32 nextFireTimeMicro;	// microseconds part of nextFire
+	// The fire times are advanced by the interval, rather than computed from
+	// the time the callback was invoked, so rounding and late invocations
+	// don't accumulate.
+	uint64 nextFireTime;	// in microseconds
 
-	TimerSlot *next;
-};
-
-void insertPrioQueue(TimerSlot *head, TimerSlot *newSlot) {
-	// The head points to a fake anchor TimerSlot; this common
-	// trick allows us to get rid of many special cases.
+	uint heapIndex;
 
-	const uint32 nextFireTime = newSlot->nextFireTime;
-	TimerSlot *slot = head;
-	newSlot->next = 0;
+	uint32 calls;
+	uint32 lateCalls;
+	uint32 slowCalls;
 
-	// Insert the new slot into the sorted list of already scheduled
-	// timers in such a way that the list stays sorted...
-	while (true) {
-		assert(slot);
-		if (slot->next == 0 || nextFireTime < slot->next->nextFireTime) {
-			newSlot->next = slot->next;
-			slot->next = newSlot;
-			return;
-		}
-		slot = slot->next;
-	}
-}
+	// The run times are measured with the millisecond timer, so most
+	// callbacks take 0ms. slowCalls counts the ones which don't.
+	uint32 totalTime;	// in milliseconds
+	uint32 maxTime;	// in milliseconds
+};
 
 
 DefaultTimerManager::DefaultTimerManager() :
-	_head(0) {
-
-	_head = new TimerSlot();
-	memset(_head, 0, sizeof(TimerSlot));
+	_runningSlot(0) {
 }
 
 DefaultTimerManager::~DefaultTimerManager() {
 	Common::StackLock lock(_mutex);
 
-	TimerSlot *slot = _head;
-	while (slot) {
-		TimerSlot *next = slot->next;
-		delete slot;
-		slot = next;
+	for (uint i = 0; i < _heap.size(); i++)
+		delete _heap[i];
+	_heap.clear();
+}
+
+void DefaultTimerManager::siftUp(uint index) {
+	TimerSlot *slot = _heap[index];
+
+	while (index > 0) {
+		const uint parent = (index - 1) / 2;
+		if (_heap[parent]->nextFireTime <= slot->nextFireTime)
+			break;
+		_heap[index] = _heap[parent];
+		_heap[index]->heapIndex = index;
+		index = parent;
+	}
+	_heap[index] = slot;
+	slot->heapIndex = index;
+}
+
+void DefaultTimerManager::siftDown(uint index) {
+	TimerSlot *slot = _heap[index];
+	const uint size = _heap.size();
+
+	while (true) {
+		uint child = 2 * index + 1;
+		if (child >= size)
+			break;
+		if (child + 1 < size && _heap[child + 1]->nextFireTime < _heap[child]->nextFireTime)
+			child++;
+		if (slot->nextFireTime <= _heap[child]->nextFireTime)
+			break;
+		_heap[index] = _heap[child];
+		_heap[index]->heapIndex = index;
+		index = child;
 	}
-	_head = 0;
+	_heap[index] = slot;
+	slot->heapIndex = index;
+}
+
+void DefaultTimerManager::removeFromHeap(uint index) {
+	TimerSlot *last = _heap.back();
+	_heap.pop_back();
+	if (index == _heap.size())
+		return;
+
+	// Move the last timer into the gap, and restore the heap order from there
+	_heap[index] = last;
+	last->heapIndex = index;
+	if (index > 0 && last->nextFireTime < _heap[(index - 1) / 2]->nextFireTime)
+		siftUp(index);
+	else
+		siftDown(index);
 }
 
 void DefaultTimerManager::handler() {
 	Common::StackLock lock(_mutex);
 
-	uint32 curTime = g_system->getMillis(true);
+	const uint64 curTime = (uint64)g_system->getMillis(true) * 1000;
 
 	// Repeat as long as there is a TimerSlot that is scheduled to fire.
-	TimerSlot *slot = _head->next;
-	while (slot && slot->nextFireTime < curTime) {
-		// Remove the slot from the priority queue
-		_head->next = slot->next;
+	while (!_heap.empty() && _heap[0]->nextFireTime < curTime) {
+		TimerSlot *slot = _heap[0];
 
-		// Update the fire time and reinsert the TimerSlot into the priority
-		// queue.
+		// Update the fire time and move the TimerSlot to its new position in
+		// the heap. If the timer is behind by more than one interval, it
+		// is invoked repeatedly to catch up.
 		assert(slot->interval > 0);
-		slot->nextFireTime += (slot->interval / 1000);
-		slot->nextFireTimeMicro += (slot->interval % 1000);
-		if (slot->nextFireTimeMicro > 1000) {
-			slot->nextFireTime += slot->nextFireTimeMicro / 1000;
-			slot->nextFireTimeMicro %= 1000;
-		}
-		insertPrioQueue(_head, slot);
+		slot->nextFireTime += slot->interval;
+		if (slot->nextFireTime < curTime)
+			slot->lateCalls++;
+		siftDown(0);
 
 		// Invoke the timer callback
 		assert(slot->callback);
+		_runningSlot = slot;
+		const uint32 startTime = g_system->getMillis(true);
 		slot->callback(slot->refCon);
-
-		// Look at the next scheduled timer
-		slot = _head->next;
+		const uint32 time = g_system->getMillis(true) - startTime;
+
+		// The callback may have removed its own timer
+		if (_runningSlot) {
+			slot->calls++;
+			if (time > 0)
+				slot->slowCalls++;
+			slot->totalTime += time;
+			slot->maxTime = MAX(slot->maxTime, time);
+		}
+		_runningSlot = 0;
 	}
 }
 
@@ -132,11 +171,15 @@ bool DefaultTimerManager::installTimerProc(TimerProc callback, int32 interval, v
 	slot->refCon = refCon;
 	slot->id = id;
 	slot->interval = interval;
-	slot->nextFireTime = g_system->getMillis() + interval / 1000;
-	slot->nextFireTimeMicro = interval % 1000;
-	slot->next = 0;
+	slot->nextFireTime = (uint64)g_system->getMillis() * 1000 + interval;
+	slot->calls = 0;
+	slot->lateCalls = 0;
+	slot->slowCalls = 0;
+	slot->totalTime = 0;
+	slot->maxTime = 0;
 
-	insertPrioQueue(_head, slot);
+	_heap.push_back(slot);
+	siftUp(_heap.size() - 1);
 
 	return true;
 }
@@ -144,15 +187,15 @@ bool DefaultTimerManager::installTimerProc(TimerProc callback, int32 interval, v
 void DefaultTimerManager::removeTimerProc(TimerProc callback) {
 	Common::StackLock lock(_mutex);
 
-	TimerSlot *slot = _head;
-
-	while (slot->next) {
-		if (slot->next->callback == callback) {
-			TimerSlot *next = slot->next->next;
-			delete slot->next;
-			slot->next = next;
-		} else {
-			slot = slot->next;
+	// installTimerProc makes sure that a callback is installed only once
+	for (uint i = 0; i < _heap.size(); i++) {
+		TimerSlot *slot = _heap[i];
+		if (slot->callback == callback) {
+			if (slot == _runningSlot)
+				_runningSlot = 0;
+			removeFromHeap(i);
+			delete slot;
+			break;
 		}
 	}
 
@@ -173,3 +216,34 @@ void DefaultTimerManager::removeTimerProc(TimerProc callback) {
 			_callbacks.erase(i);
 	}
 }
+
+bool DefaultTimerManager::getTimerStats(TimerStatsList &stats) {
+	Common::StackLock lock(_mutex);
+
+	for (uint i = 0; i < _heap.size(); i++) {
+		const TimerSlot *slot = _heap[i];
+		TimerStats timerStats;
+		timerStats.id = slot->id;
+		timerStats.interval = slot->interval;
+		timerStats.calls = slot->calls;
+		timerStats.lateCalls = slot->lateCalls;
+		timerStats.slowCalls = slot->slowCalls;
+		timerStats.totalTime = slot->totalTime;
+		timerStats.maxTime = slot->maxTime;
+		stats.push_back(timerStats);
+	}
+	return true;
+}
+
+void DefaultTimerManager::resetTimerStats() {
+	Common::StackLock lock(_mutex);
+
+	for (uint i = 0; i < _heap.size(); i++) {
+		TimerSlot *slot = _heap[i];
+		slot->calls = 0;
+		slot->lateCalls = 0;
+		slot->slowCalls = 0;
+		slot->totalTime = 0;
+		slot->maxTime = 0;
+	}
+}
@@ -23,6 +23,7 @@
 #ifndef BACKENDS_TIMER_DEFAULT_H
 #define BACKENDS_TIMER_DEFAULT_H
 
+#include "common/array.h"
 #include "common/str.h"
 #include "common/hash-str.h"
 #include "common/timer.h"
@@ -35,14 +36,23 @@ private:
 	typedef Common::HashMap<Common::String, TimerProc, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> TimerSlotMap;
 
 	Common::Mutex _mutex;
-	TimerSlot *_head;
+	/** Binary min-heap of the installed timers, ordered by their next fire time */
+	Common::Array<TimerSlot *> _heap;
 	TimerSlotMap _callbacks;
+	/** The timer whose callback is currently invoked, if it has not been removed since */
+	TimerSlot *_runningSlot;
+
+	void siftUp(uint index);
+	void siftDown(uint index);
+	void removeFromHeap(uint index);
 
 public:
 	DefaultTimerManager();
 	virtual ~DefaultTimerManager();
 	virtual bool installTimerProc(TimerProc proc, int32 interval, void *refCon, const Common::String &id);
 	virtual void removeTimerProc(TimerProc proc);
+	virtual bool getTimerStats(TimerStatsList &stats);
+	virtual void resetTimerStats();
 
 	/**
 	 * Timer callback, to be invoked at regular time intervals by the backend.
@@ -27,6 +27,7 @@
 
 #include <limits.h>
 
+#include "engines/detectioncache.h"
 #include "engines/metaengine.h"
 #include "base/commandLine.h"
 #include "base/plugins.h"
@@ -39,6 +40,8 @@
 #include "common/textconsole.h"
 
 #include "gui/ThemeEngine.h"
+#include "gui/launcher.h"	// For addGameToConf()
+#include "gui/massadd.h"
 
 #include "audio/musicplugin.h"
 
@@ -68,6 +71,13 @@ static const char HELP_STRING[] =
 	"  -z, --list-games         Display list of supported games and exit\n"
 	"  -t, --list-targets       Display list of configured targets and exit\n"
 	"  --list-saves=TARGET      Display a list of saved games for the game (TARGET) specified\n"
+#ifndef DISABLE_MASS_ADD
+	"  --detect                 Display a list of games found in the directory\n"
+	"                           given by --path (default: current directory)\n"
+	"  --add                    Add all games found in the directory given by\n"
+	"                           --path to the config file\n"
+	"  --recursive              Make --detect and --add look in subdirectories, too\n"
+#endif
 #if defined(WIN32) && !defined(_WIN32_WCE) && !defined(__SYMBIAN32__)
 	"  --console                Enable the console window (default:enabled)\n"
 #endif
@@ -120,7 +130,7 @@ static const char HELP_STRING[] =
 	"                           hercAmber, amiga)\n"
 #ifdef ENABLE_EVENTRECORDER
 	"  --record-mode=MODE       Specify record mode for event recorder (record, playback,\n"
-	"                           passthrough [default])\n"
+	"                           benchmark, passthrough [default])\n"
 	"  --record-file-name=FILE  Specify record file name\n"
 	"  --disable-display        Disable any gfx output. Used for headless events\n"
 	"                           playback by Event Recorder\n"
@@ -345,6 +355,7 @@ void registerDefaults() {
 
 Common::String parseCommandLine(Common::StringMap &settings, int argc, const char * const *argv) {
 	const char *s, *s2;
+	Common::String command;
 
 	if (!argv)
 		return Common::String();
@@ -387,6 +398,18 @@ Common::String parseCommandLine(Common::StringMap &settings, int argc, const cha
 			DO_COMMAND('z', "list-games")
 			END_COMMAND
 
+#ifndef DISABLE_MASS_ADD
+			// Unlike the other commands, these do not end the parsing, since
+			// they depend on options like --path which may follow them.
+			if (!strcmp(s, "--detect") || !strcmp(s, "--add")) {
+				command = s + 2;
+				continue;
+			}
+
+			DO_LONG_OPTION_BOOL("recursive")
+			END_OPTION
+#endif
+
 #ifdef DETECTOR_TESTING_HACK
 			// HACK FIXME TODO: This command is intentionally *not* documented!
 			DO_LONG_COMMAND("test-detector")
@@ -604,7 +627,7 @@ unknownOption:
 		}
 	}
 
-	return Common::String();
+	return command;
 }
 
 /** List all supported game IDs, i.e. all games which any loaded plugin supports. */
@@ -612,12 +635,9 @@ static void listGames() {
 	printf("Game ID              Full Title                                            \n"
 	       "-------------------- ------------------------------------------------------\n");
 
-	const EnginePlugin::List &plugins = EngineMan.getPlugins();
-	for (EnginePlugin::List::const_iterator iter = plugins.begin(); iter != plugins.end(); ++iter) {
-		GameList list = (**iter)->getSupportedGames();
-		for (GameList::iterator v = list.begin(); v != list.end(); ++v) {
-			printf("%-20s %s\n", v->gameid().c_str(), v->description().c_str());
-		}
+	GameList list = EngineMan.getSupportedGames();
+	for (GameList::iterator v = list.begin(); v != list.end(); ++v) {
+		printf("%-20s %s\n", v->gameid().c_str(), v->description().c_str());
 	}
 }
 
@@ -717,6 +737,52 @@ static Common::Error listSaves(const char *target) {
 	return result;
 }
 
+#ifndef DISABLE_MASS_ADD
+/**
+ * Scan the directory given by the "path" setting for games, and optionally
+ * add them to the config file. Games which are already configured are
+ * skipped.
+ */
+static void scanGames(const Common::StringMap &settings, bool addGames) {
+	Common::FSNode dir(settings.contains("path") ? settings["path"] : ".");
+	const bool recursive = settings.contains("recursive") && settings["recursive"] == "true";
+
+	if (!dir.isDirectory()) {
+		usage("'%s' is not a directory", dir.getPath().c_str());
+	}
+
+	GUI::MassAddScanner scanner(dir, recursive);
+	while (scanner.scanNextDirectory())
+		;
+
+	const GameList &games = scanner.getGames();
+
+	if (!addGames) {
+		printf("Game ID              Description                                           Path\n"
+		       "-------------------- ----------------------------------------------------- ----\n");
+	}
+
+	for (GameList::const_iterator game = games.begin(); game != games.end(); ++game) {
+		if (addGames) {
+			Common::String target = GUI::addGameToConf(*game);
+			printf("Added target '%s' for '%s' in '%s'\n", target.c_str(), game->description().c_str(), (*game)["path"].c_str());
+		} else {
+			printf("%-20s %-53s %s\n", game->gameid().c_str(), game->description().c_str(), (*game)["path"].c_str());
+		}
+	}
+
+	printf("Scanned %d directories, found %d new games, ignored %d previously added games.\n",
+	       scanner.getDirsScanned(), games.size(), scanner.getOldGamesCount());
+
+	if (addGames && !games.empty())
+		ConfMan.flushToDisk();
+
+	// The cache is not written on exit, as the command line options make
+	// ScummVM quit before the detection cache is destroyed
+	DetectionCacheMan.flush(true);
+}
+#endif
+
 /** Lists all usable themes */
 static void listThemes() {
 	typedef Common::List<GUI::ThemeEngine::ThemeDescriptor> ThList;
@@ -964,6 +1030,14 @@ bool processSettings(Common::String &command, Common::StringMap &settings, Commo
 	} else if (command == "list-audio-devices") {
 		listAudioDevices();
 		return true;
+#ifndef DISABLE_MASS_ADD
+	} else if (command == "detect") {
+		scanGames(settings, false);
+		return true;
+	} else if (command == "add") {
+		scanGames(settings, true);
+		return true;
+#endif
 	} else if (command == "version") {
 		printf("%s\n", gScummVMFullVersion);
 		printf("Features compiled in: %s\n", gScummVMFeatures);
@@ -33,6 +33,7 @@
 
 #include "engines/engine.h"
 #include "engines/metaengine.h"
+#include "engines/detectioncache.h"
 #include "base/commandLine.h"
 #include "base/plugins.h"
 #include "base/version.h"
@@ -127,8 +128,19 @@ static const EnginePlugin *detectPlugin() {
 	return plugin;
 }
 
+/** Print how much filesystem access the game took since it was started. */
+static void printFilesystemStats(const char *stage) {
+	const Common::FSNode::Stats &stats = Common::FSNode::getStats();
+	debug(1, "%s: %u filesystem operations (%u lookups, %u directory listings, %u file infos, %u opens)",
+		stage, stats.getTotal(), stats.lookups, stats.listings, stats.fileInfos, stats.opens);
+	SearchMan.printIndexStats(1);
+}
+
 // TODO: specify the possible return values here
 static Common::Error runGame(const EnginePlugin *plugin, OSystem &system, const Common::String &edebuglevels) {
+	Common::FSNode::resetStats();
+	SearchMan.resetIndexStats();
+
 	// Determine the game data path, for validation and error messages
 	Common::FSNode dir(ConfMan.get("path"));
 	Common::Error err = Common::kNoError;
@@ -240,9 +252,13 @@ static Common::Error runGame(const EnginePlugin *plugin, OSystem &system, const
 	// Inform backend that the engine is about to be run
 	system.engineInit();
 
+	printFilesystemStats("Engine setup");
+
 	// Run the engine
 	Common::Error result = engine->run();
 
+	printFilesystemStats("Game session");
+
 	// Inform backend that the engine finished
 	system.engineDone();
 
@@ -478,6 +494,8 @@ extern "C" int scummvm_main(int argc, const char * const argv[]) {
 				g_eventRec.init(g_eventRec.generateRecordFileName(ConfMan.getActiveDomainName()), GUI::EventRecorder::kRecorderRecord);
 			} else if (recordMode == "playback") {
 				g_eventRec.init(recordFileName, GUI::EventRecorder::kRecorderPlayback);
+			} else if (recordMode == "benchmark") {
+				g_eventRec.init(recordFileName, GUI::EventRecorder::kRecorderPlayback, true);
 			} else if ((recordMode == "info") && (!recordFileName.empty())) {
 				Common::PlaybackFile record;
 				record.openRead(recordFileName);
@@ -563,6 +581,7 @@ extern "C" int scummvm_main(int argc, const char * const argv[]) {
 			launcherDialog();
 		}
 	}
+	DetectionCache::destroy();
 	PluginManager::instance().unloadAllPlugins();
 	PluginManager::destroy();
 	GUI::GuiManager::destroy();
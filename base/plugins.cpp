@@ -25,6 +25,7 @@
 #include "common/func.h"
 #include "common/debug.h"
 #include "common/config-manager.h"
+#include "common/file.h"
 
 #ifdef DYNAMIC_MODULES
 #include "common/fs.h"
@@ -282,11 +283,13 @@ void PluginManagerUncached::init() {
 			}
  		}
  	}
+
+	updatePluginIndex();
 }
 
 /**
  * Try to load the plugin by searching in the ConfigManager for a matching
- * gameId under the domain 'plugin_files'.
+ * gameId under the domain 'plugin_files', and then in the plugin index.
  **/
 bool PluginManagerUncached::loadPluginFromGameId(const Common::String &gameId) {
 	Common::ConfigManager::Domain *domain = ConfMan.getDomain("plugin_files");
@@ -300,6 +303,12 @@ bool PluginManagerUncached::loadPluginFromGameId(const Common::String &gameId) {
 			}
 		}
 	}
+
+	// Fall back to the plugin index
+	GameIndex::const_iterator i = _gameIndex.find(gameId);
+	if (i != _gameIndex.end())
+		return loadPluginByFileName(i->_value);
+
 	return false;
 }
 
@@ -445,6 +454,7 @@ void PluginManager::addToPluginsInMemList(Plugin *plugin) {
 // Engine plugins
 
 #include "engines/metaengine.h"
+#include "engines/detectioncache.h"
 
 namespace Common {
 DECLARE_SINGLETON(EngineManager);
@@ -527,14 +537,205 @@ GameList EngineManager::detectGames(const Common::FSList &fslist) const {
 			candidates.push_back((**iter)->detectGames(fslist));
 		}
 	} while (PluginManager::instance().loadNextPlugin());
+
+	DetectionCacheMan.flush();
 	return candidates;
 }
 
+GameList EngineManager::getSupportedGames() const {
+	GameList games;
+	if (PluginManager::instance().getIndexedGames(games))
+		return games;
+
+	EnginePlugin::List plugins;
+	EnginePlugin::List::const_iterator iter;
+	PluginManager::instance().loadFirstPlugin();
+	do {
+		plugins = getPlugins();
+		for (iter = plugins.begin(); iter != plugins.end(); ++iter) {
+			games.push_back((**iter)->getSupportedGames());
+		}
+	} while (PluginManager::instance().loadNextPlugin());
+
+	return games;
+}
+
 const EnginePlugin::List &EngineManager::getPlugins() const {
 	return (const EnginePlugin::List &)PluginManager::instance().getPlugins(PLUGIN_TYPE_ENGINE);
 }
 
 
+// Engine plugin index
+
+/** Name of the plugin index file, which is stored next to the config file. */
+static const char *const kPluginIndexFileName = "scummvm-plugins.index";
+
+/** First line of the plugin index, to be changed if the format changes. */
+static const char *const kPluginIndexHeader = "ScummVM plugin index 1";
+
+bool PluginManagerUncached::loadPluginIndex(const Common::FSNode &indexFile) {
+	if (!indexFile.exists())
+		return false;
+
+	Common::File file;
+	if (!file.open(indexFile))
+		return false;
+
+	if (file.readLine() != kPluginIndexHeader) {
+		debug(1, "Ignoring plugin index of unknown format");
+		return false;
+	}
+
+	// Every plugin file is described by a line of the format "plugin size
+	// modificationTime engineName fileName", followed by a line "game
+	// gameId description" for every game it supports. All fields are
+	// separated by tabs.
+	PluginMetadata *plugin = 0;
+	while (!file.eos() && !file.err()) {
+		Common::String line = file.readLine();
+		if (line.empty())
+			continue;
+
+		if (line.hasPrefix("plugin\t")) {
+			uint size, modificationTime;
+			int nameStart = 0;
+			if (sscanf(line.c_str(), "plugin\t%u\t%u\t%n", &size, &modificationTime, &nameStart) != 2 || !nameStart) {
+				plugin = 0;
+				continue;
+			}
+
+			const char *engineName = line.c_str() + nameStart;
+			const char *fileName = strchr(engineName, '\t');
+			if (!fileName) {
+				plugin = 0;
+				continue;
+			}
+
+			plugin = &_pluginIndex[fileName + 1];
+			plugin->size = size;
+			plugin->modificationTime = modificationTime;
+			plugin->engineName = Common::String(engineName, fileName);
+			plugin->games.clear();
+		} else if (line.hasPrefix("game\t") && plugin) {
+			const char *gameId = line.c_str() + 5;
+			const char *description = strchr(gameId, '\t');
+			if (description)
+				plugin->games.push_back(GameDescriptor(Common::String(gameId, description), description + 1));
+		}
+	}
+
+	debug(1, "Read %u entries from the plugin index", _pluginIndex.size());
+	return true;
+}
+
+void PluginManagerUncached::savePluginIndex(const Common::FSNode &indexFile) const {
+	Common::WriteStream *stream = indexFile.createWriteStream();
+	if (!stream) {
+		warning("Could not write the plugin index to '%s'", indexFile.getPath().c_str());
+		return;
+	}
+
+	stream->writeString(kPluginIndexHeader);
+	stream->writeByte('\n');
+
+	for (PluginIndex::const_iterator i = _pluginIndex.begin(); i != _pluginIndex.end(); ++i) {
+		const PluginMetadata &plugin = i->_value;
+		stream->writeString(Common::String::format("plugin\t%u\t%u\t%s\t%s\n",
+			plugin.size, plugin.modificationTime, plugin.engineName.c_str(), i->_key.c_str()));
+
+		for (GameList::const_iterator g = plugin.games.begin(); g != plugin.games.end(); ++g)
+			stream->writeString(Common::String::format("game\t%s\t%s\n", g->gameid().c_str(), g->description().c_str()));
+	}
+
+	stream->finalize();
+	delete stream;
+}
+
+/**
+ * Make sure the plugin index describes exactly the engine plugin files
+ * found by init(). Only plugins which are new or changed since the index
+ * was written have to be loaded for this, so usually none at all.
+ **/
+void PluginManagerUncached::updatePluginIndex() {
+	_pluginIndex.clear();
+	_gameIndex.clear();
+
+	const Common::FSNode indexFile = ConfMan.getFileNextToConfig(kPluginIndexFileName);
+	bool dirty = !loadPluginIndex(indexFile);
+
+	PluginIndex currentIndex;
+	for (PluginList::iterator p = _allEnginePlugins.begin(); p != _allEnginePlugins.end(); ++p) {
+		// Static plugins do not need to be loaded anyway
+		if (!(*p)->getFileName())
+			continue;
+
+		const Common::String fileName = (*p)->getFileName();
+		const Common::FSNode node(fileName);
+		uint32 size, modificationTime;
+		if (!node.getFileInfo(size, modificationTime)) {
+			// Not all filesystem backends report the modification time. Use
+			// the size alone then, which means a plugin replaced by one of
+			// the same size is not added to the index again.
+			Common::File file;
+			if (!file.open(node))
+				continue;
+			size = file.size();
+			modificationTime = 0;
+		}
+
+		PluginIndex::const_iterator i = _pluginIndex.find(fileName);
+		if (i != _pluginIndex.end() && i->_value.size == size && i->_value.modificationTime == modificationTime) {
+			currentIndex[fileName] = i->_value;
+			continue;
+		}
+
+		dirty = true;
+		if (!(*p)->loadPlugin())
+			continue;
+
+		debug(1, "Adding plugin '%s' to the plugin index", fileName.c_str());
+
+		PluginMetadata &plugin = currentIndex[fileName];
+		plugin.size = size;
+		plugin.modificationTime = modificationTime;
+		plugin.engineName = (*p)->getName();
+		plugin.games = (*(EnginePlugin *)*p)->getSupportedGames();
+
+		(*p)->unloadPlugin();
+	}
+
+	// Drop the entries of plugin files which are gone
+	if (currentIndex.size() != _pluginIndex.size())
+		dirty = true;
+	_pluginIndex = currentIndex;
+
+	for (PluginIndex::const_iterator i = _pluginIndex.begin(); i != _pluginIndex.end(); ++i) {
+		for (GameList::const_iterator g = i->_value.games.begin(); g != i->_value.games.end(); ++g)
+			_gameIndex[g->gameid()] = i->_key;
+	}
+
+	if (dirty)
+		savePluginIndex(indexFile);
+}
+
+/**
+ * Retrieve the games of all engine plugins from the plugin index. Only
+ * succeeds if all engine plugins are in the index, which is not the case
+ * when static engine plugins are present.
+ **/
+bool PluginManagerUncached::getIndexedGames(GameList &games) const {
+	for (PluginList::const_iterator p = _allEnginePlugins.begin(); p != _allEnginePlugins.end(); ++p) {
+		if (!(*p)->getFileName() || !_pluginIndex.contains((*p)->getFileName()))
+			return false;
+	}
+
+	for (PluginList::const_iterator p = _allEnginePlugins.begin(); p != _allEnginePlugins.end(); ++p)
+		games.push_back(_pluginIndex[(*p)->getFileName()].games);
+
+	return true;
+}
+
+
 // Music plugins
 
 #include "audio/musicplugin.h"
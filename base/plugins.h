@@ -25,8 +25,10 @@
 
 #include "common/array.h"
 #include "common/fs.h"
+#include "common/hash-str.h"
 #include "common/str.h"
 #include "backends/plugins/elf/version.h"
+#include "engines/game.h"
 
 
 /**
@@ -332,6 +334,7 @@ public:
 	virtual bool loadNextPlugin() { return false; }
 	virtual bool loadPluginFromGameId(const Common::String &gameId) { return false; }
 	virtual void updateConfigWithFileName(const Common::String &gameId) {}
+	virtual bool getIndexedGames(GameList &games) const { return false; }
 
 	// Functions used only by the cached PluginManager
 	virtual void loadAllPlugins();
@@ -352,15 +355,46 @@ protected:
 	PluginList _allEnginePlugins;
 	PluginList::iterator _currentPlugin;
 
+	/**
+	 * Metadata of an engine plugin file, stored in the plugin index so
+	 * that the plugin does not have to be loaded to retrieve it.
+	 *
+	 * Only the uncached plugin manager keeps an index. The cached one
+	 * loads all plugins on startup and keeps them in memory anyway.
+	 */
+	struct PluginMetadata {
+		uint32 size;
+		uint32 modificationTime;
+		Common::String engineName;
+		GameList games;
+	};
+
+	typedef Common::HashMap<Common::String, PluginMetadata> PluginIndex;
+	typedef Common::HashMap<Common::String, Common::String, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> GameIndex;
+
+	/** Metadata of all engine plugin files, by file name. */
+	PluginIndex _pluginIndex;
+	/** File names of the engine plugins, by the ids of their games. */
+	GameIndex _gameIndex;
+
 	PluginManagerUncached() {}
 	bool loadPluginByFileName(const Common::String &filename);
 
+	/**
+	 * Read the plugin index from disk, add the metadata of new or changed
+	 * plugin files to it and write it back if anything changed.
+	 */
+	void updatePluginIndex();
+	bool loadPluginIndex(const Common::FSNode &indexFile);
+	void savePluginIndex(const Common::FSNode &indexFile) const;
+
 public:
 	virtual void init();
 	virtual void loadFirstPlugin();
 	virtual bool loadNextPlugin();
 	virtual bool loadPluginFromGameId(const Common::String &gameId);
 	virtual void updateConfigWithFileName(const Common::String &gameId);
+	virtual bool getIndexedGames(GameList &games) const;
 
 	virtual void loadAllPlugins() {} 	// we don't allow this
 };
@@ -21,6 +21,7 @@
  */
 
 #include "common/archive.h"
+#include "common/debug.h"
 #include "common/fs.h"
 #include "common/system.h"
 #include "common/textconsole.h"
@@ -62,6 +63,10 @@ int Archive::listMatchingMembers(ArchiveMemberList &list, const String &pattern)
 
 
 
+SearchSet::SearchSet()
+	: _indexValid(false), _indexLookups(0), _indexHits(0), _indexRebuilds(0), _probes(0) {
+}
+
 SearchSet::ArchiveNodeList::iterator SearchSet::find(const String &name) {
 	ArchiveNodeList::iterator it = _list.begin();
 	for ( ; it != _list.end(); ++it) {
@@ -92,6 +97,7 @@ void SearchSet::insert(const Node &node) {
 			break;
 	}
 	_list.insert(it, node);
+	invalidateIndex();
 }
 
 void SearchSet::add(const String &name, Archive *archive, int priority, bool autoFree) {
@@ -174,6 +180,7 @@ void SearchSet::remove(const String &name) {
 		if (it->_autoFree)
 			delete it->_arc;
 		_list.erase(it);
+		invalidateIndex();
 	}
 }
 
@@ -188,6 +195,7 @@ void SearchSet::clear() {
 	}
 
 	_list.clear();
+	invalidateIndex();
 }
 
 void SearchSet::setPriority(const String &name, int priority) {
@@ -206,17 +214,76 @@ void SearchSet::setPriority(const String &name, int priority) {
 	insert(node);
 }
 
+void SearchSet::updateIndex() const {
+	if (_indexValid)
+		return;
+
+	_fileIndex.clear(true);
+	_archives.clear();
+	_unindexed.clear();
+
+	StringArray names;
+	for (ArchiveNodeList::const_iterator it = _list.begin(); it != _list.end(); ++it) {
+		const uint pos = _archives.size();
+		_archives.push_back(it->_arc);
+
+		names.clear();
+		if (!it->_arc->listMemberNames(names)) {
+			_unindexed.push_back(pos);
+			continue;
+		}
+
+		// Archives with a higher priority come first, so their files win
+		for (StringArray::const_iterator name = names.begin(); name != names.end(); ++name) {
+			if (!_fileIndex.contains(*name))
+				_fileIndex[*name] = pos;
+		}
+	}
+
+	_indexValid = true;
+	_indexRebuilds++;
+}
+
+uint SearchSet::lookupIndex(const String &name) const {
+	updateIndex();
+	_indexLookups++;
+
+	FileIndex::const_iterator i = _fileIndex.find(name);
+	if (i == _fileIndex.end())
+		return _archives.size();
+
+	_indexHits++;
+	return i->_value;
+}
+
+Archive *SearchSet::findArchive(const String &name) const {
+	const uint indexed = lookupIndex(name);
+
+	// Archives without index with a higher priority are searched first
+	for (uint i = 0; i < _unindexed.size() && _unindexed[i] < indexed; ++i) {
+		Archive *archive = _archives[_unindexed[i]];
+		_probes++;
+		if (archive->hasFile(name))
+			return archive;
+	}
+
+	// The index only records which files existed when it was built, so
+	// in case the file is gone, fall back to searching the remaining
+	// archives in order.
+	for (uint i = indexed; i < _archives.size(); ++i) {
+		_probes++;
+		if (_archives[i]->hasFile(name))
+			return _archives[i];
+	}
+
+	return 0;
+}
+
 bool SearchSet::hasFile(const String &name) const {
 	if (name.empty())
 		return false;
 
-	ArchiveNodeList::const_iterator it = _list.begin();
-	for ( ; it != _list.end(); ++it) {
-		if (it->_arc->hasFile(name))
-			return true;
-	}
-
-	return false;
+	return findArchive(name) != 0;
 }
 
 int SearchSet::listMatchingMembers(ArchiveMemberList &list, const String &pattern) const {
@@ -243,11 +310,9 @@ const ArchiveMemberPtr SearchSet::getMember(const String &name) const {
 	if (name.empty())
 		return ArchiveMemberPtr();
 
-	ArchiveNodeList::const_iterator it = _list.begin();
-	for ( ; it != _list.end(); ++it) {
-		if (it->_arc->hasFile(name))
-			return it->_arc->getMember(name);
-	}
+	Archive *archive = findArchive(name);
+	if (archive)
+		return archive->getMember(name);
 
 	return ArchiveMemberPtr();
 }
@@ -256,9 +321,18 @@ SeekableReadStream *SearchSet::createReadStreamForMember(const String &name) con
 	if (name.empty())
 		return 0;
 
-	ArchiveNodeList::const_iterator it = _list.begin();
-	for ( ; it != _list.end(); ++it) {
-		SeekableReadStream *stream = it->_arc->createReadStreamForMember(name);
+	const uint indexed = lookupIndex(name);
+
+	for (uint i = 0; i < _unindexed.size() && _unindexed[i] < indexed; ++i) {
+		_probes++;
+		SeekableReadStream *stream = _archives[_unindexed[i]]->createReadStreamForMember(name);
+		if (stream)
+			return stream;
+	}
+
+	for (uint i = indexed; i < _archives.size(); ++i) {
+		_probes++;
+		SeekableReadStream *stream = _archives[i]->createReadStreamForMember(name);
 		if (stream)
 			return stream;
 	}
@@ -266,6 +340,15 @@ SeekableReadStream *SearchSet::createReadStreamForMember(const String &name) con
 	return 0;
 }
 
+void SearchSet::printIndexStats(int debugLevel) const {
+	debug(debugLevel, "SearchSet: %u lookups, %u found in the index of %u files, %u index rebuilds, %u archives probed",
+		_indexLookups, _indexHits, _fileIndex.size(), _indexRebuilds, _probes);
+}
+
+void SearchSet::resetIndexStats() {
+	_indexLookups = _indexHits = _indexRebuilds = _probes = 0;
+}
+
 
 SearchManager::SearchManager() {
 	clear();	// Force a reset
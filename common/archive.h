@@ -24,6 +24,8 @@
 #define COMMON_ARCHIVE_H
 
 #include "common/str.h"
+#include "common/str-array.h"
+#include "common/hash-str.h"
 #include "common/list.h"
 #include "common/ptr.h"
 #include "common/singleton.h"
@@ -106,6 +108,17 @@ public:
 	 */
 	virtual int listMembers(ArchiveMemberList &list) const = 0;
 
+	/**
+	 * Add the names of all members of the Archive to names, in the form
+	 * accepted by hasFile(). SearchSet uses this to index the members of
+	 * its archives, so it should only be implemented by archives with a
+	 * case insensitive hasFile(), whose members do not change.
+	 *
+	 * @return true if the names were added, false if the archive does not
+	 *         support listing them
+	 */
+	virtual bool listMemberNames(StringArray &names) const { return false; }
+
 	/**
 	 * Returns a ArchiveMember representation of the given file.
 	 */
@@ -126,6 +139,12 @@ public:
  * contained Archives, hence the simplistic policy of always looking for the first
  * match. SearchSet *DOES* guarantee that searches are performed in *DESCENDING*
  * priority order. In case of conflicting priorities, insertion order prevails.
+ *
+ * Lookups use an index of the members of all archives implementing
+ * listMemberNames(), so finding a file in them takes a single hash lookup
+ * instead of probing each archive. The other archives are still probed in
+ * priority order. The index is rebuilt on the first lookup after the set
+ * of archives changed.
  */
 class SearchSet : public Archive {
 	struct Node {
@@ -146,7 +165,35 @@ class SearchSet : public Archive {
 	// Add an archive keeping the list sorted by descending priority.
 	void insert(const Node& node);
 
+	typedef HashMap<String, uint, IgnoreCase_Hash, IgnoreCase_EqualTo> FileIndex;
+
+	// Index of the members of all archives supporting listMemberNames(),
+	// mapping each name to the position in _archives of the first of
+	// these archives which contains it.
+	mutable FileIndex _fileIndex;
+	// All archives by descending priority
+	mutable Array<Archive *> _archives;
+	// Positions of the archives which are not indexed and have to be probed
+	mutable Array<uint> _unindexed;
+	mutable bool _indexValid;
+
+	mutable uint32 _indexLookups, _indexHits, _indexRebuilds, _probes;
+
+	void invalidateIndex() { _indexValid = false; }
+	void updateIndex() const;
+
+	/**
+	 * Look up a name in the index.
+	 * @return the position of the first indexed archive containing the file,
+	 *         or the number of archives if none of them does
+	 */
+	uint lookupIndex(const String &name) const;
+
+	/** Find the first archive containing the file, or 0. */
+	Archive *findArchive(const String &name) const;
+
 public:
+	SearchSet();
 	virtual ~SearchSet() { clear(); }
 
 	/**
@@ -241,6 +288,14 @@ public:
 	 * opening the first file encountered that matches the name.
 	 */
 	virtual SeekableReadStream *createReadStreamForMember(const String &name) const;
+
+	/**
+	 * Print the number of file lookups, how many of them were answered by
+	 * the index, how often the index was rebuilt and how many archives had
+	 * to be probed since the last reset.
+	 */
+	void printIndexStats(int debugLevel) const;
+	void resetIndexStats();
 };
 
 
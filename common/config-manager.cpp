@@ -242,6 +242,18 @@ void ConfigManager::loadFromStream(SeekableReadStream &stream) {
 	addDomain(domainName, domain); // Add the last domain found
 }
 
+FSNode ConfigManager::getFileNextToConfig(const String &name) const {
+	assert(g_system);
+	FSNode configFile(_filename.empty() ? g_system->getDefaultConfigFileName() : _filename);
+	FSNode dir = configFile.getParent();
+
+	// A relative config file name has no parent
+	if (!dir.isDirectory())
+		dir = FSNode(".");
+
+	return dir.getChild(name);
+}
+
 void ConfigManager::flushToDisk() {
 #ifndef __DC__
 	WriteStream *stream;
@@ -31,6 +31,7 @@
 
 namespace Common {
 
+class FSNode;
 class WriteStream;
 class SeekableReadStream;
 
@@ -146,6 +147,13 @@ public:
 
 	void				flushToDisk();
 
+	/**
+	 * Returns the file with the given name in the directory of the config
+	 * file, or in the current directory if the config file has none. This
+	 * is used for data stored alongside the configuration, like caches.
+	 */
+	FSNode				getFileNextToConfig(const String &name) const;
+
 	void				setActiveDomain(const String &domName);
 	Domain *			getActiveDomain() { return _activeDomain; }
 	const Domain *		getActiveDomain() const { return _activeDomain; }
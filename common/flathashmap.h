@@ -0,0 +1,531 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef COMMON_FLATHASHMAP_H
+#define COMMON_FLATHASHMAP_H
+
+#include "common/func.h"
+#include "common/textconsole.h" // For error()
+
+namespace Common {
+
+/**
+ * FlatHashMap<Key,Val> maps objects of type Key to objects of type Val, like
+ * HashMap, and offers the same interface. It is meant as a drop-in
+ * replacement for maps which are used for many lookups.
+ *
+ * Unlike HashMap, which stores pointers to separately allocated nodes,
+ * FlatHashMap stores keys and values directly in its table. It uses linear
+ * probing with Robin Hood insertion: entries are kept sorted by their home
+ * slot, so a lookup can stop as soon as it reaches an entry which is closer
+ * to its own home slot than the searched key would be. Erasing an entry
+ * shifts the following entries back instead of leaving a marker behind, so
+ * the table never fills up with deleted entries.
+ *
+ * The differences to HashMap are:
+ * - Entries are moved around when other entries are added or erased.
+ *   Hence, adding or erasing an entry invalidates all iterators, pointers
+ *   and references to entries of the map. In particular, entries must not be
+ *   erased while iterating over the map.
+ * - Key and Val need to be copy-assignable.
+ * - The key of an entry is not const, but must not be modified either.
+ */
+template<class Key, class Val, class HashFunc = Hash<Key>, class EqualFunc = EqualTo<Key> >
+class FlatHashMap {
+public:
+	typedef uint size_type;
+
+private:
+
+	typedef FlatHashMap<Key, Val, HashFunc, EqualFunc> HM_t;
+
+	struct Node {
+		Key _key;
+		Val _value;
+		Node(const Key &key, const Val &value) : _key(key), _value(value) {}
+	};
+
+	enum {
+		HASHMAP_MIN_CAPACITY = 16,
+
+		// The quotient of the next two constants controls how much the
+		// internal storage of the hashmap may fill up before being
+		// increased automatically. Robin Hood hashing keeps probe
+		// sequences short even for high load factors.
+		HASHMAP_LOADFACTOR_NUMERATOR = 7,
+		HASHMAP_LOADFACTOR_DENOMINATOR = 8
+	};
+
+	/** Returned by lookup() if the key is not contained in the map. */
+	static const size_type NONE_FOUND = (size_type)-1;
+
+	Node *_storage;		///< Table of size _mask+1. Only slots with a distance are constructed.
+	size_type *_distances;	///< Distance of each entry from its home slot plus one; zero for empty slots.
+	size_type _mask;	///< Capacity of the HashMap minus one; must be a power of two minus one
+	size_type _shift;	///< Shift to map a scrambled hash to a slot
+	size_type _size;
+
+	HashFunc _hash;
+	EqualFunc _equal;
+
+	/** Default value, returned by the const getVal. */
+	const Val _defaultVal;
+
+	/**
+	 * Map a key to its home slot. The hash is scrambled (Fibonacci hashing),
+	 * since many hash functions, like the one for integers, leave patterns
+	 * in the low bits which would otherwise lead to clustering.
+	 */
+	size_type homeSlot(const Key &key) const {
+		return (size_type)(((uint32)_hash(key) * 2654435769U) >> _shift);
+	}
+
+	void allocStorage(size_type capacity);
+	void freeStorage();
+	void assign(const HM_t &map);
+	size_type lookup(const Key &key) const;
+	size_type lookupAndCreateIfMissing(const Key &key);
+	size_type insertNode(const Key &key, const Val &value);
+	void eraseNode(size_type idx);
+	void expandStorage(size_type newCapacity);
+
+	/**
+	 * Simple FlatHashMap iterator implementation.
+	 */
+	template<class NodeType>
+	class IteratorImpl {
+		friend class FlatHashMap;
+		template<class T> friend class IteratorImpl;
+	protected:
+		typedef const FlatHashMap hashmap_t;
+
+		size_type _idx;
+		hashmap_t *_hashmap;
+
+	protected:
+		IteratorImpl(size_type idx, hashmap_t *hashmap) : _idx(idx), _hashmap(hashmap) {}
+
+		NodeType *deref() const {
+			assert(_hashmap != 0);
+			assert(_idx <= _hashmap->_mask);
+			assert(_hashmap->_distances[_idx] != 0);
+			return &_hashmap->_storage[_idx];
+		}
+
+	public:
+		IteratorImpl() : _idx(0), _hashmap(0) {}
+		template<class T>
+		IteratorImpl(const IteratorImpl<T> &c) : _idx(c._idx), _hashmap(c._hashmap) {}
+
+		NodeType &operator*() const { return *deref(); }
+		NodeType *operator->() const { return deref(); }
+
+		bool operator==(const IteratorImpl &iter) const { return _idx == iter._idx && _hashmap == iter._hashmap; }
+		bool operator!=(const IteratorImpl &iter) const { return !(*this == iter); }
+
+		IteratorImpl &operator++() {
+			assert(_hashmap);
+			do {
+				_idx++;
+			} while (_idx <= _hashmap->_mask && _hashmap->_distances[_idx] == 0);
+			if (_idx > _hashmap->_mask)
+				_idx = NONE_FOUND;
+
+			return *this;
+		}
+
+		IteratorImpl operator++(int) {
+			IteratorImpl old = *this;
+			operator ++();
+			return old;
+		}
+	};
+
+public:
+	typedef IteratorImpl<Node> iterator;
+	typedef IteratorImpl<const Node> const_iterator;
+
+	FlatHashMap();
+	FlatHashMap(const HM_t &map);
+	~FlatHashMap();
+
+	HM_t &operator=(const HM_t &map) {
+		if (this == &map)
+			return *this;
+
+		// Remove the previous content and ...
+		freeStorage();
+		// ... copy the new stuff.
+		assign(map);
+		return *this;
+	}
+
+	bool contains(const Key &key) const;
+
+	Val &operator[](const Key &key);
+	const Val &operator[](const Key &key) const;
+
+	Val &getVal(const Key &key);
+	const Val &getVal(const Key &key) const;
+	const Val &getVal(const Key &key, const Val &defaultVal) const;
+	void setVal(const Key &key, const Val &val);
+
+	void clear(bool shrinkArray = 0);
+
+	void erase(iterator entry);
+	void erase(const Key &key);
+
+	size_type size() const { return _size; }
+
+	iterator	begin() {
+		// Find and return the first non-empty entry
+		for (size_type ctr = 0; ctr <= _mask; ++ctr) {
+			if (_distances[ctr])
+				return iterator(ctr, this);
+		}
+		return end();
+	}
+	iterator	end() {
+		return iterator(NONE_FOUND, this);
+	}
+
+	const_iterator	begin() const {
+		// Find and return the first non-empty entry
+		for (size_type ctr = 0; ctr <= _mask; ++ctr) {
+			if (_distances[ctr])
+				return const_iterator(ctr, this);
+		}
+		return end();
+	}
+	const_iterator	end() const {
+		return const_iterator(NONE_FOUND, this);
+	}
+
+	iterator	find(const Key &key) {
+		return iterator(lookup(key), this);
+	}
+
+	const_iterator	find(const Key &key) const {
+		return const_iterator(lookup(key), this);
+	}
+
+	bool empty() const {
+		return (_size == 0);
+	}
+};
+
+//-------------------------------------------------------
+// FlatHashMap functions
+
+/**
+ * Base constructor, creates an empty hashmap.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+FlatHashMap<Key, Val, HashFunc, EqualFunc>::FlatHashMap() : _defaultVal() {
+	allocStorage(HASHMAP_MIN_CAPACITY);
+}
+
+/**
+ * Copy constructor, creates a full copy of the given hashmap.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+FlatHashMap<Key, Val, HashFunc, EqualFunc>::FlatHashMap(const HM_t &map) : _defaultVal() {
+	assign(map);
+}
+
+/**
+ * Destructor, frees all used memory.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+FlatHashMap<Key, Val, HashFunc, EqualFunc>::~FlatHashMap() {
+	freeStorage();
+}
+
+/**
+ * Internal method for allocating an empty table of the given capacity,
+ * which must be a power of two.
+ *
+ * @note We do *not* deallocate the previous storage here -- the caller is
+ *       responsible for doing that!
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::allocStorage(size_type capacity) {
+	assert(capacity >= HASHMAP_MIN_CAPACITY && (capacity & (capacity - 1)) == 0);
+
+	_mask = capacity - 1;
+	_shift = 32;
+	while (capacity > 1) {
+		_shift--;
+		capacity >>= 1;
+	}
+	_size = 0;
+
+	_storage = (Node *)malloc((_mask + 1) * sizeof(Node));
+	_distances = (size_type *)calloc(_mask + 1, sizeof(size_type));
+	if (!_storage || !_distances)
+		::error("FlatHashMap: Failure to allocate %u entries", _mask + 1);
+}
+
+/**
+ * Internal method for destroying all entries and freeing the table.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::freeStorage() {
+	for (size_type ctr = 0; ctr <= _mask; ++ctr) {
+		if (_distances[ctr])
+			_storage[ctr].~Node();
+	}
+
+	free(_storage);
+	free(_distances);
+}
+
+/**
+ * Internal method for assigning the content of another FlatHashMap
+ * to this one.
+ *
+ * @note We do *not* deallocate the previous storage here -- the caller is
+ *       responsible for doing that!
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::assign(const HM_t &map) {
+	allocStorage(map._mask + 1);
+
+	// The table layout only depends on the keys and the capacity, so the
+	// entries can simply be copied slot by slot.
+	for (size_type ctr = 0; ctr <= _mask; ++ctr) {
+		if (map._distances[ctr]) {
+			new ((void *)&_storage[ctr]) Node(map._storage[ctr]);
+			_distances[ctr] = map._distances[ctr];
+		}
+	}
+	_size = map._size;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::clear(bool shrinkArray) {
+	if (shrinkArray && _mask >= HASHMAP_MIN_CAPACITY) {
+		freeStorage();
+		allocStorage(HASHMAP_MIN_CAPACITY);
+		return;
+	}
+
+	for (size_type ctr = 0; ctr <= _mask; ++ctr) {
+		if (_distances[ctr]) {
+			_storage[ctr].~Node();
+			_distances[ctr] = 0;
+		}
+	}
+
+	_size = 0;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::expandStorage(size_type newCapacity) {
+	assert(newCapacity > _mask+1);
+
+#ifndef NDEBUG
+	const size_type old_size = _size;
+#endif
+	const size_type old_mask = _mask;
+	Node *old_storage = _storage;
+	size_type *old_distances = _distances;
+
+	// Rehash all the old elements into a new table
+	allocStorage(newCapacity);
+	for (size_type ctr = 0; ctr <= old_mask; ++ctr) {
+		if (old_distances[ctr])
+			insertNode(old_storage[ctr]._key, old_storage[ctr]._value);
+	}
+
+	// Perform a sanity check: Old number of elements should match the new one!
+	// This check will fail if some previous operation corrupted this hashmap.
+	assert(_size == old_size);
+
+	for (size_type ctr = 0; ctr <= old_mask; ++ctr) {
+		if (old_distances[ctr])
+			old_storage[ctr].~Node();
+	}
+	free(old_storage);
+	free(old_distances);
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+typename FlatHashMap<Key, Val, HashFunc, EqualFunc>::size_type FlatHashMap<Key, Val, HashFunc, EqualFunc>::lookup(const Key &key) const {
+	size_type ctr = homeSlot(key);
+
+	// Entries are sorted by their home slot, so once we reach an entry
+	// which is closer to its home slot than the key would be at this
+	// position, the key can not come later.
+	for (size_type dist = 1; _distances[ctr] >= dist; ++dist) {
+		if (_distances[ctr] == dist && _equal(_storage[ctr]._key, key))
+			return ctr;
+
+		ctr = (ctr + 1) & _mask;
+	}
+
+	return NONE_FOUND;
+}
+
+/**
+ * Internal method for inserting a key which is not yet contained in the map.
+ * There must be at least one free slot.
+ *
+ * @return the slot of the new entry
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+typename FlatHashMap<Key, Val, HashFunc, EqualFunc>::size_type FlatHashMap<Key, Val, HashFunc, EqualFunc>::insertNode(const Key &key, const Val &value) {
+	// Find the slot of the new entry: the first slot whose entry is closer
+	// to its home slot than the new entry would be.
+	size_type idx = homeSlot(key);
+	size_type dist = 1;
+	while (_distances[idx] >= dist) {
+		idx = (idx + 1) & _mask;
+		dist++;
+	}
+
+	// The entries between this slot and the next empty one are moved one
+	// slot further, which keeps them sorted by their home slot.
+	size_type last = idx;
+	while (_distances[last])
+		last = (last + 1) & _mask;
+
+	if (last == idx) {
+		new ((void *)&_storage[idx]) Node(key, value);
+	} else {
+		size_type prev = (last - 1) & _mask;
+		new ((void *)&_storage[last]) Node(_storage[prev]);
+		_distances[last] = _distances[prev] + 1;
+
+		for (size_type ctr = prev; ctr != idx; ctr = prev) {
+			prev = (ctr - 1) & _mask;
+			_storage[ctr] = _storage[prev];
+			_distances[ctr] = _distances[prev] + 1;
+		}
+
+		_storage[idx]._key = key;
+		_storage[idx]._value = value;
+	}
+
+	_distances[idx] = dist;
+	_size++;
+	return idx;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+typename FlatHashMap<Key, Val, HashFunc, EqualFunc>::size_type FlatHashMap<Key, Val, HashFunc, EqualFunc>::lookupAndCreateIfMissing(const Key &key) {
+	size_type ctr = lookup(key);
+	if (ctr != NONE_FOUND)
+		return ctr;
+
+	// Keep the load factor below a certain threshold.
+	size_type capacity = _mask + 1;
+	if ((_size + 1) * HASHMAP_LOADFACTOR_DENOMINATOR > capacity * HASHMAP_LOADFACTOR_NUMERATOR) {
+		capacity = capacity < 500 ? (capacity * 4) : (capacity * 2);
+		expandStorage(capacity);
+	}
+
+	return insertNode(key, _defaultVal);
+}
+
+/**
+ * Internal method for erasing the entry in the given slot. The following
+ * entries which are not in their home slot are moved back by one slot.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::eraseNode(size_type idx) {
+	size_type next = (idx + 1) & _mask;
+	while (_distances[next] > 1) {
+		_storage[idx] = _storage[next];
+		_distances[idx] = _distances[next] - 1;
+		idx = next;
+		next = (next + 1) & _mask;
+	}
+
+	_storage[idx].~Node();
+	_distances[idx] = 0;
+	_size--;
+}
+
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+bool FlatHashMap<Key, Val, HashFunc, EqualFunc>::contains(const Key &key) const {
+	return lookup(key) != NONE_FOUND;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::operator[](const Key &key) {
+	return getVal(key);
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+const Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::operator[](const Key &key) const {
+	return getVal(key);
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::getVal(const Key &key) {
+	size_type ctr = lookupAndCreateIfMissing(key);
+	return _storage[ctr]._value;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+const Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::getVal(const Key &key) const {
+	return getVal(key, _defaultVal);
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+const Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::getVal(const Key &key, const Val &defaultVal) const {
+	size_type ctr = lookup(key);
+	if (ctr != NONE_FOUND)
+		return _storage[ctr]._value;
+	else
+		return defaultVal;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::setVal(const Key &key, const Val &val) {
+	size_type ctr = lookupAndCreateIfMissing(key);
+	_storage[ctr]._value = val;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::erase(iterator entry) {
+	// Check whether we have a valid iterator
+	assert(entry._hashmap == this);
+	const size_type ctr = entry._idx;
+	assert(ctr <= _mask);
+	assert(_distances[ctr] != 0);
+
+	eraseNode(ctr);
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::erase(const Key &key) {
+	size_type ctr = lookup(key);
+	if (ctr != NONE_FOUND)
+		eraseNode(ctr);
+}
+
+} // End of namespace Common
+
+#endif
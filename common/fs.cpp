@@ -27,6 +27,8 @@
 
 namespace Common {
 
+static FSNode::Stats s_fsStats = { 0, 0, 0, 0 };
+
 FSNode::FSNode() {
 }
 
@@ -39,6 +41,7 @@ FSNode::FSNode(const String &p) {
 	FilesystemFactory *factory = g_system->getFilesystemFactory();
 	AbstractFSNode *tmp = 0;
 
+	s_fsStats.lookups++;
 	if (p.empty() || p == ".")
 		tmp = factory->makeCurrentDirectoryFileNode();
 	else
@@ -57,7 +60,11 @@ bool FSNode::operator<(const FSNode& node) const {
 }
 
 bool FSNode::exists() const {
-	return _realNode && _realNode->exists();
+	if (!_realNode)
+		return false;
+
+	s_fsStats.lookups++;
+	return _realNode->exists();
 }
 
 FSNode FSNode::getChild(const String &n) const {
@@ -65,6 +72,7 @@ FSNode FSNode::getChild(const String &n) const {
 	if (_realNode == 0 || !_realNode->isDirectory())
 		return FSNode();
 
+	s_fsStats.lookups++;
 	AbstractFSNode *node = _realNode->getChild(n);
 	return FSNode(node);
 }
@@ -75,6 +83,7 @@ bool FSNode::getChildren(FSList &fslist, ListMode mode, bool hidden) const {
 
 	AbstractFSList tmp;
 
+	s_fsStats.listings++;
 	if (!_realNode->getChildren(tmp, mode, hidden))
 		return false;
 
@@ -118,17 +127,34 @@ bool FSNode::isDirectory() const {
 }
 
 bool FSNode::isReadable() const {
-	return _realNode && _realNode->isReadable();
+	if (!_realNode)
+		return false;
+
+	s_fsStats.lookups++;
+	return _realNode->isReadable();
 }
 
 bool FSNode::isWritable() const {
-	return _realNode && _realNode->isWritable();
+	if (!_realNode)
+		return false;
+
+	s_fsStats.lookups++;
+	return _realNode->isWritable();
+}
+
+bool FSNode::getFileInfo(uint32 &size, uint32 &modificationTime) const {
+	if (!_realNode)
+		return false;
+
+	s_fsStats.fileInfos++;
+	return _realNode->getFileInfo(size, modificationTime);
 }
 
 SeekableReadStream *FSNode::createReadStream() const {
 	if (_realNode == 0)
 		return 0;
 
+	s_fsStats.opens++;
 	if (!_realNode->exists()) {
 		warning("FSNode::createReadStream: '%s' does not exist", getName().c_str());
 		return 0;
@@ -140,10 +166,27 @@ SeekableReadStream *FSNode::createReadStream() const {
 	return _realNode->createReadStream();
 }
 
+SeekableReadStream *FSNode::createMappedReadStream() const {
+	if (_realNode == 0)
+		return 0;
+
+	s_fsStats.opens++;
+	if (!_realNode->exists()) {
+		warning("FSNode::createMappedReadStream: '%s' does not exist", getName().c_str());
+		return 0;
+	} else if (_realNode->isDirectory()) {
+		warning("FSNode::createMappedReadStream: '%s' is a directory", getName().c_str());
+		return 0;
+	}
+
+	return _realNode->createMappedReadStream();
+}
+
 WriteStream *FSNode::createWriteStream() const {
 	if (_realNode == 0)
 		return 0;
 
+	s_fsStats.opens++;
 	if (_realNode->isDirectory()) {
 		warning("FSNode::createWriteStream: '%s' is a directory", getName().c_str());
 		return 0;
@@ -152,6 +195,14 @@ WriteStream *FSNode::createWriteStream() const {
 	return _realNode->createWriteStream();
 }
 
+const FSNode::Stats &FSNode::getStats() {
+	return s_fsStats;
+}
+
+void FSNode::resetStats() {
+	s_fsStats.lookups = s_fsStats.listings = s_fsStats.fileInfos = s_fsStats.opens = 0;
+}
+
 FSDirectory::FSDirectory(const FSNode &node, int depth, bool flat)
   : _node(node), _cached(false), _depth(depth), _flat(flat) {
 }
@@ -335,5 +386,18 @@ int FSDirectory::listMembers(ArchiveMemberList &list) const {
 	return files;
 }
 
+bool FSDirectory::listMemberNames(StringArray &names) const {
+	if (!_node.isDirectory())
+		return true;
+
+	ensureCached();
+
+	// The cache keys are what hasFile() looks up
+	for (NodeCache::const_iterator it = _fileCache.begin(); it != _fileCache.end(); ++it)
+		names.push_back(it->_key);
+
+	return true;
+}
+
 
 } // End of namespace Common
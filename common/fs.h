@@ -56,6 +56,22 @@ class FSList : public Array<FSNode> {};
  * but it is also possible to use inodes or vrefs (MacOS 9) or anything else.
  */
 class FSNode : public ArchiveMember {
+public:
+	/**
+	 * Number of filesystem operations done through FSNode objects. Each of
+	 * them costs the backend one or a few system calls, so the counters
+	 * show how much filesystem access e.g. starting a game takes.
+	 */
+	struct Stats {
+		uint32 lookups;		///< nodes created from a path, getChild(), exists(), isReadable(), isWritable()
+		uint32 listings;	///< getChildren()
+		uint32 fileInfos;	///< getFileInfo()
+		uint32 opens;		///< createReadStream(), createWriteStream()
+
+		uint32 getTotal() const { return lookups + listings + fileInfos + opens; }
+	};
+
+
 private:
 	SharedPtr<AbstractFSNode>	_realNode;
 	FSNode(AbstractFSNode *realNode);
@@ -206,6 +222,20 @@ public:
 	 */
 	bool isWritable() const;
 
+	/**
+	 * Retrieves the size and the time of the last modification of the file
+	 * referred by this node, without opening it. This is cheap compared to
+	 * opening the file, and allows callers to tell whether a file changed
+	 * since they last looked at it.
+	 *
+	 * The modification time is only meant to be compared against earlier
+	 * values for the same file; its epoch is up to the backend.
+	 *
+	 * @return true if successful, false if the node does not refer to a file
+	 *         or the backend does not provide this information.
+	 */
+	bool getFileInfo(uint32 &size, uint32 &modificationTime) const;
+
 	/**
 	 * Creates a SeekableReadStream instance corresponding to the file
 	 * referred by this node. This assumes that the node actually refers
@@ -215,6 +245,20 @@ public:
 	 */
 	virtual SeekableReadStream *createReadStream() const;
 
+	/**
+	 * Creates a SeekableReadStream instance for the file referred by this
+	 * node, which maps the file into memory if the backend supports it.
+	 * Reading from such a stream needs no system calls, and borrowData()
+	 * works on it.
+	 *
+	 * Only use this for files which are not modified while the stream
+	 * exists: if a mapped file is truncated, reading the missing part
+	 * crashes instead of returning less data.
+	 *
+	 * @return pointer to the stream object, 0 in case of a failure
+	 */
+	SeekableReadStream *createMappedReadStream() const;
+
 	/**
 	 * Creates a WriteStream instance corresponding to the file
 	 * referred by this node. This assumes that the node actually refers
@@ -223,6 +267,13 @@ public:
 	 * @return pointer to the stream object, 0 in case of a failure
 	 */
 	WriteStream *createWriteStream() const;
+
+	/**
+	 * Return the number of filesystem operations since the last call of
+	 * resetStats().
+	 */
+	static const Stats &getStats();
+	static void resetStats();
 };
 
 /**
@@ -331,6 +382,12 @@ public:
 	 */
 	virtual int listMembers(ArchiveMemberList &list) const;
 
+	/**
+	 * Returns the names of all the files in the cache, including their
+	 * relative path unless the directory is flat.
+	 */
+	virtual bool listMemberNames(StringArray &names) const;
+
 	/**
 	 * Get a ArchiveMember representation of the specified file. A full match of relative
 	 * path and filename is needed for success.
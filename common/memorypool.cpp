@@ -22,6 +22,8 @@
 
 #include "common/memorypool.h"
 #include "common/util.h"
+#include "common/debug.h"
+#include "common/mutex.h"
 
 namespace Common {
 
@@ -44,6 +46,8 @@ MemoryPool::MemoryPool(size_t chunkSize)
 	: _chunkSize(adjustChunkSize(chunkSize)) {
 
 	_next = NULL;
+	_numChunks = 0;
+	_numUsedChunks = 0;
 
 	_chunksPerPage = INITIAL_CHUNKS_PER_PAGE;
 }
@@ -93,6 +97,7 @@ void MemoryPool::addPageToPool(const Page &page) {
 
 	// From now on, the first free chunk is the first chunk of the new page
 	_next = page.start;
+	_numChunks += page.numChunks;
 }
 
 void *MemoryPool::allocChunk() {
@@ -103,6 +108,7 @@ void *MemoryPool::allocChunk() {
 	assert(_next);
 	void *result = _next;
 	_next = *(void **)result;
+	_numUsedChunks++;
 	return result;
 }
 
@@ -110,6 +116,7 @@ void MemoryPool::freeChunk(void *ptr) {
 	// Add the chunk back to (the start of) the list of free chunks
 	*(void **)ptr = _next;
 	_next = ptr;
+	_numUsedChunks--;
 }
 
 // Technically not compliant C++ to compare unrelated pointers. In practice...
@@ -154,6 +161,7 @@ void MemoryPool::freeUnusedPages() {
 
 			::free(_pages[i].start);
 			++freedPagesCount;
+			_numChunks -= _pages[i].numChunks;
 			_pages[i].start = NULL;
 		}
 	}
@@ -179,4 +187,214 @@ void MemoryPool::freeUnusedPages() {
 	}
 }
 
+
+#pragma mark -
+
+
+SizeClassAllocator::SizeClassAllocator(bool threadSafe)
+	: _mutex(0), _numLargeBlocks(0), _largeBytes(0) {
+	for (uint i = 0; i < kNumSizeClasses; ++i)
+		_pools[i] = new MemoryPool((i + 1) * kSizeClassGranularity);
+
+	if (threadSafe)
+		_mutex = new Mutex();
+}
+
+SizeClassAllocator::~SizeClassAllocator() {
+	for (uint i = 0; i < kNumSizeClasses; ++i)
+		delete _pools[i];
+
+	delete _mutex;
+}
+
+void *SizeClassAllocator::allocate(size_t size) {
+	if (size == 0)
+		return NULL;
+
+	if (size > kMaxPooledSize) {
+		void *result = ::malloc(size);
+		assert(result);
+
+		if (_mutex)
+			_mutex->lock();
+		_numLargeBlocks++;
+		_largeBytes += size;
+		if (_mutex)
+			_mutex->unlock();
+
+		return result;
+	}
+
+	MemoryPool *pool = _pools[getSizeClass(size)];
+	if (!_mutex)
+		return pool->allocChunk();
+
+	StackLock lock(*_mutex);
+	return pool->allocChunk();
+}
+
+void SizeClassAllocator::deallocate(void *ptr, size_t size) {
+	if (!ptr)
+		return;
+
+	if (size > kMaxPooledSize) {
+		::free(ptr);
+
+		if (_mutex)
+			_mutex->lock();
+		_numLargeBlocks--;
+		_largeBytes -= size;
+		if (_mutex)
+			_mutex->unlock();
+
+		return;
+	}
+
+	MemoryPool *pool = _pools[getSizeClass(size)];
+	if (!_mutex) {
+		pool->freeChunk(ptr);
+		return;
+	}
+
+	StackLock lock(*_mutex);
+	pool->freeChunk(ptr);
+}
+
+void SizeClassAllocator::freeUnusedPages() {
+	if (_mutex)
+		_mutex->lock();
+
+	for (uint i = 0; i < kNumSizeClasses; ++i)
+		_pools[i]->freeUnusedPages();
+
+	if (_mutex)
+		_mutex->unlock();
+}
+
+size_t SizeClassAllocator::getUsedBytes() const {
+	size_t result = _largeBytes;
+	for (uint i = 0; i < kNumSizeClasses; ++i)
+		result += _pools[i]->getNumUsedChunks() * _pools[i]->getChunkSize();
+	return result;
+}
+
+size_t SizeClassAllocator::getReservedBytes() const {
+	size_t result = _largeBytes;
+	for (uint i = 0; i < kNumSizeClasses; ++i)
+		result += _pools[i]->getNumChunks() * _pools[i]->getChunkSize();
+	return result;
+}
+
+void SizeClassAllocator::printStats(int debugLevel) const {
+	for (uint i = 0; i < kNumSizeClasses; ++i) {
+		const MemoryPool *pool = _pools[i];
+		if (!pool->getNumChunks())
+			continue;
+
+		debug(debugLevel, "SizeClassAllocator: %3u bytes: %u of %u chunks used (%u%%)",
+			(uint)pool->getChunkSize(), (uint)pool->getNumUsedChunks(), (uint)pool->getNumChunks(),
+			(uint)(pool->getNumUsedChunks() * 100 / pool->getNumChunks()));
+	}
+
+	if (_numLargeBlocks)
+		debug(debugLevel, "SizeClassAllocator: %u large blocks with %u bytes", (uint)_numLargeBlocks, (uint)_largeBytes);
+
+	debug(debugLevel, "SizeClassAllocator: %u of %u bytes used", (uint)getUsedBytes(), (uint)getReservedBytes());
+}
+
+
+#pragma mark -
+
+
+MemoryArena::MemoryArena(size_t blockSize)
+	: _blockSize(blockSize), _current(0), _offset(0), _usedBytesBefore(0), _peakUsedBytes(0) {
+	assert(blockSize > 0);
+}
+
+MemoryArena::~MemoryArena() {
+	for (uint i = 0; i < _blocks.size(); ++i)
+		::free(_blocks[i].start);
+}
+
+void *MemoryArena::allocate(size_t size, size_t alignment) {
+	assert(alignment > 0 && alignment <= sizeof(void *) * 2 && !(alignment & (alignment - 1)));
+
+	size_t start = (_offset + alignment - 1) & ~(alignment - 1);
+
+	if (_blocks.empty() || start + size > _blocks[_current].size) {
+		// Move on to the next block, unless it is too small for this
+		// allocation. In that case, insert a new block in front of it.
+		if (!_blocks.empty()) {
+			_usedBytesBefore += _blocks[_current].size;
+			_current++;
+		}
+
+		if (_current == _blocks.size() || _blocks[_current].size < size) {
+			Block block;
+			block.size = MAX(size, _blockSize);
+			block.start = (byte *)::malloc(block.size);
+			assert(block.start);
+			_blocks.insert_at(_current, block);
+		}
+
+		start = 0;
+	}
+
+	_offset = start + size;
+
+	const size_t usedBytes = _usedBytesBefore + _offset;
+	if (usedBytes > _peakUsedBytes)
+		_peakUsedBytes = usedBytes;
+
+	return _blocks[_current].start + start;
+}
+
+MemoryArena::Marker MemoryArena::getMarker() const {
+	Marker marker;
+	marker.block = _current;
+	marker.offset = _offset;
+	return marker;
+}
+
+void MemoryArena::reset(const Marker &marker) {
+	assert(marker.block < _current || (marker.block == _current && marker.offset <= _offset));
+
+	_current = marker.block;
+	_offset = marker.offset;
+
+	_usedBytesBefore = 0;
+	for (uint i = 0; i < _current; ++i)
+		_usedBytesBefore += _blocks[i].size;
+}
+
+void MemoryArena::reset() {
+	_current = 0;
+	_offset = 0;
+	_usedBytesBefore = 0;
+}
+
+void MemoryArena::freeUnusedBlocks() {
+	// The current block is still in use, unless nothing was allocated
+	// from it
+	uint firstUnused = _current + 1;
+	if (_current == 0 && _offset == 0)
+		firstUnused = 0;
+
+	for (uint i = firstUnused; i < _blocks.size(); ++i)
+		::free(_blocks[i].start);
+
+	_blocks.resize(MIN<uint>(firstUnused, _blocks.size()));
+}
+
+size_t MemoryArena::getUsedBytes() const {
+	return _usedBytesBefore + _offset;
+}
+
+size_t MemoryArena::getReservedBytes() const {
+	size_t result = 0;
+	for (uint i = 0; i < _blocks.size(); ++i)
+		result += _blocks[i].size;
+	return result;
+}
+
 } // End of namespace Common
@@ -29,6 +29,8 @@
 
 namespace Common {
 
+class Mutex;
+
 /**
  * This class provides a pool of memory 'chunks' of identical size.
  * The size of a chunk is determined when creating the memory pool.
@@ -53,6 +55,8 @@ protected:
 	Array<Page>		_pages;
 	void			*_next;
 	size_t			_chunksPerPage;
+	size_t			_numChunks;
+	size_t			_numUsedChunks;
 
 	void	allocPage();
 	void	addPageToPool(const Page &page);
@@ -94,6 +98,18 @@ public:
 	 * Return the chunk size used by this memory pool.
 	 */
 	size_t	getChunkSize() const { return _chunkSize; }
+
+	/**
+	 * Return the number of chunks in all pages of this memory pool,
+	 * whether they are in use or not.
+	 */
+	size_t	getNumChunks() const { return _numChunks; }
+
+	/**
+	 * Return the number of chunks which have been allocated and not
+	 * been freed again.
+	 */
+	size_t	getNumUsedChunks() const { return _numUsedChunks; }
 };
 
 /**
@@ -141,6 +157,213 @@ public:
 	}
 };
 
+/**
+ * A general purpose allocator for small memory blocks, made of one memory
+ * pool per size class. Requests are rounded up to the next size class and
+ * served by the matching pool; blocks larger than the biggest size class
+ * are passed on to malloc/free.
+ *
+ * Unlike with malloc/free, the size of a block has to be passed back when
+ * freeing it. This saves storing a header with every block, which would
+ * double the memory needed for the smallest blocks.
+ *
+ * The allocator may be shared between threads if it is created with
+ * threadSafe set. This requires a backend which is already initialized,
+ * since a mutex has to be created for it.
+ */
+class SizeClassAllocator {
+public:
+	enum {
+		/** Granularity of the size classes, in bytes. */
+		kSizeClassGranularity = 16,
+		/** Number of size classes, and thus memory pools. */
+		kNumSizeClasses = 16,
+		/** Size of the largest blocks which are served by a memory pool. */
+		kMaxPooledSize = kSizeClassGranularity * kNumSizeClasses
+	};
+
+	/**
+	 * Constructor for a size class allocator.
+	 * @param threadSafe	whether the allocator may be used from several
+	 *						threads at once
+	 */
+	explicit SizeClassAllocator(bool threadSafe = false);
+	~SizeClassAllocator();
+
+	/**
+	 * Allocate a memory block of the given size. Returns NULL for a size
+	 * of 0.
+	 */
+	void	*allocate(size_t size);
+
+	/**
+	 * Return a memory block to the allocator. The size must be the one
+	 * which was passed to allocate() for the block.
+	 */
+	void	deallocate(void *ptr, size_t size);
+
+	/**
+	 * Release all pages of the memory pools which are not in use anymore.
+	 * @see MemoryPool::freeUnusedPages
+	 */
+	void	freeUnusedPages();
+
+	/**
+	 * Return the number of bytes in blocks which are currently allocated,
+	 * including those served by malloc. This counts the sizes of the size
+	 * classes, not the requested sizes.
+	 */
+	size_t	getUsedBytes() const;
+
+	/**
+	 * Return the number of bytes obtained via malloc, whether they are
+	 * currently allocated or not.
+	 */
+	size_t	getReservedBytes() const;
+
+	/**
+	 * Print the number of used and reserved chunks for every size class
+	 * as debug output of the given level.
+	 */
+	void	printStats(int debugLevel) const;
+
+private:
+	SizeClassAllocator(const SizeClassAllocator&);
+	SizeClassAllocator& operator=(const SizeClassAllocator&);
+
+	MemoryPool	*_pools[kNumSizeClasses];
+	Mutex		*_mutex;
+
+	size_t	_numLargeBlocks;
+	size_t	_largeBytes;
+
+	static uint getSizeClass(size_t size) {
+		return (size - 1) / kSizeClassGranularity;
+	}
+};
+
+/**
+ * A bump pointer allocator for short lived memory blocks.
+ *
+ * Allocating from an arena is just a matter of advancing a pointer in the
+ * current memory block. Individual allocations can not be freed; instead,
+ * all allocations made after a certain point are released at once by
+ * resetting the arena to a marker obtained at that point (see also the
+ * ArenaScope helper). The memory blocks are kept for reuse, so an arena
+ * which is reset once per frame or room does not call malloc at all once
+ * it has grown to the needed size.
+ *
+ * Since destructors are not called on reset, the arena should only be
+ * used for plain data (coordinates, sprite lists, text layout, etc.).
+ * Arenas are not thread safe.
+ */
+class MemoryArena {
+public:
+	/**
+	 * A position in the arena which can be returned to with reset().
+	 */
+	struct Marker {
+		uint	block;
+		size_t	offset;
+	};
+
+	/**
+	 * Constructor for an arena.
+	 * @param blockSize		size of the memory blocks the arena obtains via
+	 *						malloc. Larger allocations get a block of their
+	 *						own.
+	 */
+	explicit MemoryArena(size_t blockSize = 64 * 1024);
+	~MemoryArena();
+
+	/**
+	 * Allocate a memory block from the arena.
+	 * @param size		the size of the memory block
+	 * @param alignment	the alignment of the memory block, a power of two
+	 *					not larger than sizeof(void *) * 2, which is
+	 *					the alignment of the blocks obtained via malloc
+	 */
+	void	*allocate(size_t size, size_t alignment = sizeof(void *));
+
+	/**
+	 * Allocate an array of uninitialized objects of type T.
+	 */
+	template<class T>
+	T		*allocateArray(size_t count) { return (T *)allocate(count * sizeof(T)); }
+
+	/**
+	 * Return the current position in the arena.
+	 */
+	Marker	getMarker() const;
+
+	/**
+	 * Release all memory blocks allocated after the given marker was
+	 * obtained. Markers obtained after the given one become invalid.
+	 */
+	void	reset(const Marker &marker);
+
+	/**
+	 * Release all memory blocks allocated from the arena.
+	 */
+	void	reset();
+
+	/**
+	 * Free all memory blocks of the arena which are currently not in
+	 * use, instead of keeping them for future allocations.
+	 */
+	void	freeUnusedBlocks();
+
+	/**
+	 * Return the number of bytes currently allocated from the arena,
+	 * including padding for alignment and space skipped at the end of
+	 * memory blocks.
+	 */
+	size_t	getUsedBytes() const;
+
+	/**
+	 * Return the highest value getUsedBytes() returned since the arena
+	 * was created.
+	 */
+	size_t	getPeakUsedBytes() const { return _peakUsedBytes; }
+
+	/**
+	 * Return the number of bytes obtained via malloc.
+	 */
+	size_t	getReservedBytes() const;
+
+private:
+	MemoryArena(const MemoryArena&);
+	MemoryArena& operator=(const MemoryArena&);
+
+	struct Block {
+		byte	*start;
+		size_t	size;
+	};
+
+	const size_t	_blockSize;
+	Array<Block>	_blocks;
+	/** Index of the block allocations are currently served from. */
+	uint			_current;
+	/** Offset of the first free byte in the current block. */
+	size_t			_offset;
+	/** Number of bytes used in the blocks before the current one. */
+	size_t			_usedBytesBefore;
+	size_t			_peakUsedBytes;
+};
+
+/**
+ * Auxillary class to reset an arena to the position it had when the
+ * object was created, once it goes out of scope.
+ */
+class ArenaScope {
+	MemoryArena &_arena;
+	const MemoryArena::Marker _marker;
+
+public:
+	explicit ArenaScope(MemoryArena &arena) : _arena(arena), _marker(arena.getMarker()) {}
+	~ArenaScope() { _arena.reset(_marker); }
+};
+
 } // End of namespace Common
 
 /**
@@ -160,4 +383,15 @@ inline void operator delete(void *p, Common::MemoryPool &pool) {
 	pool.freeChunk(p);
 }
 
+/**
+ * A custom placement new operator, allocating from a MemoryArena. The
+ * destructors of objects allocated this way are never called.
+ */
+inline void *operator new(size_t nbytes, Common::MemoryArena &arena) {
+	return arena.allocate(nbytes);
+}
+
+inline void operator delete(void *p, Common::MemoryArena &arena) {
+}
+
 #endif
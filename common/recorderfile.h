@@ -126,6 +126,11 @@ public:
 
 	bool isEventsBufferEmpty();
 	PlaybackFileHeader &getHeader() {return _header;}
+
+	/** Number of recorded screenshots compared with the screen during playback */
+	uint32 getCheckedScreenshotsCount() const { return _checkedScreenshots; }
+	/** Number of recorded screenshots which differed from the screen during playback */
+	uint32 getDifferentScreenshotsCount() const { return _differentScreenshots; }
 	void updateHeader();
 	void addSaveFile(const String &fileName, InSaveFile *saveStream);
 private:
@@ -140,6 +145,8 @@ private:
 	bool _headerDumped;
 	int _recordCount;
 	uint32 _eventsSize;
+	uint32 _checkedScreenshots;
+	uint32 _differentScreenshots;
 	byte _tmpBuffer[kRecordBuffSize];
 	PlaybackFileHeader _header;
 	PlaybackFileState _playbackParseState;
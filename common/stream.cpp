@@ -54,6 +54,17 @@ uint32 MemoryReadStream::read(void *dataPtr, uint32 dataSize) {
 	return dataSize;
 }
 
+const byte *MemoryReadStream::borrowData(uint32 dataSize) {
+	if (dataSize > _size - _pos)
+		return 0;
+
+	const byte *result = _ptr;
+	_ptr += dataSize;
+	_pos += dataSize;
+
+	return result;
+}
+
 bool MemoryReadStream::seek(int32 offs, int whence) {
 	// Pre-Condition
 	assert(_pos <= _size);
@@ -216,6 +227,17 @@ SeekableSubReadStream::SeekableSubReadStream(SeekableReadStream *parentStream, u
 	_eos = false;
 }
 
+const byte *SeekableSubReadStream::borrowData(uint32 dataSize) {
+	if (dataSize > _end - _pos)
+		return 0;
+
+	const byte *result = _parentStream->borrowData(dataSize);
+	if (result)
+		_pos += dataSize;
+
+	return result;
+}
+
 bool SeekableSubReadStream::seek(int32 offset, int whence) {
 	assert(_pos >= _begin);
 	assert(_pos <= _end);
@@ -247,6 +269,13 @@ uint32 SafeSeekableSubReadStream::read(void *dataPtr, uint32 dataSize) {
 	return SeekableSubReadStream::read(dataPtr, dataSize);
 }
 
+const byte *SafeSeekableSubReadStream::borrowData(uint32 dataSize) {
+	// Make sure the parent stream is at the right position
+	seek(0, SEEK_CUR);
+
+	return SeekableSubReadStream::borrowData(dataSize);
+}
+
 
 #pragma mark -
 
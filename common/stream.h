@@ -453,6 +453,22 @@ public:
 	 */
 	virtual bool skip(uint32 offset) { return seek(offset, SEEK_CUR); }
 
+	/**
+	 * Get direct access to the next dataSize bytes of the stream, instead
+	 * of copying them with read(), and advance the stream position past
+	 * them.
+	 *
+	 * This is only supported by streams which keep all their data in
+	 * memory, or mapped into memory. The returned data must not be
+	 * modified, and stays valid as long as the stream exists.
+	 *
+	 * @param dataSize	number of bytes to access
+	 * @return a pointer to the data, or 0 if the stream does not support
+	 *         this or fewer than dataSize bytes are left. The stream
+	 *         position is not changed in that case.
+	 */
+	virtual const byte *borrowData(uint32 dataSize) { return 0; }
+
 	/**
 	 * Reads at most one less than the number of characters specified
 	 * by bufSize from the and stores them in the string buf. Reading
@@ -24,6 +24,7 @@
 #define COMMON_TIMER_H
 
 #include "common/scummsys.h"
+#include "common/array.h"
 #include "common/str.h"
 #include "common/noncopyable.h"
 
@@ -33,6 +34,18 @@ class TimerManager : NonCopyable {
 public:
 	typedef void (*TimerProc)(void *refCon);
 
+	/** Run time statistics of an installed timer callback. */
+	struct TimerStats {
+		String id;
+		int32 interval;		///< in microseconds
+		uint32 calls;		///< number of invocations
+		uint32 lateCalls;	///< invocations which were at least one interval late
+		uint32 slowCalls;	///< invocations which took at least one millisecond
+		uint32 totalTime;	///< time spent in the callback in milliseconds
+		uint32 maxTime;		///< longest invocation in milliseconds
+	};
+	typedef Array<TimerStats> TimerStatsList;
+
 	virtual ~TimerManager() {}
 
 	/**
@@ -55,6 +68,19 @@ public:
 	 * and no instance of this callback will be running anymore.
 	 */
 	virtual void removeTimerProc(TimerProc proc) = 0;
+
+	/**
+	 * Get the run time statistics of all installed timer callbacks.
+	 *
+	 * @param stats	list the statistics are appended to
+	 * @return	false if the timer manager does not keep statistics
+	 */
+	virtual bool getTimerStats(TimerStatsList &stats) { return false; }
+
+	/**
+	 * Reset the run time statistics of all installed timer callbacks.
+	 */
+	virtual void resetTimerStats() {}
 };
 
 } // End of namespace Common
@@ -106,6 +106,9 @@ typedef struct {
 #include "common/fs.h"
 #include "common/unzip.h"
 #include "common/memstream.h"
+#include "common/ptr.h"
+#include "common/substream.h"
+#include "common/util.h"
 
 #include "common/hashmap.h"
 #include "common/hash-str.h"
@@ -382,6 +385,8 @@ typedef Common::HashMap<Common::String, cached_file_in_zip, Common::IgnoreCase_H
 */
 typedef struct {
 	Common::SeekableReadStream *_stream;				/* io structore of the zipfile */
+	Common::SharedPtr<Common::SeekableReadStream> _sharedStream;	/* owner of _stream, shared with the
+													member streams */
 	unz_global_info gi;				/* public global information */
 	uLong byte_before_the_zipfile;	/* byte before the zipfile, (>0 for sfx)*/
 	uLong num_file;					/* number of the current file in the zipfile*/
@@ -544,6 +549,7 @@ unzFile unzOpen(Common::SeekableReadStream *stream) {
 	int err=UNZ_OK;
 
 	us->_stream = stream;
+	us->_sharedStream = Common::SharedPtr<Common::SeekableReadStream>(stream);
 
 	central_pos = unzlocal_SearchCentralDir(*us->_stream);
 	if (central_pos==0)
@@ -595,7 +601,6 @@ unzFile unzOpen(Common::SeekableReadStream *stream) {
 		err=UNZ_BADZIPFILE;
 
 	if (err != UNZ_OK) {
-		delete us->_stream;
 		delete us;
 		return NULL;
 	}
@@ -644,7 +649,8 @@ int unzClose(unzFile file) {
 	if (s->pfile_in_zip_read != NULL)
 		unzCloseCurrentFile(file);
 
-	delete s->_stream;
+	// The stream itself is deleted by _sharedStream, once no member
+	// stream uses it anymore
 	delete s;
 	return UNZ_OK;
 }
@@ -1431,6 +1437,7 @@ public:
 
 	virtual bool hasFile(const String &name) const;
 	virtual int listMembers(ArchiveMemberList &list) const;
+	virtual bool listMemberNames(StringArray &names) const;
 	virtual const ArchiveMemberPtr getMember(const String &name) const;
 	virtual SeekableReadStream *createReadStreamForMember(const String &name) const;
 };
@@ -1453,6 +1460,262 @@ public:
 };
 */
 
+/**
+ * Stream for an uncompressed archive member, which simply reads the part
+ * of the archive containing the member. The archive stream is positioned
+ * before every read, so several members can be read at the same time.
+ */
+class ZipStoredStream : public SafeSeekableSubReadStream {
+	// Keep the archive stream alive for as long as the member is used
+	SharedPtr<SeekableReadStream> _archiveStream;
+
+public:
+	ZipStoredStream(const SharedPtr<SeekableReadStream> &archiveStream, uint32 dataStart, uint32 size)
+		: SafeSeekableSubReadStream(archiveStream.get(), dataStart, dataStart + size, DisposeAfterUse::NO),
+		  _archiveStream(archiveStream) {
+	}
+};
+
+#ifdef USE_ZLIB
+
+/**
+ * Stream for a deflated archive member, which inflates the member while
+ * it is read.
+ *
+ * Every stream has its own inflate state and input buffer and seeks the
+ * archive stream before reading from it, so several members of an archive
+ * can be used at the same time. Memory usage does not depend on the size
+ * of the member.
+ *
+ * While inflating, the stream records a copy of the inflate state at
+ * regular intervals of the uncompressed data. Seeking resumes inflating
+ * from the closest of these checkpoints before the target position,
+ * instead of starting again at the beginning of the member.
+ */
+class ZipInflateStream : public SeekableReadStream {
+protected:
+	enum {
+		BUFSIZE = 16384,
+		/** Minimum distance between two checkpoints. */
+		MIN_CHECKPOINT_INTERVAL = 256 * 1024,
+		/**
+		 * Maximum number of checkpoints per stream. Every checkpoint
+		 * costs about 40 KB for the inflate window and state.
+		 */
+		MAX_CHECKPOINTS = 64
+	};
+
+	struct Checkpoint {
+		z_stream stream;
+		uint32 inputPos;
+		uint32 outputPos;
+	};
+
+	byte _buf[BUFSIZE];
+
+	SharedPtr<SeekableReadStream> _archiveStream;
+	const uint32 _dataStart;
+	const uint32 _compressedSize;
+	const uint32 _uncompressedSize;
+
+	z_stream _stream;
+	int _zlibErr;
+	/** Position in the compressed data of the next byte to read into _buf. */
+	uint32 _inputPos;
+	uint32 _pos;
+	bool _eos;
+
+	// zlib keeps a pointer to the z_stream in its state, so checkpoints
+	// must not be moved in memory
+	Array<Checkpoint *> _checkpoints;
+	uint32 _checkpointInterval;
+
+	/** CRC of the uncompressed data up to _crcPos. */
+	uLong _crc;
+	const uLong _expectedCrc;
+	uint32 _crcPos;
+
+public:
+	ZipInflateStream(const SharedPtr<SeekableReadStream> &archiveStream, uint32 dataStart,
+	                 uint32 compressedSize, uint32 uncompressedSize, uint32 crc)
+		: _archiveStream(archiveStream), _dataStart(dataStart), _compressedSize(compressedSize),
+		  _uncompressedSize(uncompressedSize), _stream(), _inputPos(0), _pos(0), _eos(false),
+		  _crc(crc32(0, Z_NULL, 0)), _expectedCrc(crc), _crcPos(0) {
+		_checkpointInterval = MAX<uint32>(MIN_CHECKPOINT_INTERVAL, uncompressedSize / MAX_CHECKPOINTS + 1);
+
+		// Negative windowBits indicate raw deflate data without header
+		_zlibErr = inflateInit2(&_stream, -MAX_WBITS);
+		_stream.next_in = _buf;
+		_stream.avail_in = 0;
+	}
+
+	~ZipInflateStream() {
+		for (uint i = 0; i < _checkpoints.size(); ++i) {
+			inflateEnd(&_checkpoints[i]->stream);
+			delete _checkpoints[i];
+		}
+		inflateEnd(&_stream);
+	}
+
+	bool err() const { return (_zlibErr != Z_OK) && (_zlibErr != Z_STREAM_END); }
+	void clearErr() {
+		// only reset _eos; I/O errors are not recoverable
+		_eos = false;
+	}
+
+	uint32 read(void *dataPtr, uint32 dataSize) {
+		byte *dst = (byte *)dataPtr;
+		uint32 remaining = dataSize;
+
+		while (remaining > 0 && !err()) {
+			if (_pos == _uncompressedSize) {
+				_eos = true;
+				break;
+			}
+
+			// Stop at the position of the next checkpoint to record it
+			const uint32 nextCheckpoint = (_checkpoints.size() + 1) * _checkpointInterval;
+			if (_pos == nextCheckpoint && _checkpoints.size() < MAX_CHECKPOINTS)
+				addCheckpoint();
+
+			uint32 len = MIN(remaining, _uncompressedSize - _pos);
+			if (_pos < nextCheckpoint)
+				len = MIN(len, nextCheckpoint - _pos);
+
+			const uint32 produced = inflateData(dst, len);
+			if (produced == 0 && !err()) {
+				// The compressed data ended before the member did
+				_zlibErr = Z_DATA_ERROR;
+			}
+
+			dst += produced;
+			remaining -= produced;
+		}
+
+		return dataSize - remaining;
+	}
+
+	bool eos() const {
+		return _eos;
+	}
+	int32 pos() const {
+		return _pos;
+	}
+	int32 size() const {
+		return _uncompressedSize;
+	}
+	bool seek(int32 offset, int whence = SEEK_SET) {
+		int32 newPos = 0;
+		switch (whence) {
+		case SEEK_SET:
+			newPos = offset;
+			break;
+		case SEEK_CUR:
+			newPos = _pos + offset;
+			break;
+		case SEEK_END:
+			newPos = size() + offset;
+			break;
+		}
+
+		if (newPos < 0 || newPos > size())
+			return false;
+
+		// Find the closest checkpoint before the target position, and use it
+		// if seeking backwards or if it allows to skip data
+		int checkpoint = MIN<int>((uint32)newPos / _checkpointInterval, _checkpoints.size()) - 1;
+		if ((uint32)newPos < _pos || (checkpoint >= 0 && _checkpoints[checkpoint]->outputPos > _pos)) {
+			if (checkpoint >= 0) {
+				inflateEnd(&_stream);
+				_zlibErr = inflateCopy(&_stream, &_checkpoints[checkpoint]->stream);
+				_inputPos = _checkpoints[checkpoint]->inputPos;
+				_pos = _checkpoints[checkpoint]->outputPos;
+			} else {
+				_zlibErr = inflateReset(&_stream);
+				_inputPos = 0;
+				_pos = 0;
+			}
+
+			if (_zlibErr != Z_OK)
+				return false;
+
+			_stream.next_in = _buf;
+			_stream.avail_in = 0;
+		}
+
+		// Skip the data up to the target position
+		byte tmpBuf[4096];
+		while (!err() && _pos < (uint32)newPos)
+			read(tmpBuf, MIN<uint32>(sizeof(tmpBuf), newPos - _pos));
+
+		_eos = false;
+		return !err();
+	}
+
+protected:
+	/**
+	 * Inflate up to len bytes to dst, stopping early only at the end of the
+	 * compressed data or on errors.
+	 */
+	uint32 inflateData(byte *dst, uint32 len) {
+		_stream.next_out = dst;
+		_stream.avail_out = len;
+
+		while (_zlibErr == Z_OK && _stream.avail_out) {
+			if (_stream.avail_in == 0) {
+				if (_inputPos == _compressedSize)
+					break;
+
+				// Read more compressed data. The archive stream is shared, so
+				// it has to be positioned every time.
+				const uint32 toRead = MIN<uint32>(BUFSIZE, _compressedSize - _inputPos);
+				_archiveStream->seek(_dataStart + _inputPos, SEEK_SET);
+				if (_archiveStream->read(_buf, toRead) != toRead) {
+					_zlibErr = Z_ERRNO;
+					break;
+				}
+
+				_stream.next_in = _buf;
+				_stream.avail_in = toRead;
+				_inputPos += toRead;
+			}
+
+			_zlibErr = inflate(&_stream, Z_SYNC_FLUSH);
+		}
+
+		const uint32 produced = len - _stream.avail_out;
+
+		// Verify the CRC of the member when it is read from start to end
+		if (_crcPos == _pos && produced) {
+			_crc = crc32(_crc, dst, produced);
+			_crcPos += produced;
+			if (_crcPos == _uncompressedSize && _crc != _expectedCrc) {
+				warning("ZipInflateStream: CRC mismatch");
+				_zlibErr = Z_DATA_ERROR;
+			}
+		}
+
+		_pos += produced;
+		return produced;
+	}
+
+	void addCheckpoint() {
+		Checkpoint *checkpoint = new Checkpoint();
+		if (inflateCopy(&checkpoint->stream, &_stream) != Z_OK) {
+			delete checkpoint;
+			return;
+		}
+
+		// Input data which was read into the buffer but is not consumed yet
+		// has to be read again when resuming from the checkpoint
+		checkpoint->inputPos = _inputPos - _stream.avail_in;
+		checkpoint->outputPos = _pos;
+		_checkpoints.push_back(checkpoint);
+	}
+};
+
+#endif
+
 ZipArchive::ZipArchive(unzFile zipFile) : _zipFile(zipFile) {
 	assert(_zipFile);
 }
@@ -1478,6 +1741,15 @@ int ZipArchive::listMembers(ArchiveMemberList &list) const {
 	return members;
 }
 
+bool ZipArchive::listMemberNames(StringArray &names) const {
+	const unz_s *const archive = (const unz_s *)_zipFile;
+	for (ZipHash::const_iterator i = archive->_hash.begin(), end = archive->_hash.end();
+	     i != end; ++i)
+		names.push_back(i->_key);
+
+	return true;
+}
+
 const ArchiveMemberPtr ZipArchive::getMember(const String &name) const {
 	if (!hasFile(name))
 		return ArchiveMemberPtr();
@@ -1496,25 +1768,33 @@ SeekableReadStream *ZipArchive::createReadStreamForMember(const String &name) co
 	if (unzGetCurrentFileInfo(_zipFile, &fileInfo, NULL, 0, NULL, 0, NULL, 0) != UNZ_OK)
 		return 0;
 
-	byte *buffer = (byte *)malloc(fileInfo.uncompressed_size);
-	assert(buffer);
+	// Instead of reading the member through the archive, which can only
+	// read one member at a time, create a stream of its own for it.
+	const unz_s *const archive = (const unz_s *)_zipFile;
+	const uint32 dataStart = archive->pfile_in_zip_read->pos_in_zipfile + archive->byte_before_the_zipfile;
 
-	if (unzReadCurrentFile(_zipFile, buffer, fileInfo.uncompressed_size) != (int)fileInfo.uncompressed_size) {
-		free(buffer);
+	if (unzCloseCurrentFile(_zipFile) != UNZ_OK)
 		return 0;
+
+	if (fileInfo.compression_method == 0) {
+		if (fileInfo.compressed_size != fileInfo.uncompressed_size)
+			return 0;
+
+		return new ZipStoredStream(archive->_sharedStream, dataStart, fileInfo.uncompressed_size);
 	}
 
-	if (unzCloseCurrentFile(_zipFile) != UNZ_OK) {
-		free(buffer);
+#ifdef USE_ZLIB
+	ZipInflateStream *stream = new ZipInflateStream(archive->_sharedStream, dataStart,
+		fileInfo.compressed_size, fileInfo.uncompressed_size, fileInfo.crc);
+	if (stream->err()) {
+		delete stream;
 		return 0;
 	}
 
-	return new MemoryReadStream(buffer, fileInfo.uncompressed_size, DisposeAfterUse::YES);
-
-	// FIXME: instead of reading all into a memory stream, we could
-	// instead create a new ZipStream class. But then we have to be
-	// careful to handle the case where the client code opens multiple
-	// files in the archive and tries to use them independently.
+	return stream;
+#else
+	return 0;
+#endif
 }
 
 Archive *makeZipArchive(const String &name) {
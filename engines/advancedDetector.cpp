@@ -31,6 +31,7 @@
 #include "common/translation.h"
 #include "gui/EventRecorder.h"
 #include "engines/advancedDetector.h"
+#include "engines/detectioncache.h"
 #include "engines/obsolete.h"
 
 static GameDescriptor toGameDescriptor(const ADGameDescription &g, const PlainGameDescriptor *sg) {
@@ -386,14 +387,7 @@ bool AdvancedMetaEngine::getFileProperties(const Common::FSNode &parent, const F
 	if (!allFiles.contains(fname))
 		return false;
 
-	Common::File testFile;
-
-	if (!testFile.open(allFiles[fname]))
-		return false;
-
-	fileProps.size = (int32)testFile.size();
-	fileProps.md5 = Common::computeStreamMD5AsString(testFile, _md5Bytes);
-	return true;
+	return DetectionCacheMan.getFileProperties(allFiles[fname], _md5Bytes, fileProps);
 }
 
 ADGameDescList AdvancedMetaEngine::detectGame(const Common::FSNode &parent, const FileMap &allFiles, Common::Language language, Common::Platform platform, const Common::String &extra) const {
@@ -0,0 +1,215 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "engines/detectioncache.h"
+
+#include "common/config-manager.h"
+#include "common/debug.h"
+#include "common/file.h"
+#include "common/fs.h"
+#include "common/md5.h"
+#include "common/system.h"
+
+namespace Common {
+DECLARE_SINGLETON(DetectionCache);
+}
+
+/** Name of the cache file, which is stored next to the config file. */
+static const char *const kCacheFileName = "scummvm-detection.cache";
+
+/** First line of the cache file, to be changed if the format changes. */
+static const char *const kCacheHeader = "ScummVM detection cache 1";
+
+/**
+ * Minimum time between two non-forced flushes, in milliseconds. Detecting
+ * a large collection adds entries for many directories in a row.
+ */
+static const uint32 kFlushInterval = 5000;
+
+DetectionCache::DetectionCache()
+	: _enabled(true), _loaded(false), _dirty(false), _pruned(false), _lastFlush(0), _hits(0), _misses(0) {
+}
+
+DetectionCache::~DetectionCache() {
+	flush(true);
+}
+
+Common::String DetectionCache::makeKey(const Common::FSNode &node, uint32 md5Bytes) {
+	return Common::String::format("%u\t", md5Bytes) + node.getPath();
+}
+
+void DetectionCache::load() {
+	_loaded = true;
+
+	if (ConfMan.hasKey("detection_cache"))
+		_enabled = ConfMan.getBool("detection_cache");
+	if (!_enabled)
+		return;
+
+	Common::FSNode cacheFile = ConfMan.getFileNextToConfig(kCacheFileName);
+	if (!cacheFile.exists())
+		return;
+
+	Common::File file;
+	if (!file.open(cacheFile))
+		return;
+
+	if (file.readLine() != kCacheHeader) {
+		debug(2, "DetectionCache: Ignoring cache file of unknown format");
+		return;
+	}
+
+	// Every line has the format "md5Bytes size modificationTime md5 path",
+	// with the fields separated by tabs. The key is made of the first and
+	// the last field.
+	while (!file.eos() && !file.err()) {
+		Common::String line = file.readLine();
+		if (line.empty())
+			continue;
+
+		uint md5Bytes, size, modificationTime;
+		char md5[33];
+		int md5End = 0;
+		if (sscanf(line.c_str(), "%u\t%u\t%u\t%32s%n", &md5Bytes, &size, &modificationTime, md5, &md5End) != 4 || line[md5End] != '\t') {
+			debug(2, "DetectionCache: Skipping malformed line '%s'", line.c_str());
+			continue;
+		}
+
+		Entry entry;
+		entry.size = size;
+		entry.modificationTime = modificationTime;
+		entry.md5 = md5;
+		entry.used = false;
+		_entries[Common::String::format("%u\t", md5Bytes) + (line.c_str() + md5End + 1)] = entry;
+	}
+
+	debug(2, "DetectionCache: Loaded %u entries", _entries.size());
+}
+
+bool DetectionCache::getFileProperties(const Common::FSNode &node, uint32 md5Bytes, ADFileProperties &fileProps) {
+	Common::String key;
+	uint32 size, modificationTime;
+	bool cacheable = false;
+
+	if (!_loaded)
+		load();
+
+	if (_enabled && node.getFileInfo(size, modificationTime)) {
+		key = makeKey(node, md5Bytes);
+		// Paths with line breaks can not be stored in the cache file
+		cacheable = !strchr(key.c_str(), '\n');
+	}
+
+	if (cacheable) {
+		EntryMap::iterator i = _entries.find(key);
+		if (i != _entries.end() && i->_value.size == size && i->_value.modificationTime == modificationTime) {
+			fileProps.size = size;
+			fileProps.md5 = i->_value.md5;
+			i->_value.used = true;
+			_hits++;
+			return true;
+		}
+	}
+
+	_misses++;
+
+	Common::File testFile;
+	if (!testFile.open(node))
+		return false;
+
+	fileProps.size = (int32)testFile.size();
+	fileProps.md5 = Common::computeStreamMD5AsString(testFile, md5Bytes);
+
+	if (cacheable && (uint32)fileProps.size == size) {
+		Entry entry;
+		entry.size = size;
+		entry.modificationTime = modificationTime;
+		entry.md5 = fileProps.md5;
+		entry.used = true;
+
+		_entries[key] = entry;
+		_dirty = true;
+	}
+
+	return true;
+}
+
+void DetectionCache::prune() {
+	_pruned = true;
+
+	uint removed = 0;
+	for (EntryMap::iterator i = _entries.begin(); i != _entries.end(); ++i) {
+		if (i->_value.used)
+			continue;
+
+		// The key starts with the MD5 byte count and a tab
+		const char *path = strchr(i->_key.c_str(), '\t') + 1;
+		if (!Common::FSNode(path).exists()) {
+			_entries.erase(i);
+			removed++;
+		}
+	}
+
+	if (removed) {
+		debug(2, "DetectionCache: Dropped %u entries of missing files", removed);
+		_dirty = true;
+	}
+}
+
+void DetectionCache::flush(bool force) {
+	if (_hits || _misses)
+		debug(2, "DetectionCache: %u hits, %u misses", _hits, _misses);
+
+	if (force && _enabled && _loaded && !_pruned)
+		prune();
+
+	if (!_dirty)
+		return;
+
+	const uint32 now = g_system->getMillis();
+	if (!force && _lastFlush && now - _lastFlush < kFlushInterval)
+		return;
+
+	Common::WriteStream *stream = ConfMan.getFileNextToConfig(kCacheFileName).createWriteStream();
+	if (!stream) {
+		debug(2, "DetectionCache: Could not write the cache file");
+		_enabled = false;
+		return;
+	}
+
+	stream->writeString(kCacheHeader);
+	stream->writeByte('\n');
+
+	for (EntryMap::const_iterator i = _entries.begin(); i != _entries.end(); ++i) {
+		// The key already starts with the MD5 byte count and a tab
+		const char *path = strchr(i->_key.c_str(), '\t') + 1;
+		const Common::String md5Bytes(i->_key.c_str(), path - 1);
+		stream->writeString(Common::String::format("%s\t%u\t%u\t%s\t%s\n",
+			md5Bytes.c_str(), i->_value.size, i->_value.modificationTime, i->_value.md5.c_str(), path));
+	}
+
+	stream->finalize();
+	delete stream;
+
+	_dirty = false;
+	_lastFlush = now;
+}
@@ -0,0 +1,124 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef ENGINES_DETECTION_CACHE_H
+#define ENGINES_DETECTION_CACHE_H
+
+#include "engines/advancedDetector.h"
+
+#include "common/hashmap.h"
+#include "common/singleton.h"
+
+namespace Common {
+class FSNode;
+}
+
+/**
+ * Persistent cache of the file properties computed by the advanced detector.
+ *
+ * Computing the MD5 of every candidate file is the most expensive part of
+ * detecting games, especially for large collections on slow or network
+ * storage. This cache remembers the MD5s across runs, in a file next to the
+ * configuration file. It is shared by all engines.
+ *
+ * Entries are keyed by the path of the file and the number of bytes the
+ * MD5 was computed over. They are only used as long as the size and the
+ * modification time of the file match the ones stored with the entry, so
+ * modified files are detected again automatically. Files whose backend
+ * does not report a modification time are never cached.
+ *
+ * The cache can be disabled with the "detection_cache" config key.
+ */
+class DetectionCache : public Common::Singleton<DetectionCache> {
+public:
+	~DetectionCache();
+
+	/**
+	 * Retrieve the size and the MD5 of the first md5Bytes bytes of a file,
+	 * either from the cache or by reading the file.
+	 *
+	 * @param node		the file
+	 * @param md5Bytes	number of bytes to compute the MD5 over, 0 for
+	 *					the whole file
+	 * @param fileProps	receives the properties of the file
+	 * @return true if successful, false if the file could not be read
+	 */
+	bool getFileProperties(const Common::FSNode &node, uint32 md5Bytes, ADFileProperties &fileProps);
+
+	/**
+	 * Write the cache to disk if it changed.
+	 *
+	 * Unless force is set, this does nothing if the cache was written to
+	 * disk recently. This allows calling it after every detection pass
+	 * without rewriting the cache for every directory of a mass add.
+	 * The first forced flush also drops the entries of files which are
+	 * gone, so they don't pile up in the cache file.
+	 */
+	void flush(bool force = false);
+
+	/** Number of lookups which were answered from the cache. */
+	uint32 getHits() const { return _hits; }
+
+	/** Number of lookups which required reading the file. */
+	uint32 getMisses() const { return _misses; }
+
+private:
+	friend class Common::Singleton<SingletonBaseType>;
+	DetectionCache();
+
+	struct Entry {
+		uint32 size;
+		uint32 modificationTime;
+		Common::String md5;
+		/** Whether the entry has been looked up or added in this run. */
+		bool used;
+	};
+
+	typedef Common::HashMap<Common::String, Entry> EntryMap;
+
+	EntryMap _entries;
+
+	bool _enabled;
+	bool _loaded;
+	bool _dirty;
+	bool _pruned;
+	uint32 _lastFlush;
+
+	uint32 _hits;
+	uint32 _misses;
+
+	/** Load the cache file. */
+	void load();
+
+	/**
+	 * Drop the entries of files which no longer exist. Only entries which
+	 * have not been used in this run need to be checked.
+	 */
+	void prune();
+
+	static Common::String makeKey(const Common::FSNode &node, uint32 md5Bytes);
+};
+
+/** Shortcut for accessing the detection cache. */
+#define DetectionCacheMan	DetectionCache::instance()
+
+#endif
@@ -260,6 +260,12 @@ public:
 	GameDescriptor findGameInLoadedPlugins(const Common::String &gameName, const EnginePlugin **plugin = NULL) const;
 	GameDescriptor findGame(const Common::String &gameName, const EnginePlugin **plugin = NULL) const;
 	GameList detectGames(const Common::FSList &fslist) const;
+	/**
+	 * Retrieve the games supported by all engines. Uses the plugin index
+	 * if the plugin manager has one, so that plugins do not need to be
+	 * loaded.
+	 */
+	GameList getSupportedGames() const;
 	const EnginePlugin::List &getPlugins() const;
 };
 
@@ -58,6 +58,7 @@
 #include "sci/video/robot_decoder.h"
 #endif
 
+#include "common/algorithm.h"
 #include "common/file.h"
 #include "common/savefile.h"
 
@@ -93,6 +94,8 @@ Console::Console(SciEngine *engine) : GUI::Debugger(),
 	// Kernel
 //	registerCmd("classes",			WRAP_METHOD(Console, cmdClasses));	// TODO
 	registerCmd("opcodes",			WRAP_METHOD(Console, cmdOpcodes));
+	registerCmd("vm_profile",			WRAP_METHOD(Console, cmdVMProfile));
+	registerCmd("avoidpath_stats",		WRAP_METHOD(Console, cmdAvoidPathStats));
 	registerCmd("selector",			WRAP_METHOD(Console, cmdSelector));
 	registerCmd("selectors",			WRAP_METHOD(Console, cmdSelectors));
 	registerCmd("functions",			WRAP_METHOD(Console, cmdKernelFunctions));
@@ -112,6 +115,7 @@ Console::Console(SciEngine *engine) : GUI::Debugger(),
 	registerCmd("resource_id",		WRAP_METHOD(Console, cmdResourceId));
 	registerCmd("resource_info",		WRAP_METHOD(Console, cmdResourceInfo));
 	registerCmd("resource_types",		WRAP_METHOD(Console, cmdResourceTypes));
+	registerCmd("resource_cache",		WRAP_METHOD(Console, cmdResourceCache));
 	registerCmd("list",				WRAP_METHOD(Console, cmdList));
 	registerCmd("hexgrep",			WRAP_METHOD(Console, cmdHexgrep));
 	registerCmd("verify_scripts",		WRAP_METHOD(Console, cmdVerifyScripts));
@@ -141,6 +145,7 @@ Console::Console(SciEngine *engine) : GUI::Debugger(),
 	registerCmd("pi",                 WRAP_METHOD(Console, cmdPlaneItemList));	// alias
 	registerCmd("saved_bits",         WRAP_METHOD(Console, cmdSavedBits));
 	registerCmd("show_saved_bits",    WRAP_METHOD(Console, cmdShowSavedBits));
+	registerCmd("gfx_cache",          WRAP_METHOD(Console, cmdGfxCache));
 	// Segments
 	registerCmd("segment_table",		WRAP_METHOD(Console, cmdPrintSegmentTable));
 	registerCmd("segtable",			WRAP_METHOD(Console, cmdPrintSegmentTable));	// alias
@@ -150,6 +155,7 @@ Console::Console(SciEngine *engine) : GUI::Debugger(),
 	registerCmd("segkill",			WRAP_METHOD(Console, cmdKillSegment));			// alias
 	// Garbage collection
 	registerCmd("gc",					WRAP_METHOD(Console, cmdGCInvoke));
+	registerCmd("gc_stats",			WRAP_METHOD(Console, cmdGCStats));
 	registerCmd("gc_objects",			WRAP_METHOD(Console, cmdGCObjects));
 	registerCmd("gc_reachable",		WRAP_METHOD(Console, cmdGCShowReachable));
 	registerCmd("gc_freeable",		WRAP_METHOD(Console, cmdGCShowFreeable));
@@ -233,6 +239,8 @@ Console::Console(SciEngine *engine) : GUI::Debugger(),
 	_debugState.breakpointWasHit = false;
 	_debugState._breakpoints.clear(); // No breakpoints defined
 	_debugState._activeBreakpointTypes = 0;
+	_debugState._profile.enabled = false;
+	_debugState._profile.reset();
 }
 
 Console::~Console() {
@@ -330,6 +338,8 @@ bool Console::cmdHelp(int argc, const char **argv) {
 	debugPrintf("--------\n");
 	debugPrintf("Kernel:\n");
 	debugPrintf(" opcodes - Lists the opcode names\n");
+	debugPrintf(" vm_profile - Shows which opcodes and methods scripts execute the most\n");
+	debugPrintf(" avoidpath_stats - Shows how often pathfinding could use cached polygon sets\n");
 	debugPrintf(" selectors - Lists the selector names\n");
 	debugPrintf(" selector - Attempts to find the requested selector by name\n");
 	debugPrintf(" functions - Lists the kernel functions\n");
@@ -351,6 +361,7 @@ bool Console::cmdHelp(int argc, const char **argv) {
 	debugPrintf(" resource_id - Identifies a resource number by splitting it up in resource type and resource number\n");
 	debugPrintf(" resource_info - Shows info about a resource\n");
 	debugPrintf(" resource_types - Shows the valid resource types\n");
+	debugPrintf(" resource_cache - Shows the resource cache statistics, or sets its size\n");
 	debugPrintf(" list - Lists all the resources of a given type\n");
 	debugPrintf(" hexgrep - Searches some resources for a particular sequence of bytes, represented as hexadecimal numbers\n");
 	debugPrintf(" verify_scripts - Performs sanity checks on SCI1.1-SCI2.1 game scripts (e.g. if they're up to 64KB in total)\n");
@@ -378,6 +389,7 @@ bool Console::cmdHelp(int argc, const char **argv) {
 	debugPrintf(" plane_items / pi - Shows a list of all items for a plane (SCI2+)\n");
 	debugPrintf(" saved_bits - List saved bits on the hunk\n");
 	debugPrintf(" show_saved_bits - Display saved bits\n");
+	debugPrintf(" gfx_cache - Shows the view and font cache statistics, or sets their limits\n");
 	debugPrintf("\n");
 	debugPrintf("Segments:\n");
 	debugPrintf(" segment_table / segtable - Lists all segments\n");
@@ -386,6 +398,7 @@ bool Console::cmdHelp(int argc, const char **argv) {
 	debugPrintf("\n");
 	debugPrintf("Garbage collection:\n");
 	debugPrintf(" gc - Invokes the garbage collector\n");
+	debugPrintf(" gc_stats - Shows how long garbage collection pauses the game\n");
 	debugPrintf(" gc_objects - Lists all reachable objects, normalized\n");
 	debugPrintf(" gc_reachable - Lists all addresses directly reachable from a given memory object\n");
 	debugPrintf(" gc_freeable - Lists all addresses freeable in a given segment\n");
@@ -496,6 +509,76 @@ bool Console::cmdGetVersion(int argc, const char **argv) {
 	return true;
 }
 
+struct ProfileEntry {
+	Common::String name;
+	uint32 count;
+
+	bool operator<(const ProfileEntry &other) const { return count > other.count; }
+};
+
+extern const char *opcodeNames[]; // from scriptdebug.cpp
+
+bool Console::cmdVMProfile(int argc, const char **argv) {
+	ScriptProfile &profile = _debugState._profile;
+	uint maxEntries = 20;
+
+	if (argc > 1) {
+		if (!scumm_stricmp(argv[1], "on")) {
+			profile.enabled = true;
+			debugPrintf("Script profiling enabled\n");
+			return true;
+		} else if (!scumm_stricmp(argv[1], "off")) {
+			profile.enabled = false;
+			debugPrintf("Script profiling disabled\n");
+			return true;
+		} else if (!scumm_stricmp(argv[1], "reset")) {
+			profile.reset();
+			debugPrintf("Script profile reset\n");
+			return true;
+		} else if (Common::isDigit(argv[1][0])) {
+			maxEntries = atoi(argv[1]);
+		} else {
+			debugPrintf("Usage: %s [on | off | reset | <number of entries>]\n", argv[0]);
+			return true;
+		}
+	}
+
+	debugPrintf("Script profiling is %s\n", profile.enabled ? "enabled" : "disabled");
+
+	Common::Array<ProfileEntry> entries;
+	uint32 instructions = 0;
+	for (int i = 0; i < ARRAYSIZE(profile.opcodeCounts); i++) {
+		if (!profile.opcodeCounts[i])
+			continue;
+		ProfileEntry entry;
+		entry.name = opcodeNames[i];
+		entry.count = profile.opcodeCounts[i];
+		entries.push_back(entry);
+		instructions += entry.count;
+	}
+	Common::sort(entries.begin(), entries.end());
+
+	debugPrintf("%u instructions executed\n", instructions);
+	debugPrintf("\nMost executed opcodes:\n");
+	for (uint i = 0; i < entries.size() && i < maxEntries; i++)
+		debugPrintf(" %-10u %s\n", entries[i].count, entries[i].name.c_str());
+
+	entries.clear();
+	for (Common::HashMap<Common::String, uint32>::const_iterator i = profile.methodCounts.begin(); i != profile.methodCounts.end(); ++i) {
+		ProfileEntry entry;
+		entry.name = i->_key;
+		entry.count = i->_value;
+		entries.push_back(entry);
+	}
+	Common::sort(entries.begin(), entries.end());
+
+	debugPrintf("\nMethods executing the most instructions:\n");
+	for (uint i = 0; i < entries.size() && i < maxEntries; i++)
+		debugPrintf(" %-10u %s\n", entries[i].count, entries[i].name.c_str());
+
+	return true;
+}
+
 bool Console::cmdOpcodes(int argc, const char **argv) {
 	// Load the opcode table from vocab.998 if it exists, to obtain the opcode names
 	Resource *r = _engine->getResMan()->findResource(ResourceId(kResourceTypeVocab, 998), 0);
@@ -954,6 +1037,43 @@ bool Console::cmdResourceTypes(int argc, const char **argv) {
 	return true;
 }
 
+bool Console::cmdResourceCache(int argc, const char **argv) {
+	ResourceManager *resMan = _engine->getResMan();
+
+	int size = 0;
+	if (argc > 2 || (argc == 2 && scumm_stricmp(argv[1], "reset") && !parseInteger(argv[1], size))) {
+		debugPrintf("Shows the resource cache statistics, resets them or sets the cache size.\n");
+		debugPrintf("Usage: %s [reset | <cache size in KB>]\n", argv[0]);
+		return true;
+	}
+
+	if (argc == 2) {
+		if (!scumm_stricmp(argv[1], "reset")) {
+			resMan->resetResourceTypeStats();
+			debugPrintf("Resource cache statistics reset\n");
+		} else if (size <= 0 || size > ResourceManager::kMaxCacheSizeKB) {
+			debugPrintf("The cache size must be between 1 and %d KB\n", ResourceManager::kMaxCacheSizeKB);
+		} else {
+			resMan->setMaxMemory(size * 1024);
+			debugPrintf("Resource cache size set to %d KB\n", resMan->getMaxMemory() / 1024);
+		}
+		return true;
+	}
+
+	debugPrintf("Cached: %d of %d KB, locked: %d KB\n", resMan->getMemoryLRU() / 1024,
+				resMan->getMaxMemory() / 1024, resMan->getMemoryLocked() / 1024);
+	debugPrintf("Type            Hits      Misses    Prefetches  Evictions  Load time (ms)\n");
+	for (int i = 0; i < kResourceTypeInvalid; i++) {
+		const ResourceManager::ResourceTypeStats &stats = resMan->getResourceTypeStats((ResourceType)i);
+		if (!stats.hits && !stats.misses && !stats.prefetches)
+			continue;
+		debugPrintf("%-14s  %-8u  %-8u  %-10u  %-9u  %u\n", getResourceTypeName((ResourceType)i),
+					stats.hits, stats.misses, stats.prefetches, stats.evictions, stats.loadTime);
+	}
+
+	return true;
+}
+
 bool Console::cmdHexgrep(int argc, const char **argv) {
 	if (argc < 4) {
 		debugPrintf("Searches some resources for a particular sequence of bytes, represented as decimal or hexadecimal numbers.\n");
@@ -1958,6 +2078,80 @@ bool Console::cmdShowSavedBits(int argc, const char **argv) {
 }
 
 
+bool Console::cmdAvoidPathStats(int argc, const char **argv) {
+	PathfindingStats &stats = _engine->_gamestate->_pathfindingStats;
+
+	if (argc > 2 || (argc == 2 && scumm_stricmp(argv[1], "reset"))) {
+		debugPrintf("Shows how often pathfinding could use cached polygon sets, or resets the statistics.\n");
+		debugPrintf("Usage: %s [reset]\n", argv[0]);
+		return true;
+	}
+
+	if (argc == 2) {
+		stats.reset();
+		debugPrintf("Pathfinding statistics reset\n");
+		return true;
+	}
+
+	debugPrintf("Pathfinding calls: %u, %u with a cached polygon set, %u with a new one\n",
+				stats.calls, stats.graphHits, stats.graphMisses);
+	debugPrintf("Visibility tests: %u, %u taken from the cache\n", stats.visibilityTests, stats.cachedTests);
+	debugPrintf("Cached polygon sets: %u\n", _engine->_gamestate->_visibilityGraphs.size());
+	return true;
+}
+
+bool Console::cmdGfxCache(int argc, const char **argv) {
+	GfxCache *cache = _engine->_gfxCache;
+
+	if (argc > 1) {
+		if (!scumm_stricmp(argv[1], "reset")) {
+			cache->resetStats();
+			debugPrintf("View and font cache statistics reset\n");
+			return true;
+		} else if (!scumm_stricmp(argv[1], "views") && argc == 4) {
+			int count, size;
+			if (!parseInteger(argv[2], count) || !parseInteger(argv[3], size))
+				return true;
+
+			if (count < 1 || size < 1 || (uint)size > 0xFFFFFFFF / 1024) {
+				debugPrintf("The view cache needs room for at least 1 view and 1 KB\n");
+				return true;
+			}
+
+			cache->setViewCacheLimits(count, size * 1024);
+			debugPrintf("View cache limits set to %d views, %d KB\n", cache->getMaxViews(), cache->getMaxViewMemory() / 1024);
+			return true;
+		} else if (!scumm_stricmp(argv[1], "fonts") && argc == 3) {
+			int count;
+			if (!parseInteger(argv[2], count))
+				return true;
+
+			if (count < 1) {
+				debugPrintf("The font cache needs room for at least 1 font\n");
+				return true;
+			}
+
+			cache->setFontCacheLimit(count);
+			debugPrintf("Font cache limit set to %d fonts\n", cache->getMaxFonts());
+			return true;
+		}
+
+		debugPrintf("Shows the view and font cache statistics, resets them or sets the cache limits.\n");
+		debugPrintf("Usage: %s [reset | views <count> <size in KB> | fonts <count>]\n", argv[0]);
+		return true;
+	}
+
+	const GfxCacheStats &viewStats = cache->getViewStats();
+	const GfxCacheStats &fontStats = cache->getFontStats();
+	debugPrintf("Views: %d of %d, %d of %d KB, hits: %u, misses: %u, evictions: %u\n",
+				cache->getViewCount(), cache->getMaxViews(), cache->getViewMemory() / 1024, cache->getMaxViewMemory() / 1024,
+				viewStats.hits, viewStats.misses, viewStats.evictions);
+	debugPrintf("Fonts: %d of %d, hits: %u, misses: %u, evictions: %u\n",
+				cache->getFontCount(), cache->getMaxFonts(), fontStats.hits, fontStats.misses, fontStats.evictions);
+
+	return true;
+}
+
 bool Console::cmdParseGrammar(int argc, const char **argv) {
 	debugPrintf("Parse grammar, in strict GNF:\n");
 
@@ -2355,6 +2549,34 @@ bool Console::cmdGCInvoke(int argc, const char **argv) {
 	return true;
 }
 
+bool Console::cmdGCStats(int argc, const char **argv) {
+	GCStats &stats = _engine->_gamestate->_gcStats;
+
+	if (argc > 2 || (argc == 2 && scumm_stricmp(argv[1], "reset"))) {
+		debugPrintf("Shows how long garbage collection pauses the game, or resets the statistics.\n");
+		debugPrintf("Usage: %s [reset]\n", argv[0]);
+		return true;
+	}
+
+	if (argc == 2) {
+		stats.reset();
+		debugPrintf("Garbage collection statistics reset\n");
+		return true;
+	}
+
+	debugPrintf("Collections: %u, %u of them after a frame which left time\n", stats.runs, stats.idleRuns);
+	debugPrintf("Pause time: %u ms total, %u ms average, %u ms maximum, %u ms last\n",
+				stats.totalTime, stats.runs ? stats.totalTime / stats.runs : 0, stats.maxTime, stats.lastTime);
+	debugPrintf("Freed: %u, reachable in the last collection: %u\n", stats.freed, stats.lastReachable);
+	// The count goes below 0 while the collection waits for a frame with
+	// time to spare
+	if (_engine->_gamestate->gcCountDown > 0 && !_engine->_gamestate->_gcRequested)
+		debugPrintf("Kernel calls until the next collection: %d\n", _engine->_gamestate->gcCountDown);
+	else
+		debugPrintf("Kernel calls until the next collection: pending\n");
+	return true;
+}
+
 bool Console::cmdGCObjects(int argc, const char **argv) {
 	AddrSet *use_map = findAllActiveReferences(_engine->_gamestate);
 
@@ -53,6 +53,8 @@ private:
 	// Kernel
 //	bool cmdClasses(int argc, const char **argv);	// TODO
 	bool cmdOpcodes(int argc, const char **argv);
+	bool cmdVMProfile(int argc, const char **argv);
+	bool cmdAvoidPathStats(int argc, const char **argv);
 	bool cmdSelector(int argc, const char **argv);
 	bool cmdSelectors(int argc, const char **argv);
 	bool cmdKernelFunctions(int argc, const char **argv);
@@ -73,6 +75,7 @@ private:
 	bool cmdResourceId(int argc, const char **argv);
 	bool cmdResourceInfo(int argc, const char **argv);
 	bool cmdResourceTypes(int argc, const char **argv);
+	bool cmdResourceCache(int argc, const char **argv);
 	bool cmdList(int argc, const char **argv);
 	bool cmdHexgrep(int argc, const char **argv);
 	bool cmdVerifyScripts(int argc, const char **argv);
@@ -99,12 +102,14 @@ private:
 	bool cmdPlaneItemList(int argc, const char **argv);
 	bool cmdSavedBits(int argc, const char **argv);
 	bool cmdShowSavedBits(int argc, const char **argv);
+	bool cmdGfxCache(int argc, const char **argv);
 	// Segments
 	bool cmdPrintSegmentTable(int argc, const char **argv);
 	bool cmdSegmentInfo(int argc, const char **argv);
 	bool cmdKillSegment(int argc, const char **argv);
 	// Garbage collection
 	bool cmdGCInvoke(int argc, const char **argv);
+	bool cmdGCStats(int argc, const char **argv);
 	bool cmdGCObjects(int argc, const char **argv);
 	bool cmdGCShowReachable(int argc, const char **argv);
 	bool cmdGCShowFreeable(int argc, const char **argv);
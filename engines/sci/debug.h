@@ -23,6 +23,8 @@
 #ifndef SCI_DEBUG_H
 #define SCI_DEBUG_H
 
+#include "common/hashmap.h"
+#include "common/hash-str.h"
 #include "common/list.h"
 #include "sci/engine/vm_types.h"	// for StackPtr
 
@@ -60,6 +62,23 @@ enum DebugSeeking {
 	kDebugSeekStepOver = 5      // Step forward until we reach same stack-level again
 };
 
+/**
+ * Counts how often each opcode is executed, and how many instructions each
+ * method executes, to find out where scripts spend their time.
+ */
+struct ScriptProfile {
+	bool enabled;
+	uint32 opcodeCounts[128];
+	Common::HashMap<Common::String, uint32> methodCounts;
+	uint32 *currentMethod;	///< Counter of the running method, NULL if it has to be looked up
+
+	void reset() {
+		memset(opcodeCounts, 0, sizeof(opcodeCounts));
+		methodCounts.clear();
+		currentMethod = NULL;
+	}
+};
+
 struct DebugState {
 	bool debugging;
 	bool breakpointWasHit;
@@ -72,6 +91,7 @@ struct DebugState {
 	StackPtr old_sp;
 	Common::List<Breakpoint> _breakpoints;   //< List of breakpoints
 	int _activeBreakpointTypes;  //< Bit mask specifying which types of breakpoints are active
+	ScriptProfile _profile;
 };
 
 // Various global variables used for debugging are declared here
@@ -22,6 +22,7 @@
 
 #include "sci/engine/gc.h"
 #include "common/array.h"
+#include "common/system.h"
 #include "sci/graphics/ports.h"
 
 namespace Sci {
@@ -162,6 +163,9 @@ AddrSet *findAllActiveReferences(EngineState *s) {
 
 void run_gc(EngineState *s) {
 	SegManager *segMan = s->_segMan;
+	const uint32 startTime = g_system->getMillis();
+	s->gcCountDown = s->scriptGCInterval;
+	s->_gcRequested = false;
 
 	// Some debug stuff
 	debugC(kDebugLevelGC, "[GC] Running...");
@@ -174,6 +178,7 @@ void run_gc(EngineState *s) {
 
 	// Compute the set of all segments references currently in use.
 	AddrSet *activeRefs = findAllActiveReferences(s);
+	s->_gcStats.lastReachable = activeRefs->size();
 
 	// Iterate over all segments, and check for each whether it
 	// contains stuff that can be collected.
@@ -195,6 +200,7 @@ void run_gc(EngineState *s) {
 				if (!activeRefs->contains(addr)) {
 					// Not found -> we can free it
 					mobj->freeAtAddress(segMan, addr);
+					s->_gcStats.freed++;
 					debugC(kDebugLevelGC, "[GC] Deallocating %04x:%04x", PRINT_REG(addr));
 #ifdef GC_DEBUG_CODE
 					segcount[type]++;
@@ -207,6 +213,13 @@ void run_gc(EngineState *s) {
 
 	delete activeRefs;
 
+	const uint32 time = g_system->getMillis() - startTime;
+	s->_gcStats.runs++;
+	s->_gcStats.totalTime += time;
+	s->_gcStats.lastTime = time;
+	s->_gcStats.maxTime = MAX(s->_gcStats.maxTime, time);
+	debugC(kDebugLevelGC, "[GC] Done in %d ms", time);
+
 #ifdef GC_DEBUG_CODE
 	// Output debug summary of garbage collection
 	debugC(kDebugLevelGC, "[GC] Summary:");
@@ -111,10 +111,20 @@ struct Vertex {
 	// Previous vertex in shortest path
 	Vertex *path_prev;
 
+	// A* set membership
+	bool inOpenSet;
+	bool inClosedSet;
+
+	// Index in the visibility graph, or -1 for single-vertex polygons
+	int graphIndex;
+
 public:
 	Vertex(const Common::Point &p) : v(p) {
 		costG = HUGE_DISTANCE;
 		path_prev = NULL;
+		inOpenSet = false;
+		inClosedSet = false;
+		graphIndex = -1;
 	}
 };
 
@@ -257,6 +267,14 @@ struct PathfindingState {
 	// Screen size
 	int _width, _height;
 
+	// Cached visibility between the polygon vertices, and its size
+	VisibilityGraph *_graph;
+	int _graphVertices;
+
+	// Number of vertex pairs tested for visibility, and taken from the cache
+	uint32 _visibilityTests;
+	uint32 _cachedTests;
+
 	PathfindingState(int width, int height) : _width(width), _height(height) {
 		vertex_start = NULL;
 		vertex_end = NULL;
@@ -264,6 +282,10 @@ struct PathfindingState {
 		_prependPoint = NULL;
 		_appendPoint = NULL;
 		vertices = 0;
+		_graph = NULL;
+		_graphVertices = 0;
+		_visibilityTests = 0;
+		_cachedTests = 0;
 	}
 
 	~PathfindingState() {
@@ -659,8 +681,65 @@ static int inside(const Common::Point &p, Vertex *vertex) {
 	return 0;
 }
 
+enum {
+	kVisibilityUnknown = 0,
+	kVisibilityVisible = 1,
+	kVisibilityHidden = 2
+};
+
+/**
+ * Determines whether the line between two vertices passes through any polygon.
+ * The result does not depend on the order of the two vertices.
+ * @param s				the pathfinding state
+ * @param vertex_cur	the first vertex
+ * @param vertex		the second vertex
+ * @return true if the vertices can see each other, false otherwise
+ */
+static bool vertex_visible(PathfindingState *s, Vertex *vertex_cur, Vertex *vertex) {
+	s->_visibilityTests++;
+
+	// Make sure we don't intersect a polygon locally at the vertices
+	if ((inside(vertex->v, vertex_cur)) || (inside(vertex_cur->v, vertex)))
+		return false;
+
+	const int16 minX = MIN(vertex_cur->v.x, vertex->v.x);
+	const int16 maxX = MAX(vertex_cur->v.x, vertex->v.x);
+	const int16 minY = MIN(vertex_cur->v.y, vertex->v.y);
+	const int16 maxY = MAX(vertex_cur->v.y, vertex->v.y);
+
+	// Check for intersecting edges
+	for (int j = 0; j < s->vertices; j++) {
+		Vertex *edge = s->vertex_index[j];
+		if (VERTEX_HAS_EDGES(edge)) {
+			const Common::Point &p = edge->v;
+			const Common::Point &q = CLIST_NEXT(edge)->v;
+
+			// Edges outside of the bounding box of the line can neither
+			// touch nor intersect it
+			if ((MAX(p.x, q.x) < minX) || (MIN(p.x, q.x) > maxX) || (MAX(p.y, q.y) < minY) || (MIN(p.y, q.y) > maxY))
+				continue;
+
+			if (between(vertex_cur->v, vertex->v, p)) {
+				// If we hit a vertex, make sure we can pass through it without intersecting its polygon
+				if ((inside(vertex_cur->v, edge)) || (inside(vertex->v, edge)))
+					return false;
+
+				// This edge won't properly intersect, so we continue
+				continue;
+			}
+
+			if (intersect_proper(vertex_cur->v, vertex->v, p, q))
+				return false;
+		}
+	}
+
+	return true;
+}
+
 /**
  * Returns a list of all vertices that are visible from a particular vertex.
+ * The visibility between two polygon vertices is taken from the visibility
+ * graph, if it has been tested before.
  * @param s				the pathfinding state
  * @param vertex_cur	the vertex
  * @return list of vertices that are visible from vert
@@ -671,30 +750,27 @@ static VertexList *visible_vertices(PathfindingState *s, Vertex *vertex_cur) {
 	for (int i = 0; i < s->vertices; i++) {
 		Vertex *vertex = s->vertex_index[i];
 
-		// Make sure we don't intersect a polygon locally at the vertices
-		if ((vertex == vertex_cur) || (inside(vertex->v, vertex_cur)) || (inside(vertex_cur->v, vertex)))
+		if (vertex == vertex_cur)
 			continue;
 
-		// Check for intersecting edges
-		int j;
-		for (j = 0; j < s->vertices; j++) {
-			Vertex *edge = s->vertex_index[j];
-			if (VERTEX_HAS_EDGES(edge)) {
-				if (between(vertex_cur->v, vertex->v, edge->v)) {
-					// If we hit a vertex, make sure we can pass through it without intersecting its polygon
-					if ((inside(vertex_cur->v, edge)) || (inside(vertex->v, edge)))
-						break;
-
-					// This edge won't properly intersect, so we continue
-					continue;
-				}
+		bool visible;
 
-				if (intersect_proper(vertex_cur->v, vertex->v, edge->v, CLIST_NEXT(edge)->v))
-					break;
+		if (s->_graph && vertex_cur->graphIndex >= 0 && vertex->graphIndex >= 0) {
+			byte &entry = s->_graph->visibility[vertex_cur->graphIndex * s->_graphVertices + vertex->graphIndex];
+
+			if (entry == kVisibilityUnknown) {
+				entry = vertex_visible(s, vertex_cur, vertex) ? kVisibilityVisible : kVisibilityHidden;
+				s->_graph->visibility[vertex->graphIndex * s->_graphVertices + vertex_cur->graphIndex] = entry;
+			} else {
+				s->_cachedTests++;
 			}
+
+			visible = (entry == kVisibilityVisible);
+		} else {
+			visible = vertex_visible(s, vertex_cur, vertex);
 		}
 
-		if (j == s->vertices)
+		if (visible)
 			visVerts->push_front(vertex);
 	}
 
@@ -1302,6 +1378,80 @@ static PathfindingState *convert_polygon_set(EngineState *s, reg_t poly_list, Co
 	return pf_s;
 }
 
+// Number of polygon sets of which the visibility graph is kept
+#define MAX_VISIBILITY_GRAPHS 4
+
+/**
+ * Looks up the visibility graph of the polygon set in the pathfinding state,
+ * or creates an empty one if the polygon set hasn't been seen before. The
+ * start and end points only become part of the graph if they lie on a
+ * polygon, otherwise their visibility is tested on every call.
+ * Parameters: (EngineState *) s: The game state
+ *             (PathfindingState *) p: The pathfinding state
+ */
+static void attach_visibility_graph(EngineState *s, PathfindingState *p) {
+	PathfindingStats &stats = s->_pathfindingStats;
+	int count = 0;
+
+	for (int i = 0; i < p->vertices; i++) {
+		Vertex *vertex = p->vertex_index[i];
+		if (VERTEX_HAS_EDGES(vertex))
+			vertex->graphIndex = count++;
+	}
+
+	if (!count)
+		return;
+
+	Common::Array<int16> signature;
+	signature.reserve(count * 3);
+	uint32 hash = 0;
+
+	for (int i = 0; i < p->vertices; i++) {
+		Vertex *vertex = p->vertex_index[i];
+		if (vertex->graphIndex < 0)
+			continue;
+
+		signature.push_back(vertex->v.x);
+		signature.push_back(vertex->v.y);
+		signature.push_back(CLIST_NEXT(vertex)->graphIndex);
+		hash = hash * 31 + (uint16)vertex->v.x;
+		hash = hash * 31 + (uint16)vertex->v.y;
+		hash = hash * 31 + CLIST_NEXT(vertex)->graphIndex;
+	}
+
+	uint oldest = 0;
+
+	for (uint i = 0; i < s->_visibilityGraphs.size(); i++) {
+		VisibilityGraph &graph = s->_visibilityGraphs[i];
+		if (graph.hash == hash && graph.signature == signature) {
+			graph.lastUsed = ++s->_visibilityGraphCounter;
+			p->_graph = &graph;
+			p->_graphVertices = count;
+			stats.graphHits++;
+			return;
+		}
+
+		if (graph.lastUsed < s->_visibilityGraphs[oldest].lastUsed)
+			oldest = i;
+	}
+
+	if (s->_visibilityGraphs.size() < MAX_VISIBILITY_GRAPHS) {
+		s->_visibilityGraphs.push_back(VisibilityGraph());
+		oldest = s->_visibilityGraphs.size() - 1;
+	}
+
+	VisibilityGraph &graph = s->_visibilityGraphs[oldest];
+	graph.hash = hash;
+	graph.lastUsed = ++s->_visibilityGraphCounter;
+	graph.signature = signature;
+	graph.visibility.resize(count * count);
+	memset(graph.visibility.begin(), kVisibilityUnknown, count * count);
+
+	p->_graph = &graph;
+	p->_graphVertices = count;
+	stats.graphMisses++;
+}
+
 /**
  * Computes a shortest path from vertex_start to vertex_end. The caller can
  * construct the resulting path by following the path_prev links from
@@ -1310,13 +1460,17 @@ static PathfindingState *convert_polygon_set(EngineState *s, reg_t poly_list, Co
  * Parameters: (PathfindingState *) s: The pathfinding state
  */
 static void AStar(PathfindingState *s) {
-	// Vertices of which the shortest path is known
-	VertexList closedSet;
-
-	// The remaining vertices
+	// The vertices of which the shortest path isn't known yet. Vertices
+	// of which it is known have inClosedSet set.
 	VertexList openSet;
 
+	// WORKAROUND: The screen edge check below fails in QFG1VGA, room 81
+	// (bug report #3568452). See below for details.
+	const bool qfg1VgaWorkaround = (g_sci->getGameId() == GID_QFG1VGA &&
+									g_sci->getEngineState()->currentRoomNumber() == 81);
+
 	openSet.push_front(s->vertex_start);
+	s->vertex_start->inOpenSet = true;
 	s->vertex_start->costG = 0;
 	s->vertex_start->costF = (uint32)sqrt((float)s->vertex_start->v.sqrDist(s->vertex_end->v));
 
@@ -1342,7 +1496,8 @@ static void AStar(PathfindingState *s) {
 			break;
 
 		// Move vertex from set open to set closed
-		closedSet.push_front(vertex_min);
+		vertex_min->inClosedSet = true;
+		vertex_min->inOpenSet = false;
 		openSet.erase(vertex_min_it);
 
 		VertexList *visVerts = visible_vertices(s, vertex_min);
@@ -1351,11 +1506,13 @@ static void AStar(PathfindingState *s) {
 			uint32 new_dist;
 			Vertex *vertex = *it;
 
-			if (closedSet.contains(vertex))
+			if (vertex->inClosedSet)
 				continue;
 
-			if (!openSet.contains(vertex))
+			if (!vertex->inOpenSet) {
 				openSet.push_front(vertex);
+				vertex->inOpenSet = true;
+			}
 
 			new_dist = vertex_min->costG + (uint32)sqrt((float)vertex_min->v.sqrDist(vertex->v));
 
@@ -1372,9 +1529,6 @@ static void AStar(PathfindingState *s) {
 			// add this workaround for that scene in QFG1VGA, until our algorithm matches
 			// better what SSCI is doing. With this workaround, QFG1VGA no longer freezes
 			// in that scene.
-			bool qfg1VgaWorkaround = (g_sci->getGameId() == GID_QFG1VGA &&
-									  g_sci->getEngineState()->currentRoomNumber() == 81);
-
 			if (s->pointOnScreenBorder(vertex->v) && !qfg1VgaWorkaround)
 				new_dist += 10000;
 
@@ -1563,9 +1717,15 @@ reg_t kAvoidPath(EngineState *s, int argc, reg_t *argv) {
 			return output;
 		}
 
+		attach_visibility_graph(s, p);
+		s->_pathfindingStats.calls++;
+
 		// Apply Dijkstra
 		AStar(p);
 
+		s->_pathfindingStats.visibilityTests += p->_visibilityTests;
+		s->_pathfindingStats.cachedTests += p->_cachedTests;
+
 		output = output_path(p, s);
 		delete p;
 
@@ -42,6 +42,12 @@ reg_t kLoad(EngineState *s, int argc, reg_t *argv) {
 	if (restype == kResourceTypeMemory)
 		return s->_segMan->allocateHunkEntry("kLoad()", resnr);
 
+	// Scripts load the resources they are about to use, usually when a room
+	// is initialized. The original interpreter read them into memory right
+	// away, so do the same if prefetching is enabled, instead of reading them
+	// once they are drawn or played.
+	g_sci->getResMan()->prefetchResource(ResourceId(restype, resnr));
+
 	return make_reg(0, ((restype << 11) | resnr)); // Return the resource identifier as handle
 }
 
@@ -32,6 +32,9 @@ SegManager::SegManager(ResourceManager *resMan, ScriptPatcher *scriptPatcher)
 	: _resMan(resMan), _scriptPatcher(scriptPatcher) {
 	_heap.push_back(0);
 
+	memset(_selectorCache, 0, sizeof(_selectorCache));
+	_selectorCacheGeneration = 1;
+
 	_clonesSegId = 0;
 	_listsSegId = 0;
 	_nodesSegId = 0;
@@ -152,6 +155,8 @@ void SegManager::deallocate(SegmentId seg) {
 	if (!mobj)
 		error("Attempt to deallocate an already freed segment");
 
+	invalidateSelectorCache();
+
 	if (mobj->getType() == SEG_TYPE_SCRIPT) {
 		Script *scr = (Script *)mobj;
 		_scriptSegMap.erase(scr->getScriptNumber());
@@ -977,6 +982,7 @@ int SegManager::instantiateScript(int scriptNum) {
 			return segmentId;
 		} else {
 			scr->freeScript();
+			invalidateSelectorCache();
 		}
 	} else {
 		scr = allocateScript(scriptNum, &segmentId);
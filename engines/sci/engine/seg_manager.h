@@ -441,7 +441,35 @@ public:
 
 	const Common::Array<SegmentObj *> &getSegments() const { return _heap; }
 
+	/**
+	 * Result of a selector lookup, see lookupSelector(). The variables and
+	 * methods of an object don't change, so the results stay valid until
+	 * objects are freed, which empties the cache.
+	 */
+	struct SelectorCacheEntry {
+		uint32 generation;	///< Valid if it matches the generation of the cache
+		reg_t obj;
+		Selector selector;
+		SelectorType type;
+		int varIndex;
+		reg_t func;
+	};
+
+	SelectorCacheEntry &getSelectorCacheEntry(reg_t obj, Selector selector) {
+		return _selectorCache[(obj.getOffset() ^ (obj.getSegment() << 7) ^ (selector * 31)) & (kSelectorCacheSize - 1)];
+	}
+	bool isSelectorCacheEntryValid(const SelectorCacheEntry &entry) const { return entry.generation == _selectorCacheGeneration; }
+	void validateSelectorCacheEntry(SelectorCacheEntry &entry) const { entry.generation = _selectorCacheGeneration; }
+	void invalidateSelectorCache() { _selectorCacheGeneration++; }
+
 private:
+	enum {
+		kSelectorCacheSize = 1024	///< Number of cached selector lookups, a power of two
+	};
+
+	SelectorCacheEntry _selectorCache[kSelectorCacheSize];
+	uint32 _selectorCacheGeneration;
+
 	Common::Array<SegmentObj *> _heap;
 	Common::Array<Class> _classTable; /**< Table of all classes */
 	/** Map script ids to segment ids. */
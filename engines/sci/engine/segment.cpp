@@ -125,6 +125,7 @@ void CloneTable::freeAtAddress(SegManager *segMan, reg_t addr) {
 #endif
 
 	freeEntry(addr.getOffset());
+	segMan->invalidateSelectorCache();
 }
 
 
@@ -260,6 +260,17 @@ SelectorType lookupSelector(SegManager *segMan, reg_t obj_location, Selector sel
 	if (oldScriptHeader)
 		selectorId &= ~1;
 
+	SegManager::SelectorCacheEntry &cacheEntry = segMan->getSelectorCacheEntry(obj_location, selectorId);
+	if (segMan->isSelectorCacheEntryValid(cacheEntry) && cacheEntry.obj == obj_location && cacheEntry.selector == selectorId) {
+		if (cacheEntry.type == kSelectorVariable && varp) {
+			varp->obj = obj_location;
+			varp->varindex = cacheEntry.varIndex;
+		} else if (cacheEntry.type == kSelectorMethod && fptr) {
+			*fptr = cacheEntry.func;
+		}
+		return cacheEntry.type;
+	}
+
 	if (!obj) {
 		error("lookupSelector(): Attempt to send to non-object or invalid script. Address was %04x:%04x",
 				PRINT_REG(obj_location));
@@ -267,12 +278,18 @@ SelectorType lookupSelector(SegManager *segMan, reg_t obj_location, Selector sel
 
 	index = obj->locateVarSelector(segMan, selectorId);
 
+	segMan->validateSelectorCacheEntry(cacheEntry);
+	cacheEntry.obj = obj_location;
+	cacheEntry.selector = selectorId;
+
 	if (index >= 0) {
 		// Found it as a variable
 		if (varp) {
 			varp->obj = obj_location;
 			varp->varindex = index;
 		}
+		cacheEntry.type = kSelectorVariable;
+		cacheEntry.varIndex = index;
 		return kSelectorVariable;
 	} else {
 		// Check if it's a method, with recursive lookup in superclasses
@@ -282,12 +299,15 @@ SelectorType lookupSelector(SegManager *segMan, reg_t obj_location, Selector sel
 				if (fptr)
 					*fptr = obj->getFunction(index);
 
+				cacheEntry.type = kSelectorMethod;
+				cacheEntry.func = obj->getFunction(index);
 				return kSelectorMethod;
 			} else {
 				obj = segMan->getObject(obj->getSuperClassSelector());
 			}
 		}
 
+		cacheEntry.type = kSelectorNone;
 		return kSelectorNone;
 	}
 
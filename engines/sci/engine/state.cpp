@@ -108,6 +108,12 @@ void EngineState::reset(bool isRestoring) {
 	lastWaitTime = 0;
 
 	gcCountDown = 0;
+	_gcRequested = false;
+	_gcStats.reset();
+
+	_visibilityGraphs.clear();
+	_visibilityGraphCounter = 0;
+	_pathfindingStats.reset();
 
 	_throttleCounter = 0;
 	_throttleLastTime = 0;
@@ -138,6 +144,14 @@ void EngineState::speedThrottler(uint32 neededSleep) {
 		uint32 curTime = g_system->getMillis();
 		uint32 duration = curTime - _throttleLastTime;
 
+		// If the collection is due and this frame left time for it, let the
+		// next kernel call collect the garbage rather than one in the middle
+		// of a frame. It can't run from here, since the kernel function
+		// waiting for the next frame may still use objects which are only
+		// referenced by its arguments or by the graphics code.
+		if (duration < neededSleep && gcCountDown <= 0)
+			_gcRequested = true;
+
 		if (duration < neededSleep) {
 			g_sci->sleep(neededSleep - duration);
 			_throttleLastTime = g_system->getMillis();
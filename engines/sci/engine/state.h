@@ -95,6 +95,51 @@ struct VideoState {
 	}
 };
 
+/** Statistics about the pauses caused by garbage collection */
+struct GCStats {
+	uint32 runs;
+	uint32 idleRuns;	///< Collections run after a frame which left time for them
+	uint32 totalTime;	///< in milliseconds
+	uint32 maxTime;		///< in milliseconds
+	uint32 lastTime;	///< in milliseconds
+	uint32 freed;		///< Number of freed objects, lists, nodes etc.
+	uint32 lastReachable;	///< Number of references found reachable by the last collection
+
+	void reset() {
+		runs = idleRuns = 0;
+		totalTime = maxTime = lastTime = 0;
+		freed = lastReachable = 0;
+	}
+};
+
+/**
+ * Visibility between the vertices of a kAvoidPath polygon set. It is kept
+ * across calls, so that the visibility tests only have to be done once as
+ * long as the room's polygons stay the same.
+ */
+struct VisibilityGraph {
+	uint32 hash;
+	uint32 lastUsed;
+	/** Coordinates and successor index of each polygon vertex */
+	Common::Array<int16> signature;
+	/** Visibility of all vertex pairs, or 0 when it isn't known yet */
+	Common::Array<byte> visibility;
+};
+
+/** Statistics about the kAvoidPath visibility graph cache */
+struct PathfindingStats {
+	uint32 calls;
+	uint32 graphHits;		///< Calls with a cached polygon set
+	uint32 graphMisses;		///< Calls with a new polygon set
+	uint32 visibilityTests;	///< Vertex pairs which had to be tested
+	uint32 cachedTests;		///< Vertex pairs taken from the cache
+
+	void reset() {
+		calls = graphHits = graphMisses = 0;
+		visibilityTests = cachedTests = 0;
+	}
+};
+
 struct EngineState : public Common::Serializable {
 public:
 	EngineState(SegManager *segMan);
@@ -188,6 +233,12 @@ public:
 	void shrinkStackToBase();
 
 	int gcCountDown; /**< Number of kernel calls until next gc */
+	bool _gcRequested; /**< Run the gc at the next kernel call, as a frame left time for it */
+	GCStats _gcStats;
+
+	Common::Array<VisibilityGraph> _visibilityGraphs;
+	uint32 _visibilityGraphCounter;
+	PathfindingStats _pathfindingStats;
 
 	MessageState *_msgState;
 
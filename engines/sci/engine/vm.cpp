@@ -541,6 +541,27 @@ int readPMachineInstruction(const byte *src, byte &extOpcode, int16 opparams[4])
 	return offset;
 }
 
+static void profileInstruction(EngineState *s, Script *scr, byte opcode) {
+	ScriptProfile &profile = g_sci->_debugState._profile;
+	profile.opcodeCounts[opcode]++;
+
+	if (!profile.currentMethod) {
+		// Name the method like the backtrace does
+		const ExecStack &call = *s->xs;
+		Common::String name;
+		if (call.debugSelector != -1)
+			name = Common::String::format("%s::%s", s->_segMan->getObjectName(call.sendp), g_sci->getKernel()->getSelectorName(call.debugSelector).c_str());
+		else if (call.debugExportId != -1)
+			name = Common::String::format("script %d export %d", scr->getScriptNumber(), call.debugExportId);
+		else if (call.debugLocalCallOffset != -1)
+			name = Common::String::format("script %d call %x", scr->getScriptNumber(), call.debugLocalCallOffset);
+		else
+			name = Common::String::format("script %d", scr->getScriptNumber());
+		profile.currentMethod = &profile.methodCounts[name];
+	}
+	(*profile.currentMethod)++;
+}
+
 void run_vm(EngineState *s) {
 	assert(s);
 
@@ -603,6 +624,7 @@ void run_vm(EngineState *s) {
 			}
 			s->variables[VAR_TEMP] = s->xs->fp;
 			s->variables[VAR_PARAM] = s->xs->variables_argp;
+			g_sci->_debugState._profile.currentMethod = NULL;
 		}
 
 		if (s->abortScriptProcessing != kAbortNone)
@@ -631,6 +653,8 @@ void run_vm(EngineState *s) {
 		byte extOpcode;
 		s->xs->addr.pc.incOffset(readPMachineInstruction(scr->getBuf(s->xs->addr.pc.getOffset()), extOpcode, opparams));
 		const byte opcode = extOpcode >> 1;
+		if (g_sci->_debugState._profile.enabled)
+			profileInstruction(s, scr, opcode);
 		//debug("%s: %d, %d, %d, %d, acc = %04x:%04x, script %d, local script %d", opcodeNames[opcode], opparams[0], opparams[1], opparams[2], opparams[3], PRINT_REG(s->r_acc), scr->getScriptNumber(), local_script->getScriptNumber());
 
 #ifdef ABORT_ON_INFINITE_LOOP
@@ -851,9 +875,15 @@ void run_vm(EngineState *s) {
 		}
 
 		case op_callk: { // 0x21 (33)
-			// Run the garbage collector, if needed
-			if (s->gcCountDown-- <= 0) {
-				s->gcCountDown = s->scriptGCInterval;
+			// Run the garbage collector, if needed. Once it is due, the speed
+			// throttler requests it after the next frame which leaves time for
+			// it. Only if no frame does for another interval, it runs anyway.
+			// This has to happen before the arguments are popped off the
+			// stack, as they would not be found as references otherwise.
+			if (s->_gcRequested) {
+				run_gc(s);
+				s->_gcStats.idleRuns++;
+			} else if (s->gcCountDown-- <= -s->scriptGCInterval) {
 				run_gc(s);
 			}
 
@@ -35,7 +35,10 @@
 namespace Sci {
 
 GfxCache::GfxCache(ResourceManager *resMan, GfxScreen *screen, GfxPalette *palette)
-	: _resMan(resMan), _screen(screen), _palette(palette) {
+	: _resMan(resMan), _screen(screen), _palette(palette),
+	  _maxFonts(MAX_CACHED_FONTS), _maxViews(MAX_CACHED_VIEWS), _maxViewMemory(MAX_CACHED_VIEW_MEMORY),
+	  _useCounter(0) {
+	resetStats();
 }
 
 GfxCache::~GfxCache() {
@@ -45,8 +48,8 @@ GfxCache::~GfxCache() {
 
 void GfxCache::purgeFontCache() {
 	for (FontCache::iterator iter = _cachedFonts.begin(); iter != _cachedFonts.end(); ++iter) {
-		delete iter->_value;
-		iter->_value = 0;
+		delete iter->_value.font;
+		iter->_value.font = 0;
 	}
 
 	_cachedFonts.clear();
@@ -54,36 +57,110 @@ void GfxCache::purgeFontCache() {
 
 void GfxCache::purgeViewCache() {
 	for (ViewCache::iterator iter = _cachedViews.begin(); iter != _cachedViews.end(); ++iter) {
-		delete iter->_value;
-		iter->_value = 0;
+		delete iter->_value.view;
+		iter->_value.view = 0;
 	}
 
 	_cachedViews.clear();
 }
 
+void GfxCache::freeOldFonts(int keepFontId) {
+	while (_cachedFonts.size() > _maxFonts) {
+		FontCache::iterator oldest = _cachedFonts.end();
+		for (FontCache::iterator iter = _cachedFonts.begin(); iter != _cachedFonts.end(); ++iter) {
+			if (iter->_key != keepFontId && (oldest == _cachedFonts.end() || iter->_value.lastUsed < oldest->_value.lastUsed))
+				oldest = iter;
+		}
+		if (oldest == _cachedFonts.end())
+			break;
+
+		delete oldest->_value.font;
+		_cachedFonts.erase(oldest);
+		_fontStats.evictions++;
+	}
+}
+
+void GfxCache::freeOldViews(int keepViewId) {
+	// The size of the views grows as their cels get unpacked, so it is only
+	// summed up when a view gets added
+	uint32 memory = getViewMemory();
+
+	while (_cachedViews.size() > _maxViews || memory > _maxViewMemory) {
+		ViewCache::iterator oldest = _cachedViews.end();
+		for (ViewCache::iterator iter = _cachedViews.begin(); iter != _cachedViews.end(); ++iter) {
+			if (iter->_key != keepViewId && (oldest == _cachedViews.end() || iter->_value.lastUsed < oldest->_value.lastUsed))
+				oldest = iter;
+		}
+		if (oldest == _cachedViews.end())
+			break;
+
+		memory -= oldest->_value.view->getMemorySize();
+		delete oldest->_value.view;
+		_cachedViews.erase(oldest);
+		_viewStats.evictions++;
+	}
+}
+
+void GfxCache::setViewCacheLimits(uint maxViews, uint32 maxViewMemory) {
+	_maxViews = maxViews;
+	_maxViewMemory = maxViewMemory;
+	freeOldViews(-1);
+}
+
+void GfxCache::setFontCacheLimit(uint maxFonts) {
+	_maxFonts = maxFonts;
+}
+
+uint32 GfxCache::getViewMemory() const {
+	uint32 memory = 0;
+	for (ViewCache::const_iterator iter = _cachedViews.begin(); iter != _cachedViews.end(); ++iter)
+		memory += iter->_value.view->getMemorySize();
+	return memory;
+}
+
+void GfxCache::resetStats() {
+	memset(&_fontStats, 0, sizeof(_fontStats));
+	memset(&_viewStats, 0, sizeof(_viewStats));
+}
+
 GfxFont *GfxCache::getFont(GuiResourceId fontId) {
-	if (_cachedFonts.size() >= MAX_CACHED_FONTS)
-		purgeFontCache();
-
-	if (!_cachedFonts.contains(fontId)) {
-		// Create special SJIS font in japanese games, when font 900 is selected
-		if ((fontId == 900) && (g_sci->getLanguage() == Common::JA_JPN))
-			_cachedFonts[fontId] = new GfxFontSjis(_screen, fontId);
-		else
-			_cachedFonts[fontId] = new GfxFontFromResource(_resMan, _screen, fontId);
+	FontCache::iterator iter = _cachedFonts.find(fontId);
+	if (iter != _cachedFonts.end()) {
+		_fontStats.hits++;
+		iter->_value.lastUsed = ++_useCounter;
+		return iter->_value.font;
 	}
 
-	return _cachedFonts[fontId];
+	_fontStats.misses++;
+	CachedFont entry;
+	// Create special SJIS font in japanese games, when font 900 is selected
+	if ((fontId == 900) && (g_sci->getLanguage() == Common::JA_JPN))
+		entry.font = new GfxFontSjis(_screen, fontId);
+	else
+		entry.font = new GfxFontFromResource(_resMan, _screen, fontId);
+	entry.lastUsed = ++_useCounter;
+	_cachedFonts[fontId] = entry;
+
+	freeOldFonts(fontId);
+	return entry.font;
 }
 
 GfxView *GfxCache::getView(GuiResourceId viewId) {
-	if (_cachedViews.size() >= MAX_CACHED_VIEWS)
-		purgeViewCache();
+	ViewCache::iterator iter = _cachedViews.find(viewId);
+	if (iter != _cachedViews.end()) {
+		_viewStats.hits++;
+		iter->_value.lastUsed = ++_useCounter;
+		return iter->_value.view;
+	}
 
-	if (!_cachedViews.contains(viewId))
-		_cachedViews[viewId] = new GfxView(_resMan, _screen, _palette, viewId);
+	_viewStats.misses++;
+	CachedView entry;
+	entry.view = new GfxView(_resMan, _screen, _palette, viewId);
+	entry.lastUsed = ++_useCounter;
+	_cachedViews[viewId] = entry;
 
-	return _cachedViews[viewId];
+	freeOldViews(viewId);
+	return entry.view;
 }
 
 int16 GfxCache::kernelViewGetCelWidth(GuiResourceId viewId, int16 loopNo, int16 celNo) {
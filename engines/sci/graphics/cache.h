@@ -30,11 +30,29 @@ namespace Sci {
 class GfxFont;
 class GfxView;
 
-typedef Common::HashMap<int, GfxFont *> FontCache;
-typedef Common::HashMap<int, GfxView *> ViewCache;
+struct CachedFont {
+	GfxFont *font;
+	uint32 lastUsed;
+};
+
+struct CachedView {
+	GfxView *view;
+	uint32 lastUsed;
+};
+
+typedef Common::HashMap<int, CachedFont> FontCache;
+typedef Common::HashMap<int, CachedView> ViewCache;
+
+/** Counters of a cache, for tuning its limits */
+struct GfxCacheStats {
+	uint32 hits;
+	uint32 misses;
+	uint32 evictions;
+};
 
 /**
  * Cache class, handles caching of views/fonts
+ *  once a cache is full, the least recently used entries are freed
  */
 class GfxCache {
 public:
@@ -51,9 +69,35 @@ public:
 
 	byte kernelViewGetColorAtCoordinate(GuiResourceId viewId, int16 loopNo, int16 celNo, int16 x, int16 y);
 
+	/**
+	 * Sets the limits of the caches. Views are freed once there are more
+	 * than maxViews of them, or once they take up more than maxViewMemory
+	 * bytes together with their unpacked cels.
+	 */
+	void setViewCacheLimits(uint maxViews, uint32 maxViewMemory);
+
+	/**
+	 * Sets the number of cached fonts. Surplus fonts are only freed on the
+	 * next call to getFont(), since the font in use may be among them.
+	 */
+	void setFontCacheLimit(uint maxFonts);
+	uint getMaxViews() const { return _maxViews; }
+	uint32 getMaxViewMemory() const { return _maxViewMemory; }
+	uint getMaxFonts() const { return _maxFonts; }
+
+	uint getViewCount() const { return _cachedViews.size(); }
+	uint32 getViewMemory() const;
+	uint getFontCount() const { return _cachedFonts.size(); }
+
+	const GfxCacheStats &getViewStats() const { return _viewStats; }
+	const GfxCacheStats &getFontStats() const { return _fontStats; }
+	void resetStats();
+
 private:
 	void purgeFontCache();
 	void purgeViewCache();
+	void freeOldFonts(int keepFontId);
+	void freeOldViews(int keepViewId);
 
 	ResourceManager *_resMan;
 	GfxScreen *_screen;
@@ -61,6 +105,14 @@ private:
 
 	FontCache _cachedFonts;
 	ViewCache _cachedViews;
+
+	uint _maxFonts;
+	uint _maxViews;
+	uint32 _maxViewMemory;
+
+	uint32 _useCounter; ///< Increased on every lookup, for finding the least recently used entries
+	GfxCacheStats _fontStats;
+	GfxCacheStats _viewStats;
 };
 
 } // End of namespace Sci
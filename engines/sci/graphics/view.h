@@ -79,6 +79,9 @@ public:
 	uint16 getCelCount(int16 loopNo) const;
 	Palette *getPalette();
 
+	/** Returns the number of bytes of the view resource and the unpacked cels */
+	uint32 getMemorySize() const { return _resourceSize + _bitmapSize; }
+
 	bool isScaleable();
 	bool isSci2Hires();
 
@@ -101,6 +104,7 @@ private:
 	Resource *_resource;
 	byte *_resourceData;
 	int _resourceSize;
+	uint32 _bitmapSize;
 
 	uint16 _loopCount;
 	LoopInfo *_loop;
@@ -25,6 +25,7 @@
 #include "common/file.h"
 #include "common/fs.h"
 #include "common/macresman.h"
+#include "common/system.h"
 #include "common/textconsole.h"
 
 #include "sci/resource.h"
@@ -194,6 +195,8 @@ Resource::Resource(ResourceManager *resMan, ResourceId id) : _resMan(resMan), _i
 	_source = NULL;
 	_header = NULL;
 	_headerSize = 0;
+	_lruPrev = NULL;
+	_lruNext = NULL;
 }
 
 Resource::~Resource() {
@@ -370,7 +373,9 @@ Common::SeekableReadStream *ResourceManager::getVolumeFile(ResourceSource *sourc
 }
 
 void ResourceManager::loadResource(Resource *res) {
+	const uint32 startTime = g_system->getMillis();
 	res->_source->loadResource(this, res);
+	_stats[res->getType()].loadTime += g_system->getMillis() - startTime;
 }
 
 
@@ -863,7 +868,11 @@ ResourceManager::ResourceManager() {
 void ResourceManager::init() {
 	_memoryLocked = 0;
 	_memoryLRU = 0;
-	_LRU.clear();
+	_maxMemoryLRU = MAX_MEMORY;
+	_lruFirst = NULL;
+	_lruLast = NULL;
+	_prefetch = false;
+	resetResourceTypeStats();
 	_resMap.clear();
 	_audioMapSCI1 = NULL;
 
@@ -914,6 +923,11 @@ void ResourceManager::init() {
 
 	debugC(1, kDebugLevelResMan, "resMan: Detected %s", getSciVersionDesc(getSciVersion()));
 
+	if (getSciVersion() >= SCI_VERSION_2)
+		_maxMemoryLRU = MAX_MEMORY_SCI32;
+	else if (getSciVersion() >= SCI_VERSION_1_1)
+		_maxMemoryLRU = MAX_MEMORY_SCI11;
+
 	switch (_viewType) {
 	case kViewEga:
 		debugC(1, kDebugLevelResMan, "resMan: Detected EGA graphic resources");
@@ -949,7 +963,11 @@ void ResourceManager::initForDetection() {
 
 	_memoryLocked = 0;
 	_memoryLRU = 0;
-	_LRU.clear();
+	_maxMemoryLRU = MAX_MEMORY;
+	_lruFirst = NULL;
+	_lruLast = NULL;
+	_prefetch = false;
+	resetResourceTypeStats();
 	_resMap.clear();
 	_audioMapSCI1 = NULL;
 
@@ -981,7 +999,16 @@ void ResourceManager::removeFromLRU(Resource *res) {
 		warning("resMan: trying to remove resource that isn't enqueued");
 		return;
 	}
-	_LRU.remove(res);
+	if (res->_lruPrev)
+		res->_lruPrev->_lruNext = res->_lruNext;
+	else
+		_lruFirst = res->_lruNext;
+	if (res->_lruNext)
+		res->_lruNext->_lruPrev = res->_lruPrev;
+	else
+		_lruLast = res->_lruPrev;
+	res->_lruPrev = NULL;
+	res->_lruNext = NULL;
 	_memoryLRU -= res->size;
 	res->_status = kResStatusAllocated;
 }
@@ -991,7 +1018,13 @@ void ResourceManager::addToLRU(Resource *res) {
 		warning("resMan: trying to enqueue resource with state %d", res->_status);
 		return;
 	}
-	_LRU.push_front(res);
+	res->_lruPrev = NULL;
+	res->_lruNext = _lruFirst;
+	if (_lruFirst)
+		_lruFirst->_lruPrev = res;
+	else
+		_lruLast = res;
+	_lruFirst = res;
 	_memoryLRU += res->size;
 #if SCI_VERBOSE_RESMAN
 	debug("Adding %s.%03d (%d bytes) to lru control: %d bytes total",
@@ -1004,26 +1037,23 @@ void ResourceManager::addToLRU(Resource *res) {
 void ResourceManager::printLRU() {
 	int mem = 0;
 	int entries = 0;
-	Common::List<Resource *>::iterator it = _LRU.begin();
-	Resource *res;
 
-	while (it != _LRU.end()) {
-		res = *it;
+	for (Resource *res = _lruFirst; res; res = res->_lruNext) {
 		debug("\t%s: %d bytes", res->_id.toString().c_str(), res->size);
 		mem += res->size;
 		++entries;
-		++it;
 	}
 
 	debug("Total: %d entries, %d bytes (mgr says %d)", entries, mem, _memoryLRU);
 }
 
 void ResourceManager::freeOldResources() {
-	while (MAX_MEMORY < _memoryLRU) {
-		assert(!_LRU.empty());
-		Resource *goner = *_LRU.reverse_begin();
+	while (_maxMemoryLRU < _memoryLRU) {
+		assert(_lruLast);
+		Resource *goner = _lruLast;
 		removeFromLRU(goner);
 		goner->unalloc();
+		_stats[goner->getType()].evictions++;
 #ifdef SCI_VERBOSE_RESMAN
 		debug("resMan-debug: LRU: Freeing %s.%03d (%d bytes)", getResourceTypeName(goner->type), goner->number, goner->size);
 #endif
@@ -1049,10 +1079,14 @@ Resource *ResourceManager::findResource(ResourceId id, bool lock) {
 	if (!retval)
 		return NULL;
 
-	if (retval->_status == kResStatusNoMalloc)
+	if (retval->_status == kResStatusNoMalloc) {
+		_stats[retval->getType()].misses++;
 		loadResource(retval);
-	else if (retval->_status == kResStatusEnqueued)
-		removeFromLRU(retval);
+	} else {
+		_stats[retval->getType()].hits++;
+		if (retval->_status == kResStatusEnqueued)
+			removeFromLRU(retval);
+	}
 	// Unless an error occurred, the resource is now either
 	// locked or allocated, but never queued or freed.
 
@@ -1078,6 +1112,34 @@ Resource *ResourceManager::findResource(ResourceId id, bool lock) {
 	}
 }
 
+void ResourceManager::prefetchResource(ResourceId id) {
+	if (!_prefetch)
+		return;
+
+	// Resources which would be freed again right away aren't worth it. The
+	// size of resources is not always known before they are loaded, though.
+	Resource *res = testResource(id);
+	if (!res || res->_status != kResStatusNoMalloc || (int)res->size > _maxMemoryLRU)
+		return;
+
+	_stats[res->getType()].prefetches++;
+	loadResource(res);
+	if (res->_status == kResStatusAllocated)
+		addToLRU(res);
+
+	freeOldResources();
+}
+
+void ResourceManager::setMaxMemory(int maxMemory) {
+	// freeOldResources() can't get below an empty cache
+	_maxMemoryLRU = MAX(maxMemory, 0);
+	freeOldResources();
+}
+
+void ResourceManager::resetResourceTypeStats() {
+	memset(_stats, 0, sizeof(_stats));
+}
+
 void ResourceManager::unlockResource(Resource *res) {
 	assert(res);
 
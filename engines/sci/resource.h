@@ -25,6 +25,7 @@
 
 #include "common/str.h"
 #include "common/list.h"
+#include "common/flathashmap.h"
 #include "common/hashmap.h"
 
 #include "sci/graphics/helpers.h"		// for ViewType
@@ -273,6 +274,8 @@ protected:
 	uint16 _lockers; /**< Number of places where this resource was locked */
 	ResourceSource *_source;
 	ResourceManager *_resMan;
+	Resource *_lruPrev; /**< More recently used resource, while enqueued */
+	Resource *_lruNext; /**< Less recently used resource, while enqueued */
 
 	bool loadPatch(Common::SeekableReadStream *file);
 	bool loadFromPatchFile();
@@ -283,7 +286,8 @@ protected:
 	int readResourceInfo(ResVersion volVersion, Common::SeekableReadStream *file, uint32 &szPacked, ResourceCompression &compression);
 };
 
-typedef Common::HashMap<ResourceId, Resource *, ResourceIdHash> ResourceMap;
+// Looked up for every resource access, hence stored inline for fewer cache misses
+typedef Common::FlatHashMap<ResourceId, Resource *, ResourceIdHash> ResourceMap;
 
 class ResourceManager {
 	// FIXME: These 'friend' declarations are meant to be a temporary hack to
@@ -359,6 +363,42 @@ public:
 	 */
 	Resource *testResource(ResourceId id);
 
+	/**
+	 * Loads a resource ahead of its use, so that it is in memory when it is
+	 * looked up later on. Does nothing unless prefetching has been enabled
+	 * with setPrefetch(), or if the resource is in memory already.
+	 * @param id	Id of the resource to load
+	 */
+	void prefetchResource(ResourceId id);
+	void setPrefetch(bool prefetch) { _prefetch = prefetch; }
+
+	/** The largest resource cache size in KB which fits setMaxMemory() */
+	enum {
+		kMaxCacheSizeKB = 0x7FFFFFFF / 1024
+	};
+
+	/**
+	 * Sets the number of bytes which unlocked resources may occupy, before
+	 * the least recently used ones are freed. Negative values are treated
+	 * as 0.
+	 */
+	void setMaxMemory(int maxMemory);
+	int getMaxMemory() const { return _maxMemoryLRU; }
+	int getMemoryLRU() const { return _memoryLRU; }
+	int getMemoryLocked() const { return _memoryLocked; }
+
+	/** Resource cache statistics of a resource type */
+	struct ResourceTypeStats {
+		uint32 hits;		///< Lookups of resources which were in memory already
+		uint32 misses;		///< Lookups which had to load the resource
+		uint32 prefetches;	///< Resources loaded by prefetchResource()
+		uint32 evictions;	///< Resources freed to stay within the memory budget
+		uint32 loadTime;	///< Time spent reading and decompressing in milliseconds
+	};
+
+	const ResourceTypeStats &getResourceTypeStats(ResourceType type) const { return _stats[type]; }
+	void resetResourceTypeStats();
+
 	/**
 	 * Returns a list of all resources of the specified type.
 	 * @param type		The resource type to look for
@@ -422,19 +462,27 @@ public:
 	ResourceType convertResType(byte type);
 
 protected:
-	// Maximum number of bytes to allow being allocated for resources
+	// Default number of bytes to allow being allocated for resources
 	// Note: maxMemory will not be interpreted as a hard limit, only as a restriction
 	// for resources which are not explicitly locked. However, a warning will be
 	// issued whenever this limit is exceeded.
+	// SCI1.1 and SCI32 games have considerably larger views, pictures and audio
+	// resources, which would otherwise be freed and read again all the time.
 	enum {
-		MAX_MEMORY = 256 * 1024	// 256KB
+		MAX_MEMORY = 256 * 1024,		// 256KB
+		MAX_MEMORY_SCI11 = 2 * 1024 * 1024,	// 2MB
+		MAX_MEMORY_SCI32 = 8 * 1024 * 1024	// 8MB
 	};
 
 	ViewType _viewType; // Used to determine if the game has EGA or VGA graphics
 	Common::List<ResourceSource *> _sources;
 	int _memoryLocked;	///< Amount of resource bytes in locked memory
 	int _memoryLRU;		///< Amount of resource bytes under LRU control
-	Common::List<Resource *> _LRU; ///< Last Resource Used list
+	int _maxMemoryLRU;	///< Amount of resource bytes to keep under LRU control
+	Resource *_lruFirst;	///< Most recently used resource under LRU control
+	Resource *_lruLast;	///< Least recently used resource under LRU control
+	bool _prefetch;
+	ResourceTypeStats _stats[kResourceTypeInvalid + 1];
 	ResourceMap _resMap;
 	Common::List<Common::File *> _volumeFiles; ///< list of opened volume files
 	ResourceSource *_audioMapSCI1; ///< Currently loaded audio map for SCI1
@@ -199,12 +199,23 @@ Common::Error SciEngine::run() {
 	ConfMan.registerDefault("native_fb01", "false");
 	ConfMan.registerDefault("windows_cursors", "false");	// Windows cursors for KQ6 Windows
 	ConfMan.registerDefault("silver_cursors", "false");	// Silver cursors for SQ4 CD
+	ConfMan.registerDefault("prefetch_resources", "false");	// Load resources on kLoad already
 
 	_resMan = new ResourceManager();
 	assert(_resMan);
 	_resMan->addAppropriateSources();
 	_resMan->init();
 
+	// The resource cache size is given in KB, the default depends on the SCI version
+	if (ConfMan.hasKey("resource_cache_size")) {
+		int cacheSize = ConfMan.getInt("resource_cache_size");
+		if (cacheSize > 0 && cacheSize <= ResourceManager::kMaxCacheSizeKB)
+			_resMan->setMaxMemory(cacheSize * 1024);
+		else
+			warning("Ignoring invalid resource_cache_size %d", cacheSize);
+	}
+	_resMan->setPrefetch(ConfMan.getBool("prefetch_resources"));
+
 	// TODO: Add error handling. Check return values of addAppropriateSources
 	// and init. We first have to *add* sensible return values, though ;).
 /*
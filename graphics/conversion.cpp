@@ -25,12 +25,244 @@
 
 #include "common/endian.h"
 
+#if defined(__SSE2__) && defined(SCUMM_LITTLE_ENDIAN)
+#define CONVERSION_USE_SSE2
+#include <emmintrin.h>
+#endif
+
 namespace Graphics {
 
 // TODO: YUV to RGB conversion function
 
 namespace {
 
+/**
+ * Conversion of colors between two pixel formats with shifts and masks,
+ * for source formats whose color components have 4 to 8 bits. For these,
+ * expanding a component of n bits to 8 bits is (v << (8 - n)) | (v >> (2n - 8)),
+ * so the result is the same as of colorToARGB() and ARGBToColor(), but the
+ * same operations are done for all components, which allows converting
+ * several pixels at once.
+ */
+class ShiftConverter {
+	struct Component {
+		uint srcShift, mask, expandLeft, expandRight, dstLoss, dstShift;
+	};
+
+	Component _components[4];
+	uint _numComponents;
+	// Destination bits for a source format without alpha channel
+	uint32 _constant;
+
+	bool addComponent(uint srcBits, uint srcShift, uint dstLoss, uint dstShift) {
+		if (srcBits < 4 || srcBits > 8)
+			return false;
+
+		// Components which the destination format does not have are dropped
+		if (dstLoss >= 8)
+			return true;
+
+		Component &c = _components[_numComponents++];
+		c.srcShift = srcShift;
+		c.mask = (1 << srcBits) - 1;
+		c.expandLeft = 8 - srcBits;
+		c.expandRight = 2 * srcBits - 8;
+		c.dstLoss = dstLoss;
+		c.dstShift = dstShift;
+		return true;
+	}
+
+public:
+	ShiftConverter() : _numComponents(0), _constant(0) {}
+
+	/**
+	 * Set up the conversion.
+	 * @return false if the formats are not supported
+	 */
+	bool init(const PixelFormat &srcFmt, const PixelFormat &dstFmt) {
+		_numComponents = 0;
+		_constant = 0;
+
+		if (!addComponent(srcFmt.rBits(), srcFmt.rShift, dstFmt.rLoss, dstFmt.rShift)
+		    || !addComponent(srcFmt.gBits(), srcFmt.gShift, dstFmt.gLoss, dstFmt.gShift)
+		    || !addComponent(srcFmt.bBits(), srcFmt.bShift, dstFmt.bLoss, dstFmt.bShift))
+			return false;
+
+		if (srcFmt.aBits() == 0)
+			_constant = (0xFF >> dstFmt.aLoss) << dstFmt.aShift;
+		else if (!addComponent(srcFmt.aBits(), srcFmt.aShift, dstFmt.aLoss, dstFmt.aShift))
+			return false;
+
+		return true;
+	}
+
+	inline uint32 convert(uint32 color) const {
+		uint32 result = _constant;
+		for (uint i = 0; i < _numComponents; ++i) {
+			const Component &c = _components[i];
+			const uint32 value = (color >> c.srcShift) & c.mask;
+			const uint32 expanded = (value << c.expandLeft) | (value >> c.expandRight);
+			result |= (expanded >> c.dstLoss) << c.dstShift;
+		}
+		return result;
+	}
+
+#ifdef CONVERSION_USE_SSE2
+	/** Convert four colors, held in 32 bit lanes. */
+	inline __m128i convert(__m128i color) const {
+		__m128i result = _mm_set1_epi32(_constant);
+		for (uint i = 0; i < _numComponents; ++i) {
+			const Component &c = _components[i];
+			const __m128i value = _mm_and_si128(_mm_srl_epi32(color, _mm_cvtsi32_si128(c.srcShift)), _mm_set1_epi32(c.mask));
+			const __m128i expanded = _mm_or_si128(_mm_sll_epi32(value, _mm_cvtsi32_si128(c.expandLeft)),
+			                                      _mm_srl_epi32(value, _mm_cvtsi32_si128(c.expandRight)));
+			result = _mm_or_si128(result, _mm_sll_epi32(_mm_srl_epi32(expanded, _mm_cvtsi32_si128(c.dstLoss)), _mm_cvtsi32_si128(c.dstShift)));
+		}
+		return result;
+	}
+#endif
+};
+
+/** Read a pixel of the given size. */
+template<int bytesPerPixel>
+inline uint32 readPixel(const byte *src);
+
+template<>
+inline uint32 readPixel<2>(const byte *src) {
+	return *(const uint16 *)src;
+}
+
+template<>
+inline uint32 readPixel<3>(const byte *src) {
+	return READ_UINT24(src);
+}
+
+template<>
+inline uint32 readPixel<4>(const byte *src) {
+	return *(const uint32 *)src;
+}
+
+/** Write a pixel of the given size. */
+template<int bytesPerPixel>
+inline void writePixel(byte *dst, uint32 color);
+
+template<>
+inline void writePixel<2>(byte *dst, uint32 color) {
+	*(uint16 *)dst = color;
+}
+
+template<>
+inline void writePixel<4>(byte *dst, uint32 color) {
+	*(uint32 *)dst = color;
+}
+
+#ifdef CONVERSION_USE_SSE2
+/** Read four pixels of the given size into 32 bit lanes. */
+template<int bytesPerPixel>
+inline __m128i readFourPixels(const byte *src);
+
+template<>
+inline __m128i readFourPixels<2>(const byte *src) {
+	return _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i *)src), _mm_setzero_si128());
+}
+
+template<>
+inline __m128i readFourPixels<3>(const byte *src) {
+	return _mm_setr_epi32(READ_UINT24(src), READ_UINT24(src + 3), READ_UINT24(src + 6), READ_UINT24(src + 9));
+}
+
+template<>
+inline __m128i readFourPixels<4>(const byte *src) {
+	return _mm_loadu_si128((const __m128i *)src);
+}
+
+/** Write four pixels of the given size from 32 bit lanes. */
+template<int bytesPerPixel>
+inline void writeFourPixels(byte *dst, __m128i colors);
+
+template<>
+inline void writeFourPixels<2>(byte *dst, __m128i colors) {
+	// Sign extend the lower halves, so packing does not saturate them
+	colors = _mm_srai_epi32(_mm_slli_epi32(colors, 16), 16);
+	_mm_storel_epi64((__m128i *)dst, _mm_packs_epi32(colors, colors));
+}
+
+template<>
+inline void writeFourPixels<4>(byte *dst, __m128i colors) {
+	_mm_storeu_si128((__m128i *)dst, colors);
+}
+#endif
+
+/**
+ * Blit with a ShiftConverter. Like for crossBlitLogic, converting to a
+ * larger format goes backwards, so the conversion can be done in place.
+ * The pixels are converted in groups of four, which are read before
+ * being written, which keeps this safe.
+ */
+template<int srcBpp, int dstBpp, bool backward>
+void crossBlitShift(byte *dst, const byte *src, const uint dstPitch, const uint srcPitch,
+                    const uint w, const uint h, const ShiftConverter &converter) {
+	for (uint i = 0; i < h; ++i) {
+		const uint y = backward ? h - 1 - i : i;
+		const byte *srcRow = src + y * srcPitch;
+		byte *dstRow = dst + y * dstPitch;
+
+		if (backward) {
+			uint x = w;
+#ifdef CONVERSION_USE_SSE2
+			for (; x >= 4; x -= 4)
+				writeFourPixels<dstBpp>(dstRow + (x - 4) * dstBpp, converter.convert(readFourPixels<srcBpp>(srcRow + (x - 4) * srcBpp)));
+#endif
+			while (x--)
+				writePixel<dstBpp>(dstRow + x * dstBpp, converter.convert(readPixel<srcBpp>(srcRow + x * srcBpp)));
+		} else {
+			uint x = 0;
+#ifdef CONVERSION_USE_SSE2
+			for (; x + 4 <= w; x += 4)
+				writeFourPixels<dstBpp>(dstRow + x * dstBpp, converter.convert(readFourPixels<srcBpp>(srcRow + x * srcBpp)));
+#endif
+			for (; x < w; ++x)
+				writePixel<dstBpp>(dstRow + x * dstBpp, converter.convert(readPixel<srcBpp>(srcRow + x * srcBpp)));
+		}
+	}
+}
+
+/**
+ * Blit with a ShiftConverter, if it supports the formats.
+ * @return false if the formats are not supported
+ */
+bool crossBlitShift(byte *dst, const byte *src, const uint dstPitch, const uint srcPitch,
+                    const uint w, const uint h, const PixelFormat &dstFmt, const PixelFormat &srcFmt) {
+	ShiftConverter converter;
+	if (!converter.init(srcFmt, dstFmt))
+		return false;
+
+	switch (srcFmt.bytesPerPixel * 10 + dstFmt.bytesPerPixel) {
+	case 22:
+		crossBlitShift<2, 2, false>(dst, src, dstPitch, srcPitch, w, h, converter);
+		break;
+	case 24:
+		crossBlitShift<2, 4, true>(dst, src, dstPitch, srcPitch, w, h, converter);
+		break;
+	case 32:
+		crossBlitShift<3, 2, false>(dst, src, dstPitch, srcPitch, w, h, converter);
+		break;
+	case 34:
+		crossBlitShift<3, 4, true>(dst, src, dstPitch, srcPitch, w, h, converter);
+		break;
+	case 42:
+		crossBlitShift<4, 2, false>(dst, src, dstPitch, srcPitch, w, h, converter);
+		break;
+	case 44:
+		crossBlitShift<4, 4, false>(dst, src, dstPitch, srcPitch, w, h, converter);
+		break;
+	default:
+		return false;
+	}
+
+	return true;
+}
+
 template<typename SrcColor, typename DstColor, bool backward>
 inline void crossBlitLogic(byte *dst, const byte *src, const uint w, const uint h,
                            const PixelFormat &srcFmt, const PixelFormat &dstFmt,
@@ -126,6 +358,11 @@ bool crossBlit(byte *dst, const byte *src,
 		return true;
 	}
 
+	// Most formats can be converted with shifts and masks, several pixels
+	// at a time
+	if (crossBlitShift(dst, src, dstPitch, srcPitch, w, h, dstFmt, srcFmt))
+		return true;
+
 	// Faster, but larger, to provide optimized handling for each case.
 	const uint srcDelta = (srcPitch - w * srcFmt.bytesPerPixel);
 	const uint dstDelta = (dstPitch - w * dstFmt.bytesPerPixel);
@@ -167,4 +404,41 @@ bool crossBlit(byte *dst, const byte *src,
 	return true;
 }
 
+bool crossBlitMap(byte *dst, const byte *src,
+                  const uint dstPitch, const uint srcPitch,
+                  const uint w, const uint h,
+                  const uint dstBpp, const uint32 *map) {
+	if (dstBpp != 2 && dstBpp != 4)
+		return false;
+
+	// Go backwards, so the conversion can be done in place
+	for (uint i = h; i > 0; --i) {
+		const byte *srcRow = src + (i - 1) * srcPitch;
+		byte *dstRow = dst + (i - 1) * dstPitch;
+
+		if (dstBpp == 2) {
+			for (uint x = w; x > 0; --x)
+				((uint16 *)dstRow)[x - 1] = map[srcRow[x - 1]];
+		} else {
+			uint x = w;
+			// Look up four pixels before writing any of them
+			for (; x >= 4; x -= 4) {
+				const uint32 c0 = map[srcRow[x - 4]];
+				const uint32 c1 = map[srcRow[x - 3]];
+				const uint32 c2 = map[srcRow[x - 2]];
+				const uint32 c3 = map[srcRow[x - 1]];
+				uint32 *out = (uint32 *)dstRow + x - 4;
+				out[0] = c0;
+				out[1] = c1;
+				out[2] = c2;
+				out[3] = c3;
+			}
+			for (; x > 0; --x)
+				((uint32 *)dstRow)[x - 1] = map[srcRow[x - 1]];
+		}
+	}
+
+	return true;
+}
+
 } // End of namespace Graphics
@@ -72,6 +72,28 @@ bool crossBlit(byte *dst, const byte *src,
                const uint w, const uint h,
                const Graphics::PixelFormat &dstFmt, const Graphics::PixelFormat &srcFmt);
 
+/**
+ * Blits a rectangle of 1Bpp pixels to another format, using a table with
+ * the destination color for every pixel value.
+ *
+ * @param dst		the buffer which will recieve the converted graphics data
+ * @param src		the buffer containing the original graphics data
+ * @param dstPitch	width in bytes of one full line of the dest buffer
+ * @param srcPitch	width in bytes of one full line of the source buffer
+ * @param w			the width of the graphics data
+ * @param h			the height of the graphics data
+ * @param dstBpp	the bytes per pixel of the destination, 2 or 4
+ * @param map		the 256 destination colors
+ * @return			true if conversion completes successfully,
+ *					false if there is an error.
+ *
+ * @note This can convert a surface in place, like crossBlit.
+ */
+bool crossBlitMap(byte *dst, const byte *src,
+                  const uint dstPitch, const uint srcPitch,
+                  const uint w, const uint h,
+                  const uint dstBpp, const uint32 *map);
+
 } // End of namespace Graphics
 
 #endif // GRAPHICS_CONVERSION_H
@@ -354,6 +354,23 @@ void Surface::move(int dx, int dy, int height) {
 	}
 }
 
+/**
+ * Fill the table for crossBlitMap from a palette. Only the colors up to the
+ * highest one used by the surface are looked up, since the palette might
+ * have less than 256 entries.
+ */
+static void createPaletteMap(const Surface &surface, const byte *palette, const PixelFormat &dstFormat, uint32 *map) {
+	byte maxIndex = 0;
+	for (int y = 0; y < surface.h; y++) {
+		const byte *row = (const byte *)surface.getBasePtr(0, y);
+		for (int x = 0; x < surface.w; x++)
+			maxIndex = MAX(maxIndex, row[x]);
+	}
+
+	for (uint i = 0; i <= maxIndex; i++)
+		map[i] = dstFormat.RGBToColor(palette[i * 3], palette[i * 3 + 1], palette[i * 3 + 2]);
+}
+
 void Surface::convertToInPlace(const PixelFormat &dstFormat, const byte *palette) {
 	// Do not convert to the same format and ignore empty surfaces.
 	if (format == dstFormat || pixels == 0) {
@@ -382,26 +399,9 @@ void Surface::convertToInPlace(const PixelFormat &dstFormat, const byte *palette
 	if (format.bytesPerPixel == 1) {
 		assert(palette);
 
-		for (int y = h; y > 0; --y) {
-			const byte *srcRow = (const byte *)pixels + y * pitch - 1;
-			byte *dstRow = (byte *)pixels + y * w * dstFormat.bytesPerPixel - dstFormat.bytesPerPixel;
-
-			for (int x = 0; x < w; x++) {
-				byte index = *srcRow--;
-				byte r = palette[index * 3];
-				byte g = palette[index * 3 + 1];
-				byte b = palette[index * 3 + 2];
-
-				uint32 color = dstFormat.RGBToColor(r, g, b);
-
-				if (dstFormat.bytesPerPixel == 2)
-					*((uint16 *)dstRow) = color;
-				else
-					*((uint32 *)dstRow) = color;
-
-				dstRow -= dstFormat.bytesPerPixel;
-			}
-		}
+		uint32 map[256];
+		createPaletteMap(*this, palette, dstFormat, map);
+		crossBlitMap((byte *)pixels, (const byte *)pixels, w * dstFormat.bytesPerPixel, pitch, w, h, dstFormat.bytesPerPixel, map);
 	} else {
 		crossBlit((byte *)pixels, (const byte *)pixels, w * dstFormat.bytesPerPixel, pitch, w, h, dstFormat, format);
 	}
@@ -443,56 +443,12 @@ Graphics::Surface *Surface::convertTo(const PixelFormat &dstFormat, const byte *
 		// Converting from paletted to high color
 		assert(palette);
 
-		for (int y = 0; y < h; y++) {
-			const byte *srcRow = (const byte *)getBasePtr(0, y);
-			byte *dstRow = (byte *)surface->getBasePtr(0, y);
-
-			for (int x = 0; x < w; x++) {
-				byte index = *srcRow++;
-				byte r = palette[index * 3];
-				byte g = palette[index * 3 + 1];
-				byte b = palette[index * 3 + 2];
-
-				uint32 color = dstFormat.RGBToColor(r, g, b);
-
-				if (dstFormat.bytesPerPixel == 2)
-					*((uint16 *)dstRow) = color;
-				else
-					*((uint32 *)dstRow) = color;
-
-				dstRow += dstFormat.bytesPerPixel;
-			}
-		}
+		uint32 map[256];
+		createPaletteMap(*this, palette, dstFormat, map);
+		crossBlitMap((byte *)surface->getPixels(), (const byte *)getPixels(), surface->pitch, pitch, w, h, dstFormat.bytesPerPixel, map);
 	} else {
 		// Converting from high color to high color
-		for (int y = 0; y < h; y++) {
-			const byte *srcRow = (const byte *)getBasePtr(0, y);
-			byte *dstRow = (byte *)surface->getBasePtr(0, y);
-
-			for (int x = 0; x < w; x++) {
-				uint32 srcColor;
-				if (format.bytesPerPixel == 2)
-					srcColor = READ_UINT16(srcRow);
-				else if (format.bytesPerPixel == 3)
-					srcColor = READ_UINT24(srcRow);
-				else
-					srcColor = READ_UINT32(srcRow);
-
-				srcRow += format.bytesPerPixel;
-
-				// Convert that color to the new format
-				byte r, g, b, a;
-				format.colorToARGB(srcColor, a, r, g, b);
-				uint32 color = dstFormat.ARGBToColor(a, r, g, b);
-
-				if (dstFormat.bytesPerPixel == 2)
-					*((uint16 *)dstRow) = color;
-				else
-					*((uint32 *)dstRow) = color;
-
-				dstRow += dstFormat.bytesPerPixel;
-			}
-		}
+		crossBlit((byte *)surface->getPixels(), (const byte *)getPixels(), surface->pitch, pitch, w, h, dstFormat, format);
 	}
 
 	return surface;
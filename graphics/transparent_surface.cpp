@@ -37,6 +37,10 @@
 #include "graphics/transparent_surface.h"
 #include "graphics/transform_tools.h"
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 //#define ENABLE_BILINEAR
 
 namespace Graphics {
@@ -61,11 +65,12 @@ static const int kGIndex = 1;
 static const int kRIndex = 0;
 #endif
 
-void doBlitOpaqueFast(byte *ino, byte *outo, uint32 width, uint32 height, uint32 pitch, int32 inStep, int32 inoStep);
-void doBlitBinaryFast(byte *ino, byte *outo, uint32 width, uint32 height, uint32 pitch, int32 inStep, int32 inoStep);
-void doBlitAlphaBlend(byte *ino, byte *outo, uint32 width, uint32 height, uint32 pitch, int32 inStep, int32 inoStep, uint32 color);
-void doBlitAdditiveBlend(byte *ino, byte *outo, uint32 width, uint32 height, uint32 pitch, int32 inStep, int32 inoStep, uint32 color);
-void doBlitSubtractiveBlend(byte *ino, byte *outo, uint32 width, uint32 height, uint32 pitch, int32 inStep, int32 inoStep, uint32 color);
+#if defined(__SSE2__) && defined(SCUMM_LITTLE_ENDIAN)
+#define TS_USE_SSE2
+#endif
+
+/** The alpha channel of a pixel, read as uint32. */
+static const uint32 kAlphaMask = 0xFF << kAShift;
 
 TransparentSurface::TransparentSurface() : Surface(), _alphaMode(ALPHA_FULL) {}
 
@@ -84,10 +89,95 @@ TransparentSurface::TransparentSurface(const Surface &surf, bool copyData) : Sur
 	}
 }
 
+/**
+ * Source stepping for blits without scaling: every target pixel advances
+ * the source by the same number of bytes.
+ */
+struct BlitStepUnscaled {
+	int32 _step;
+
+	BlitStepUnscaled(int32 step) : _step(step) {}
+
+	void reset() {}
+	int32 next() { return _step; }
+	bool isContiguous() const { return _step == 4; }
+};
+
+/**
+ * Source stepping for blits with nearest neighbour scaling. Target pixel
+ * pos is taken from source pixel (pos * srcSize) / dstSize, like scale()
+ * does, but without dividing for every pixel. A negative step walks
+ * backwards from the start position, for flipped blits.
+ *
+ * Note that blit() samples this way even if ENABLE_BILINEAR is defined.
+ */
+struct BlitStepScaled {
+	int32 _step, _carryStep;
+	int _rem, _startRem, _remStep, _dstSize;
+	bool _reverse;
+
+	BlitStepScaled(int32 step, int srcSize, int dstSize, int start)
+		: _step((srcSize / dstSize) * step), _carryStep(_step + step),
+		  _startRem((start * srcSize) % dstSize), _remStep(srcSize % dstSize),
+		  _dstSize(dstSize), _reverse(step < 0) {
+		reset();
+	}
+
+	void reset() { _rem = _startRem; }
+
+	int32 next() {
+		if (_reverse) {
+			_rem -= _remStep;
+			if (_rem < 0) {
+				_rem += _dstSize;
+				return _carryStep;
+			}
+		} else {
+			_rem += _remStep;
+			if (_rem >= _dstSize) {
+				_rem -= _dstSize;
+				return _carryStep;
+			}
+		}
+		return _step;
+	}
+
+	bool isContiguous() const { return false; }
+};
+
+#ifdef TS_USE_SSE2
+/** Read the next four source pixels. */
+template<class Step>
+static inline __m128i loadFour(byte *&in, Step &inStep) {
+	const uint32 p0 = *(uint32 *)in; in += inStep.next();
+	const uint32 p1 = *(uint32 *)in; in += inStep.next();
+	const uint32 p2 = *(uint32 *)in; in += inStep.next();
+	const uint32 p3 = *(uint32 *)in; in += inStep.next();
+	return _mm_setr_epi32(p0, p1, p2, p3);
+}
+
+/** Mask of the pixels with an alpha value of 0. */
+static inline __m128i transparentMask(__m128i src) {
+	return _mm_cmpeq_epi32(_mm_and_si128(src, _mm_set1_epi32(kAlphaMask)), _mm_setzero_si128());
+}
+
+/**
+ * Blend two pixels, unpacked to 16 bits per channel, the same way as the
+ * scalar code: (in * a + out * (255 - a)) >> 8. This fits in 16 bits.
+ */
+static inline __m128i blendTwo(__m128i src, __m128i dst) {
+	__m128i alpha = _mm_shufflelo_epi16(src, _MM_SHUFFLE(kAIndex, kAIndex, kAIndex, kAIndex));
+	alpha = _mm_shufflehi_epi16(alpha, _MM_SHUFFLE(kAIndex, kAIndex, kAIndex, kAIndex));
+	const __m128i invAlpha = _mm_sub_epi16(_mm_set1_epi16(255), alpha);
+	return _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(src, alpha), _mm_mullo_epi16(dst, invAlpha)), 8);
+}
+#endif
+
 /**
  * Optimized version of doBlit to be used w/opaque blitting (no alpha).
  */
-void doBlitOpaqueFast(byte *ino, byte *outo, uint32 width, uint32 height, uint32 pitch, int32 inStep, int32 inoStep) {
+template<class Step>
+void doBlitOpaqueFast(byte *ino, byte *outo, uint32 width, uint32 height, uint32 pitch, Step inStep, Step inoStep) {
 
 	byte *in;
 	byte *out;
@@ -95,20 +185,28 @@ void doBlitOpaqueFast(byte *ino, byte *outo, uint32 width, uint32 height, uint32
 	for (uint32 i = 0; i < height; i++) {
 		out = outo;
 		in = ino;
-		memcpy(out, in, width * 4);
-		for (uint32 j = 0; j < width; j++) {
-			out[kAIndex] = 0xFF;
-			out += 4;
+		inStep.reset();
+		if (inStep.isContiguous()) {
+			for (uint32 j = 0; j < width; j++) {
+				((uint32 *)out)[j] = ((const uint32 *)in)[j] | kAlphaMask;
+			}
+		} else {
+			for (uint32 j = 0; j < width; j++) {
+				*(uint32 *)out = *(const uint32 *)in | kAlphaMask;
+				out += 4;
+				in += inStep.next();
+			}
 		}
 		outo += pitch;
-		ino += inoStep;
+		ino += inoStep.next();
 	}
 }
 
 /**
  * Optimized version of doBlit to be used w/binary blitting (blit or no-blit, no blending).
  */
-void doBlitBinaryFast(byte *ino, byte *outo, uint32 width, uint32 height, uint32 pitch, int32 inStep, int32 inoStep) {
+template<class Step>
+void doBlitBinaryFast(byte *ino, byte *outo, uint32 width, uint32 height, uint32 pitch, Step inStep, Step inoStep) {
 
 	byte *in;
 	byte *out;
@@ -116,7 +214,19 @@ void doBlitBinaryFast(byte *ino, byte *outo, uint32 width, uint32 height, uint32
 	for (uint32 i = 0; i < height; i++) {
 		out = outo;
 		in = ino;
-		for (uint32 j = 0; j < width; j++) {
+		inStep.reset();
+		uint32 j = 0;
+#ifdef TS_USE_SSE2
+		for (; j + 4 <= width; j += 4) {
+			const __m128i src = loadFour(in, inStep);
+			const __m128i dst = _mm_loadu_si128((const __m128i *)out);
+			const __m128i keep = transparentMask(src);
+			const __m128i opaque = _mm_or_si128(src, _mm_set1_epi32(kAlphaMask));
+			_mm_storeu_si128((__m128i *)out, _mm_or_si128(_mm_and_si128(keep, dst), _mm_andnot_si128(keep, opaque)));
+			out += 16;
+		}
+#endif
+		for (; j < width; j++) {
 			uint32 pix = *(uint32 *)in;
 			int a = (pix >> kAShift) & 0xff;
 
@@ -125,10 +235,10 @@ void doBlitBinaryFast(byte *ino, byte *outo, uint32 width, uint32 height, uint32
 				out[kAIndex] = 0xFF;
 			}
 			out += 4;
-			in += inStep;
+			in += inStep.next();
 		}
 		outo += pitch;
-		ino += inoStep;
+		ino += inoStep.next();
 	}
 }
 
@@ -139,11 +249,12 @@ void doBlitBinaryFast(byte *ino, byte *outo, uint32 width, uint32 height, uint32
  * @param width width of the input surface
  * @param height height of the input surface
  * @param pitch pitch of the output surface - that is, width in bytes of every row, usually bpp * width of the TARGET surface (the area we are blitting to might be smaller, do the math)
- * @inStep size in bytes to skip to address each pixel, usually bpp of the source surface
- * @inoStep width in bytes of every row on the *input* surface / kind of like pitch
+ * @inStep steps in bytes to address each pixel, usually bpp of the source surface
+ * @inoStep steps in bytes to address each row on the *input* surface / kind of like pitch
  * @color colormod in 0xAARRGGBB format - 0xFFFFFFFF for no colormod
  */
-void doBlitAlphaBlend(byte *ino, byte *outo, uint32 width, uint32 height, uint32 pitch, int32 inStep, int32 inoStep, uint32 color) {
+template<class Step>
+void doBlitAlphaBlend(byte *ino, byte *outo, uint32 width, uint32 height, uint32 pitch, Step inStep, Step inoStep, uint32 color) {
 	byte *in;
 	byte *out;
 
@@ -152,7 +263,22 @@ void doBlitAlphaBlend(byte *ino, byte *outo, uint32 width, uint32 height, uint32
 		for (uint32 i = 0; i < height; i++) {
 			out = outo;
 			in = ino;
-			for (uint32 j = 0; j < width; j++) {
+			inStep.reset();
+			uint32 j = 0;
+#ifdef TS_USE_SSE2
+			const __m128i zero = _mm_setzero_si128();
+			for (; j + 4 <= width; j += 4) {
+				const __m128i src = loadFour(in, inStep);
+				const __m128i dst = _mm_loadu_si128((const __m128i *)out);
+				const __m128i lo = blendTwo(_mm_unpacklo_epi8(src, zero), _mm_unpacklo_epi8(dst, zero));
+				const __m128i hi = blendTwo(_mm_unpackhi_epi8(src, zero), _mm_unpackhi_epi8(dst, zero));
+				const __m128i blended = _mm_or_si128(_mm_packus_epi16(lo, hi), _mm_set1_epi32(kAlphaMask));
+				const __m128i keep = transparentMask(src);
+				_mm_storeu_si128((__m128i *)out, _mm_or_si128(_mm_and_si128(keep, dst), _mm_andnot_si128(keep, blended)));
+				out += 16;
+			}
+#endif
+			for (; j < width; j++) {
 
 				if (in[kAIndex] != 0) {
 					out[kAIndex] = 255;
@@ -161,11 +287,11 @@ void doBlitAlphaBlend(byte *ino, byte *outo, uint32 width, uint32 height, uint32
 					out[kBIndex] = ((in[kBIndex] * in[kAIndex]) + out[kBIndex] * (255 - in[kAIndex])) >> 8;
 				}
 
-				in += inStep;
+				in += inStep.next();
 				out += 4;
 			}
 			outo += pitch;
-			ino += inoStep;
+			ino += inoStep.next();
 		}
 	} else {
 
@@ -177,6 +303,7 @@ void doBlitAlphaBlend(byte *ino, byte *outo, uint32 width, uint32 height, uint32
 		for (uint32 i = 0; i < height; i++) {
 			out = outo;
 			in = ino;
+			inStep.reset();
 			for (uint32 j = 0; j < width; j++) {
 
 				uint32 ina = in[kAIndex] * ca >> 8;
@@ -189,11 +316,11 @@ void doBlitAlphaBlend(byte *ino, byte *outo, uint32 width, uint32 height, uint32
 				out[kGIndex] = out[kGIndex] + (in[kGIndex] * ina * cg >> 16);
 				out[kRIndex] = out[kRIndex] + (in[kRIndex] * ina * cr >> 16);
 
-				in += inStep;
+				in += inStep.next();
 				out += 4;
 			}
 			outo += pitch;
-			ino += inoStep;
+			ino += inoStep.next();
 		}
 	}
 }
@@ -201,7 +328,8 @@ void doBlitAlphaBlend(byte *ino, byte *outo, uint32 width, uint32 height, uint32
 /**
  * Optimized version of doBlit to be used with additive blended blitting
  */
-void doBlitAdditiveBlend(byte *ino, byte *outo, uint32 width, uint32 height, uint32 pitch, int32 inStep, int32 inoStep, uint32 color) {
+template<class Step>
+void doBlitAdditiveBlend(byte *ino, byte *outo, uint32 width, uint32 height, uint32 pitch, Step inStep, Step inoStep, uint32 color) {
 	byte *in;
 	byte *out;
 
@@ -210,6 +338,7 @@ void doBlitAdditiveBlend(byte *ino, byte *outo, uint32 width, uint32 height, uin
 		for (uint32 i = 0; i < height; i++) {
 			out = outo;
 			in = ino;
+			inStep.reset();
 			for (uint32 j = 0; j < width; j++) {
 
 				if (in[kAIndex] != 0) {
@@ -218,11 +347,11 @@ void doBlitAdditiveBlend(byte *ino, byte *outo, uint32 width, uint32 height, uin
 					out[kBIndex] = MIN((in[kBIndex] * in[kAIndex] >> 8) + out[kBIndex], 255);
 				}
 
-				in += inStep;
+				in += inStep.next();
 				out += 4;
 			}
 			outo += pitch;
-			ino += inoStep;
+			ino += inoStep.next();
 		}
 	} else {
 
@@ -234,6 +363,7 @@ void doBlitAdditiveBlend(byte *ino, byte *outo, uint32 width, uint32 height, uin
 		for (uint32 i = 0; i < height; i++) {
 			out = outo;
 			in = ino;
+			inStep.reset();
 			for (uint32 j = 0; j < width; j++) {
 
 				uint32 ina = in[kAIndex] * ca >> 8;
@@ -256,11 +386,11 @@ void doBlitAdditiveBlend(byte *ino, byte *outo, uint32 width, uint32 height, uin
 					out[kRIndex] = MIN<uint>(out[kRIndex] + (in[kRIndex] * ina >> 8), 255u);
 				}
 
-				in += inStep;
+				in += inStep.next();
 				out += 4;
 			}
 			outo += pitch;
-			ino += inoStep;
+			ino += inoStep.next();
 		}
 	}
 }
@@ -268,7 +398,8 @@ void doBlitAdditiveBlend(byte *ino, byte *outo, uint32 width, uint32 height, uin
 /**
  * Optimized version of doBlit to be used with subtractive blended blitting
  */
-void doBlitSubtractiveBlend(byte *ino, byte *outo, uint32 width, uint32 height, uint32 pitch, int32 inStep, int32 inoStep, uint32 color) {
+template<class Step>
+void doBlitSubtractiveBlend(byte *ino, byte *outo, uint32 width, uint32 height, uint32 pitch, Step inStep, Step inoStep, uint32 color) {
 	byte *in;
 	byte *out;
 
@@ -277,6 +408,7 @@ void doBlitSubtractiveBlend(byte *ino, byte *outo, uint32 width, uint32 height,
 		for (uint32 i = 0; i < height; i++) {
 			out = outo;
 			in = ino;
+			inStep.reset();
 			for (uint32 j = 0; j < width; j++) {
 
 				if (in[kAIndex] != 0) {
@@ -285,11 +417,11 @@ void doBlitSubtractiveBlend(byte *ino, byte *outo, uint32 width, uint32 height,
 					out[kBIndex] = MAX(out[kBIndex] - ((in[kBIndex] * out[kBIndex]) * in[kAIndex] >> 16), 0);
 				}
 
-				in += inStep;
+				in += inStep.next();
 				out += 4;
 			}
 			outo += pitch;
-			ino += inoStep;
+			ino += inoStep.next();
 		}
 	} else {
 
@@ -300,6 +432,7 @@ void doBlitSubtractiveBlend(byte *ino, byte *outo, uint32 width, uint32 height,
 		for (uint32 i = 0; i < height; i++) {
 			out = outo;
 			in = ino;
+			inStep.reset();
 			for (uint32 j = 0; j < width; j++) {
 
 				out[kAIndex] = 255;
@@ -321,11 +454,32 @@ void doBlitSubtractiveBlend(byte *ino, byte *outo, uint32 width, uint32 height,
 					out[kRIndex] = MAX(out[kRIndex] - (in[kRIndex] * (out[kRIndex]) * in[kAIndex] >> 16), 0);
 				}
 
-				in += inStep;
+				in += inStep.next();
 				out += 4;
 			}
 			outo += pitch;
-			ino += inoStep;
+			ino += inoStep.next();
+		}
+	}
+}
+
+/**
+ * Pick the blitting function for the blend mode and alpha type.
+ */
+template<class Step>
+void doBlit(byte *ino, byte *outo, uint32 width, uint32 height, uint32 pitch, Step inStep, Step inoStep, uint32 color, TSpriteBlendMode blendMode, AlphaType alphaMode) {
+	if (color == 0xFFFFFFFF && blendMode == BLEND_NORMAL && alphaMode == ALPHA_OPAQUE) {
+		doBlitOpaqueFast(ino, outo, width, height, pitch, inStep, inoStep);
+	} else if (color == 0xFFFFFFFF && blendMode == BLEND_NORMAL && alphaMode == ALPHA_BINARY) {
+		doBlitBinaryFast(ino, outo, width, height, pitch, inStep, inoStep);
+	} else {
+		if (blendMode == BLEND_ADDITIVE) {
+			doBlitAdditiveBlend(ino, outo, width, height, pitch, inStep, inoStep, color);
+		} else if (blendMode == BLEND_SUBTRACTIVE) {
+			doBlitSubtractiveBlend(ino, outo, width, height, pitch, inStep, inoStep, color);
+		} else {
+			assert(blendMode == BLEND_NORMAL);
+			doBlitAlphaBlend(ino, outo, width, height, pitch, inStep, inoStep, color);
 		}
 	}
 }
@@ -390,76 +544,60 @@ Common::Rect TransparentSurface::blit(Graphics::Surface &target, int posX, int p
 	height = height * 2 / 3;
 #endif
 
-	Graphics::Surface *img = nullptr;
-	Graphics::Surface *imgScaled = nullptr;
-	byte *savedPixels = nullptr;
-	if ((width != srcImage.w) || (height != srcImage.h)) {
-		// Scale the image
-		img = imgScaled = srcImage.scale(width, height);
-		savedPixels = (byte *)img->getPixels();
-	} else {
-		img = &srcImage;
-	}
+	// The part of the (scaled) image which is visible on the target. Scaled
+	// images are sampled while blitting, the same way scale() would, rather
+	// than creating a scaled copy first.
+	int left = 0, top = 0;
+	int visibleW = width, visibleH = height;
 
 	// Handle off-screen clipping
 	if (posY < 0) {
-		img->h = MAX(0, (int)img->h - -posY);
-		img->setPixels((byte *)img->getBasePtr(0, -posY));
+		visibleH = MAX(0, visibleH - -posY);
+		top = -posY;
 		posY = 0;
 	}
 
 	if (posX < 0) {
-		img->w = MAX(0, (int)img->w - -posX);
-		img->setPixels((byte *)img->getBasePtr(-posX, 0));
+		visibleW = MAX(0, visibleW - -posX);
+		left = -posX;
 		posX = 0;
 	}
 
-	img->w = CLIP((int)img->w, 0, (int)MAX((int)target.w - posX, 0));
-	img->h = CLIP((int)img->h, 0, (int)MAX((int)target.h - posY, 0));
+	visibleW = CLIP(visibleW, 0, (int)MAX((int)target.w - posX, 0));
+	visibleH = CLIP(visibleH, 0, (int)MAX((int)target.h - posY, 0));
 
-	if ((img->w > 0) && (img->h > 0)) {
-		int xp = 0, yp = 0;
+	if ((visibleW > 0) && (visibleH > 0)) {
+		int xp = left, yp = top;
 
 		int inStep = 4;
-		int inoStep = img->pitch;
+		int inoStep = srcImage.pitch;
 		if (flipping & FLIP_H) {
 			inStep = -inStep;
-			xp = img->w - 1;
+			xp += visibleW - 1;
 		}
 
 		if (flipping & FLIP_V) {
 			inoStep = -inoStep;
-			yp = img->h - 1;
+			yp += visibleH - 1;
 		}
 
-		byte *ino = (byte *)img->getBasePtr(xp, yp);
 		byte *outo = (byte *)target.getBasePtr(posX, posY);
 
-		if (color == 0xFFFFFFFF && blendMode == BLEND_NORMAL && _alphaMode == ALPHA_OPAQUE) {
-			doBlitOpaqueFast(ino, outo, img->w, img->h, target.pitch, inStep, inoStep);
-		} else if (color == 0xFFFFFFFF && blendMode == BLEND_NORMAL && _alphaMode == ALPHA_BINARY) {
-			doBlitBinaryFast(ino, outo, img->w, img->h, target.pitch, inStep, inoStep);
+		if ((width != srcImage.w) || (height != srcImage.h)) {
+			byte *ino = (byte *)srcImage.getBasePtr((xp * srcImage.w) / width, (yp * srcImage.h) / height);
+			doBlit(ino, outo, visibleW, visibleH, target.pitch,
+			       BlitStepScaled(inStep, srcImage.w, width, xp), BlitStepScaled(inoStep, srcImage.h, height, yp),
+			       color, blendMode, _alphaMode);
 		} else {
-			if (blendMode == BLEND_ADDITIVE) {
-				doBlitAdditiveBlend(ino, outo, img->w, img->h, target.pitch, inStep, inoStep, color);
-			} else if (blendMode == BLEND_SUBTRACTIVE) {
-				doBlitSubtractiveBlend(ino, outo, img->w, img->h, target.pitch, inStep, inoStep, color);
-			} else {
-				assert(blendMode == BLEND_NORMAL);
-				doBlitAlphaBlend(ino, outo, img->w, img->h, target.pitch, inStep, inoStep, color);
-			}
+			byte *ino = (byte *)srcImage.getBasePtr(xp, yp);
+			doBlit(ino, outo, visibleW, visibleH, target.pitch,
+			       BlitStepUnscaled(inStep), BlitStepUnscaled(inoStep),
+			       color, blendMode, _alphaMode);
 		}
-
 	}
 
-	retSize.setWidth(img->w);
-	retSize.setHeight(img->h);
-
-	if (imgScaled) {
-		imgScaled->setPixels(savedPixels);
-		imgScaled->free();
-		delete imgScaled;
-	}
+	retSize.setWidth(visibleW);
+	retSize.setHeight(visibleH);
 
 	return retSize;
 }
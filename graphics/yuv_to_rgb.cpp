@@ -83,9 +83,15 @@
 // BASIS, AND BROWN UNIVERSITY HAS NO OBLIGATION TO PROVIDE MAINTENANCE,
 // SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
 
+#include "common/util.h"
 #include "graphics/surface.h"
 #include "graphics/yuv_to_rgb.h"
 
+#if defined(__SSE2__) && defined(SCUMM_LITTLE_ENDIAN)
+#define YUV_USE_SSE2
+#include <emmintrin.h>
+#endif
+
 namespace Common {
 DECLARE_SINGLETON(Graphics::YUVToRGBManager);
 }
@@ -159,6 +165,7 @@ YUVToRGBLookup::YUVToRGBLookup(Graphics::PixelFormat format, YUVToRGBManager::Lu
 
 YUVToRGBManager::YUVToRGBManager() {
 	_lookup = 0;
+	_useSIMD = true;
 
 	int16 *Cr_r_tab = &_colorTab[0 * 256];
 	int16 *Cr_g_tab = &_colorTab[1 * 256];
@@ -192,6 +199,201 @@ const YUVToRGBLookup *YUVToRGBManager::getLookup(Graphics::PixelFormat format, Y
 	return _lookup;
 }
 
+#ifdef YUV_USE_SSE2
+
+/**
+ * Converts eight pixels at a time with SSE2, with the same results as the
+ * lookup tables: the sum of the luminance and the chroma offset of every
+ * color component is clipped to the valid range, scaled to [0, 255] for
+ * kScaleITU, and stored in the pixel format like RGBToColor() does.
+ */
+class YUVToRGBSSE2 {
+public:
+	YUVToRGBSSE2(const Graphics::PixelFormat &format, YUVToRGBManager::LuminanceScale scale) {
+		_bytesPerPixel = format.bytesPerPixel;
+		_itu = (scale == YUVToRGBManager::kScaleITU);
+		_alpha = (0xFF >> format.aLoss) << format.aShift;
+		_loss[0] = _mm_cvtsi32_si128(format.rLoss);
+		_loss[1] = _mm_cvtsi32_si128(format.gLoss);
+		_loss[2] = _mm_cvtsi32_si128(format.bLoss);
+		_shift[0] = _mm_cvtsi32_si128(format.rShift);
+		_shift[1] = _mm_cvtsi32_si128(format.gShift);
+		_shift[2] = _mm_cvtsi32_si128(format.bShift);
+	}
+
+	/**
+	 * Convert a row of pixels, given the chroma offsets of every pixel as
+	 * indices into the lookup table like the ones of the color table.
+	 * @return the number of pixels converted, which is a multiple of 8
+	 */
+	int convertRow(byte *dst, const byte *ySrc, const int16 *rOffset, const int16 *gOffset, const int16 *bOffset, int width) const {
+		const __m128i zero = _mm_setzero_si128();
+		int x = 0;
+
+		for (; x + 8 <= width; x += 8) {
+			const __m128i y = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(ySrc + x)), zero);
+			const __m128i r = clip(_mm_add_epi16(y, _mm_sub_epi16(_mm_loadu_si128((const __m128i *)(rOffset + x)), _mm_set1_epi16(0 * 768 + 256))));
+			const __m128i g = clip(_mm_add_epi16(y, _mm_sub_epi16(_mm_loadu_si128((const __m128i *)(gOffset + x)), _mm_set1_epi16(1 * 768 + 256))));
+			const __m128i b = clip(_mm_add_epi16(y, _mm_sub_epi16(_mm_loadu_si128((const __m128i *)(bOffset + x)), _mm_set1_epi16(2 * 768 + 256))));
+
+			if (_bytesPerPixel == 2) {
+				__m128i pixels = _mm_set1_epi16((int16)_alpha);
+				pixels = _mm_or_si128(pixels, _mm_sll_epi16(_mm_srl_epi16(r, _loss[0]), _shift[0]));
+				pixels = _mm_or_si128(pixels, _mm_sll_epi16(_mm_srl_epi16(g, _loss[1]), _shift[1]));
+				pixels = _mm_or_si128(pixels, _mm_sll_epi16(_mm_srl_epi16(b, _loss[2]), _shift[2]));
+				_mm_storeu_si128((__m128i *)(dst + x * 2), pixels);
+			} else {
+				_mm_storeu_si128((__m128i *)(dst + x * 4), pack32(_mm_unpacklo_epi16(r, zero), _mm_unpacklo_epi16(g, zero), _mm_unpacklo_epi16(b, zero)));
+				_mm_storeu_si128((__m128i *)(dst + x * 4 + 16), pack32(_mm_unpackhi_epi16(r, zero), _mm_unpackhi_epi16(g, zero), _mm_unpackhi_epi16(b, zero)));
+			}
+		}
+
+		return x;
+	}
+
+private:
+	int _bytesPerPixel;
+	bool _itu;
+	uint32 _alpha;
+	__m128i _loss[3], _shift[3];
+
+	/** Clip a color component, and scale it for kScaleITU. */
+	inline __m128i clip(__m128i value) const {
+		if (!_itu)
+			return _mm_min_epi16(_mm_max_epi16(value, _mm_setzero_si128()), _mm_set1_epi16(255));
+
+		// (value - 16) * 255 / 219, written as x + x * 36 / 219, which is
+		// exact for the 220 possible values of x
+		const __m128i x = _mm_sub_epi16(_mm_min_epi16(_mm_max_epi16(value, _mm_set1_epi16(16)), _mm_set1_epi16(235)), _mm_set1_epi16(16));
+		return _mm_add_epi16(x, _mm_mulhi_epu16(x, _mm_set1_epi16(10775)));
+	}
+
+	inline __m128i pack32(__m128i r, __m128i g, __m128i b) const {
+		__m128i pixels = _mm_set1_epi32(_alpha);
+		pixels = _mm_or_si128(pixels, _mm_sll_epi32(_mm_srl_epi32(r, _loss[0]), _shift[0]));
+		pixels = _mm_or_si128(pixels, _mm_sll_epi32(_mm_srl_epi32(g, _loss[1]), _shift[1]));
+		pixels = _mm_or_si128(pixels, _mm_sll_epi32(_mm_srl_epi32(b, _loss[2]), _shift[2]));
+		return pixels;
+	}
+};
+
+/** The number of pixels whose chroma offsets are computed at once. */
+static const int kChromaChunk = 256;
+
+/** Convert a row with SSE2, and the remaining pixels with the lookup table. */
+template<typename PixelInt>
+static void convertRowSSE2(const YUVToRGBSSE2 &sse2, const uint32 *rgbToPix, byte *dstPtr, const byte *ySrc, const int16 *rOffset, const int16 *gOffset, const int16 *bOffset, int width) {
+	for (int x = sse2.convertRow(dstPtr, ySrc, rOffset, gOffset, bOffset, width); x < width; x++) {
+		const uint32 *L = &rgbToPix[ySrc[x]];
+		((PixelInt *)dstPtr)[x] = L[rOffset[x]] | L[gOffset[x]] | L[bOffset[x]];
+	}
+}
+
+template<typename PixelInt>
+void convertYUV444ToRGBSSE2(byte *dstPtr, int dstPitch, const YUVToRGBLookup *lookup, const YUVToRGBSSE2 &sse2, int16 *colorTab, const byte *ySrc, const byte *uSrc, const byte *vSrc, int yWidth, int yHeight, int yPitch, int uvPitch) {
+	const int16 *Cr_r_tab = colorTab;
+	const int16 *Cr_g_tab = Cr_r_tab + 256;
+	const int16 *Cb_g_tab = Cr_g_tab + 256;
+	const int16 *Cb_b_tab = Cb_g_tab + 256;
+	const uint32 *rgbToPix = lookup->getRGBToPix();
+
+	int16 rOffset[kChromaChunk], gOffset[kChromaChunk], bOffset[kChromaChunk];
+
+	for (int h = 0; h < yHeight; h++) {
+		for (int start = 0; start < yWidth; start += kChromaChunk) {
+			const int width = MIN(kChromaChunk, yWidth - start);
+			for (int x = 0; x < width; x++) {
+				const byte u = uSrc[start + x], v = vSrc[start + x];
+				rOffset[x] = Cr_r_tab[v];
+				gOffset[x] = Cr_g_tab[v] + Cb_g_tab[u];
+				bOffset[x] = Cb_b_tab[u];
+			}
+
+			convertRowSSE2<PixelInt>(sse2, rgbToPix, dstPtr + start * sizeof(PixelInt), ySrc + start, rOffset, gOffset, bOffset, width);
+		}
+
+		dstPtr += dstPitch;
+		ySrc += yPitch;
+		uSrc += uvPitch;
+		vSrc += uvPitch;
+	}
+}
+
+template<typename PixelInt>
+void convertYUV420ToRGBSSE2(byte *dstPtr, int dstPitch, const YUVToRGBLookup *lookup, const YUVToRGBSSE2 &sse2, int16 *colorTab, const byte *ySrc, const byte *uSrc, const byte *vSrc, int yWidth, int yHeight, int yPitch, int uvPitch) {
+	const int16 *Cr_r_tab = colorTab;
+	const int16 *Cr_g_tab = Cr_r_tab + 256;
+	const int16 *Cb_g_tab = Cr_g_tab + 256;
+	const int16 *Cb_b_tab = Cb_g_tab + 256;
+	const uint32 *rgbToPix = lookup->getRGBToPix();
+
+	int16 rOffset[kChromaChunk], gOffset[kChromaChunk], bOffset[kChromaChunk];
+
+	for (int h = 0; h < yHeight; h += 2) {
+		for (int start = 0; start < yWidth; start += kChromaChunk) {
+			const int width = MIN(kChromaChunk, yWidth - start);
+
+			// Every chroma value is used for two pixels in two rows
+			for (int x = 0; x < width; x += 2) {
+				const byte u = uSrc[(start + x) >> 1], v = vSrc[(start + x) >> 1];
+				rOffset[x] = rOffset[x + 1] = Cr_r_tab[v];
+				gOffset[x] = gOffset[x + 1] = Cr_g_tab[v] + Cb_g_tab[u];
+				bOffset[x] = bOffset[x + 1] = Cb_b_tab[u];
+			}
+
+			convertRowSSE2<PixelInt>(sse2, rgbToPix, dstPtr + start * sizeof(PixelInt), ySrc + start, rOffset, gOffset, bOffset, width);
+			convertRowSSE2<PixelInt>(sse2, rgbToPix, dstPtr + dstPitch + start * sizeof(PixelInt), ySrc + yPitch + start, rOffset, gOffset, bOffset, width);
+		}
+
+		dstPtr += dstPitch * 2;
+		ySrc += yPitch * 2;
+		uSrc += uvPitch;
+		vSrc += uvPitch;
+	}
+}
+
+template<typename PixelInt>
+void convertYUV410ToRGBSSE2(byte *dstPtr, int dstPitch, const YUVToRGBLookup *lookup, const YUVToRGBSSE2 &sse2, int16 *colorTab, const byte *ySrc, const byte *uSrc, const byte *vSrc, int yWidth, int yHeight, int yPitch, int uvPitch) {
+	const int16 *Cr_r_tab = colorTab;
+	const int16 *Cr_g_tab = Cr_r_tab + 256;
+	const int16 *Cb_g_tab = Cr_g_tab + 256;
+	const int16 *Cb_b_tab = Cb_g_tab + 256;
+	const uint32 *rgbToPix = lookup->getRGBToPix();
+
+	int16 rOffset[kChromaChunk], gOffset[kChromaChunk], bOffset[kChromaChunk];
+
+	for (int y = 0; y < yHeight; y++) {
+		const int yDiff = y & 3;
+		const byte *uRow = uSrc + (y >> 2) * uvPitch;
+		const byte *vRow = vSrc + (y >> 2) * uvPitch;
+
+		for (int start = 0; start < yWidth; start += kChromaChunk) {
+			const int width = MIN(kChromaChunk, yWidth - start);
+
+			// Bilinear interpolation of the chroma values, like in
+			// convertYUV410ToRGB
+			for (int x = 0; x < width; x++) {
+				const int index = (start + x) >> 2;
+				const int xDiff = (start + x) & 3;
+				const byte u = (uRow[index] * (4 - xDiff) * (4 - yDiff) + uRow[index + 1] * xDiff * (4 - yDiff) +
+				                uRow[index + uvPitch] * yDiff * (4 - xDiff) + uRow[index + uvPitch + 1] * xDiff * yDiff) >> 4;
+				const byte v = (vRow[index] * (4 - xDiff) * (4 - yDiff) + vRow[index + 1] * xDiff * (4 - yDiff) +
+				                vRow[index + uvPitch] * yDiff * (4 - xDiff) + vRow[index + uvPitch + 1] * xDiff * yDiff) >> 4;
+				rOffset[x] = Cr_r_tab[v];
+				gOffset[x] = Cr_g_tab[v] + Cb_g_tab[u];
+				bOffset[x] = Cb_b_tab[u];
+			}
+
+			convertRowSSE2<PixelInt>(sse2, rgbToPix, dstPtr + start * sizeof(PixelInt), ySrc + start, rOffset, gOffset, bOffset, width);
+		}
+
+		dstPtr += dstPitch;
+		ySrc += yPitch;
+	}
+}
+
+#endif
+
 #define PUT_PIXEL(s, d) \
 	L = &rgbToPix[(s)]; \
 	*((PixelInt *)(d)) = (L[cr_r] | L[crb_g] | L[cb_b])
@@ -235,6 +437,17 @@ void YUVToRGBManager::convert444(Graphics::Surface *dst, YUVToRGBManager::Lumina
 
 	const YUVToRGBLookup *lookup = getLookup(dst->format, scale);
 
+#ifdef YUV_USE_SSE2
+	if (_useSIMD) {
+		const YUVToRGBSSE2 sse2(dst->format, scale);
+		if (dst->format.bytesPerPixel == 2)
+			convertYUV444ToRGBSSE2<uint16>((byte *)dst->getPixels(), dst->pitch, lookup, sse2, _colorTab, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch);
+		else
+			convertYUV444ToRGBSSE2<uint32>((byte *)dst->getPixels(), dst->pitch, lookup, sse2, _colorTab, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch);
+		return;
+	}
+#endif
+
 	// Use a templated function to avoid an if check on every pixel
 	if (dst->format.bytesPerPixel == 2)
 		convertYUV444ToRGB<uint16>((byte *)dst->getPixels(), dst->pitch, lookup, _colorTab, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch);
@@ -274,7 +487,7 @@ void convertYUV420ToRGB(byte *dstPtr, int dstPitch, const YUVToRGBLookup *lookup
 			dstPtr += sizeof(PixelInt);
 		}
 
-		dstPtr += dstPitch;
+		dstPtr += (dstPitch << 1) - yWidth * sizeof(PixelInt);
 		ySrc += (yPitch << 1) - yWidth;
 		uSrc += uvPitch - halfWidth;
 		vSrc += uvPitch - halfWidth;
@@ -291,6 +504,17 @@ void YUVToRGBManager::convert420(Graphics::Surface *dst, YUVToRGBManager::Lumina
 
 	const YUVToRGBLookup *lookup = getLookup(dst->format, scale);
 
+#ifdef YUV_USE_SSE2
+	if (_useSIMD) {
+		const YUVToRGBSSE2 sse2(dst->format, scale);
+		if (dst->format.bytesPerPixel == 2)
+			convertYUV420ToRGBSSE2<uint16>((byte *)dst->getPixels(), dst->pitch, lookup, sse2, _colorTab, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch);
+		else
+			convertYUV420ToRGBSSE2<uint32>((byte *)dst->getPixels(), dst->pitch, lookup, sse2, _colorTab, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch);
+		return;
+	}
+#endif
+
 	// Use a templated function to avoid an if check on every pixel
 	if (dst->format.bytesPerPixel == 2)
 		convertYUV420ToRGB<uint16>((byte *)dst->getPixels(), dst->pitch, lookup, _colorTab, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch);
@@ -376,6 +600,17 @@ void YUVToRGBManager::convert410(Graphics::Surface *dst, YUVToRGBManager::Lumina
 
 	const YUVToRGBLookup *lookup = getLookup(dst->format, scale);
 
+#ifdef YUV_USE_SSE2
+	if (_useSIMD) {
+		const YUVToRGBSSE2 sse2(dst->format, scale);
+		if (dst->format.bytesPerPixel == 2)
+			convertYUV410ToRGBSSE2<uint16>((byte *)dst->getPixels(), dst->pitch, lookup, sse2, _colorTab, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch);
+		else
+			convertYUV410ToRGBSSE2<uint32>((byte *)dst->getPixels(), dst->pitch, lookup, sse2, _colorTab, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch);
+		return;
+	}
+#endif
+
 	// Use a templated function to avoid an if check on every pixel
 	if (dst->format.bytesPerPixel == 2)
 		convertYUV410ToRGB<uint16>((byte *)dst->getPixels(), dst->pitch, lookup, _colorTab, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch);
@@ -105,6 +105,13 @@ public:
 	 */
 	void convert410(Graphics::Surface *dst, LuminanceScale scale, const byte *ySrc, const byte *uSrc, const byte *vSrc, int yWidth, int yHeight, int yPitch, int uvPitch);
 
+	/**
+	 * Enable or disable the SIMD versions of the conversions, where they
+	 * are available. Both give identical results, so this is only useful
+	 * for comparing them.
+	 */
+	void setUseSIMD(bool useSIMD) { _useSIMD = useSIMD; }
+
 private:
 	friend class Common::Singleton<SingletonBaseType>;
 	YUVToRGBManager();
@@ -113,6 +120,7 @@ private:
 	const YUVToRGBLookup *getLookup(Graphics::PixelFormat format, LuminanceScale scale);
 
 	YUVToRGBLookup *_lookup;
+	bool _useSIMD;
 	int16 _colorTab[4 * 256]; // 2048 bytes
 };
 
@@ -88,6 +88,8 @@ EventRecorder::EventRecorder() {
 	_lastScreenshotTime = 0;
 	_screenshotPeriod = 0;
 	_playbackFile = 0;
+	_benchmark = false;
+	_realMillis = 0;
 
 	DebugMan.addDebugChannel(kDebugLevelEventRec, "EventRec", "Event recorder debug level");
 }
@@ -102,6 +104,7 @@ void EventRecorder::deinit() {
 	if (!_initialized) {
 		return;
 	}
+	printBenchmarkReport();
 	setFileHeader();
 	_needRedraw = false;
 	_initialized = false;
@@ -124,6 +127,8 @@ void EventRecorder::processMillis(uint32 &millis, bool skipRecord) {
 	if (!_initialized) {
 		return;
 	}
+	// The backend passes the real time, which is used for benchmarking
+	_realMillis = millis;
 	if (skipRecord) {
 		millis = _fakeTimer;
 		return;
@@ -154,6 +159,7 @@ void EventRecorder::processMillis(uint32 &millis, bool skipRecord) {
 			_timerManager->handler();
 		} else {
 			if (_nextEvent.type == Common::EVENT_RTL) {
+				printBenchmarkReport();
 				error("playback:action=stopplayback");
 			} else {
 				uint32 seconds = _fakeTimer / 1000;
@@ -261,7 +267,7 @@ Common::String EventRecorder::generateRecordFileName(const Common::String &targe
 }
 
 
-void EventRecorder::init(Common::String recordFileName, RecordMode mode) {
+void EventRecorder::init(Common::String recordFileName, RecordMode mode, bool benchmark) {
 	_fakeMixerManager = new NullSdlMixerManager();
 	_fakeMixerManager->init();
 	_fakeMixerManager->suspendAudio();
@@ -271,6 +277,17 @@ void EventRecorder::init(Common::String recordFileName, RecordMode mode) {
 	_lastScreenshotTime = 0;
 	_recordMode = mode;
 	_needcontinueGame = false;
+	_benchmark = benchmark && (mode == kRecorderPlayback);
+	_benchmarkFrames = 0;
+	_benchmarkStartMillis = 0;
+	_benchmarkFrameMillis = 0;
+	_benchmarkMaxFrameTime = 0;
+	memset(_benchmarkHistogram, 0, sizeof(_benchmarkHistogram));
+	if (_benchmark) {
+		// Don't wait for anything, so the time is only spent on the game
+		_fastPlayback = true;
+		debugC(1, kDebugLevelEventRec, "playback:action=\"Start benchmark\" filename=%s", recordFileName.c_str());
+	}
 	if (ConfMan.hasKey("disable_display")) {
 		DebugMan.enableDebugChannel("EventRec");
 		gDebugLevel = 1;
@@ -556,6 +573,54 @@ Common::SaveFileManager *EventRecorder::getSaveManager(Common::SaveFileManager *
 	}
 }
 
+void EventRecorder::countBenchmarkFrame() {
+	if (_benchmarkFrames == 0) {
+		_benchmarkStartMillis = _realMillis;
+	} else {
+		// The time since the previous screen update
+		uint32 frameTime = _realMillis - _benchmarkFrameMillis;
+		int bucket = 0;
+		while ((bucket < kBenchmarkBuckets - 1) && (frameTime >= (1U << bucket))) {
+			bucket++;
+		}
+		_benchmarkHistogram[bucket]++;
+		_benchmarkMaxFrameTime = MAX(_benchmarkMaxFrameTime, frameTime);
+	}
+	_benchmarkFrameMillis = _realMillis;
+	_benchmarkFrames++;
+}
+
+void EventRecorder::printBenchmarkReport() {
+	if (!_benchmark) {
+		return;
+	}
+	// Only report once, playback stops with an error at the end
+	_benchmark = false;
+
+	uint32 frames = (_benchmarkFrames != 0) ? _benchmarkFrames - 1 : 0;
+	uint32 time = _benchmarkFrameMillis - _benchmarkStartMillis;
+	uint32 fps = (time != 0) ? (uint32)((uint64)frames * 100000 / time) : 0;
+	debug("benchmark:frames=%d time=%d fps=%d.%.2d maxframetime=%d", frames, time, fps / 100, fps % 100, _benchmarkMaxFrameTime);
+	for (int i = 0; i < kBenchmarkBuckets; i++) {
+		if (i == 0) {
+			debug("benchmark:frametime=\"<1ms\" count=%d", _benchmarkHistogram[i]);
+		} else if (i == kBenchmarkBuckets - 1) {
+			debug("benchmark:frametime=\">=%dms\" count=%d", 1 << (i - 1), _benchmarkHistogram[i]);
+		} else if (i == 1) {
+			debug("benchmark:frametime=\"1ms\" count=%d", _benchmarkHistogram[i]);
+		} else {
+			debug("benchmark:frametime=\"%d-%dms\" count=%d", 1 << (i - 1), (1 << i) - 1, _benchmarkHistogram[i]);
+		}
+	}
+	debug("benchmark:screenshots=%d different=%d", _playbackFile->getCheckedScreenshotsCount(), _playbackFile->getDifferentScreenshotsCount());
+}
+
+void EventRecorder::processUpdateScreen() {
+	if (_benchmark && (_recordMode == kRecorderPlayback)) {
+		countBenchmarkFrame();
+	}
+}
+
 void EventRecorder::preDrawOverlayGui() {
     if ((_initialized) || (_needRedraw)) {
 		RecordMode oldMode = _recordMode;
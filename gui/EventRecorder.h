@@ -78,7 +78,14 @@ public:
 		kRecorderPlaybackPause = 3	/**< kRecordetPlaybackPause, interal state when user pauses the playback */
 	};
 
-	void init(Common::String recordFileName, RecordMode mode);
+	/**
+	 * Start recording or playing back.
+	 *
+	 * @param benchmark	play back as fast as possible and report the frame
+	 *			times and screenshot mismatches at the end. The frame
+	 *			times are wall-clock times, not CPU times.
+	 */
+	void init(Common::String recordFileName, RecordMode mode, bool benchmark = false);
 	void deinit();
 	bool processDelayMillis();
 	uint32 getRandomSeed(const Common::String &name);
@@ -87,6 +94,9 @@ public:
 	void processGameDescription(const ADGameDescription *desc);
 	Common::SeekableReadStream *processSaveStream(const Common::String & fileName);
 
+	/** Hook for every OSystem::updateScreen() call, counts the benchmark frames */
+	void processUpdateScreen();
+
 	/** Hooks for intercepting into GUI processing, so required events could be shoot
 	 *  or filtered out */
 	void preDrawOverlayGui();
@@ -229,6 +239,27 @@ private:
 	Common::String _recordFileName;
 	bool _fastPlayback;
 	bool _needRedraw;
+
+	// Benchmark mode. Frame times are measured in wall-clock time, as
+	// reported by the backend, not in CPU time. Since fast playback never
+	// waits, they include everything the game and the backend do for a
+	// frame, but also the time other processes take from it.
+
+	/** Frame times are counted in buckets up to 1, 2, 4, ... 128ms, and above */
+	enum {
+		kBenchmarkBuckets = 9
+	};
+
+	void countBenchmarkFrame();
+	void printBenchmarkReport();
+
+	bool _benchmark;
+	uint32 _realMillis;	///< Real time of the last processMillis() call
+	uint32 _benchmarkFrames;
+	uint32 _benchmarkStartMillis;
+	uint32 _benchmarkFrameMillis;
+	uint32 _benchmarkMaxFrameTime;
+	uint32 _benchmarkHistogram[kBenchmarkBuckets];
 };
 
 } // End of namespace GUI
@@ -1604,10 +1604,9 @@ bool ThemeEngine::themeConfigUsable(const Common::FSNode &node, Common::String &
 		}
 		// Delete the ZIP archive again. Note: This only works because
 		// stream.open() only uses ZipArchive::createReadStreamForMember,
-		// and that in turn happens to read all the data for a given
-		// archive member into a memory block. So there will be no dangling
-		// reference to zipArchive anywhere. This could change if we
-		// ever modify ZipArchive::createReadStreamForMember.
+		// and the streams created by it keep the data of the archive
+		// alive on their own. So there will be no dangling reference to
+		// zipArchive anywhere.
 		delete zipArchive;
 	} else if (node.isDirectory()) {
 		Common::FSNode headerfile = node.getChild("THEMERC");
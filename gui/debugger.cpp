@@ -26,6 +26,7 @@
 #include "common/debug.h"
 #include "common/debug-channels.h"
 #include "common/system.h"
+#include "common/timer.h"
 
 #ifndef DISABLE_MD5
 #include "common/md5.h"
@@ -77,6 +78,7 @@ Debugger::Debugger() {
 	registerCmd("debugflag_list",		WRAP_METHOD(Debugger, cmdDebugFlagsList));
 	registerCmd("debugflag_enable",	WRAP_METHOD(Debugger, cmdDebugFlagEnable));
 	registerCmd("debugflag_disable",	WRAP_METHOD(Debugger, cmdDebugFlagDisable));
+	registerCmd("timers",			WRAP_METHOD(Debugger, cmdTimers));
 }
 
 Debugger::~Debugger() {
@@ -681,6 +683,36 @@ bool Debugger::cmdDebugFlagDisable(int argc, const char **argv) {
 	return true;
 }
 
+bool Debugger::cmdTimers(int argc, const char **argv) {
+	Common::TimerManager *timerManager = g_system->getTimerManager();
+
+	if (argc > 2 || (argc == 2 && scumm_stricmp(argv[1], "reset"))) {
+		debugPrintf("Shows how often and how long the timer callbacks run, or resets the statistics.\n");
+		debugPrintf("Usage: %s [reset]\n", argv[0]);
+		return true;
+	}
+
+	if (argc == 2) {
+		timerManager->resetTimerStats();
+		debugPrintf("Timer statistics reset\n");
+		return true;
+	}
+
+	Common::TimerManager::TimerStatsList stats;
+	if (!timerManager->getTimerStats(stats)) {
+		debugPrintf("The timer manager does not keep statistics\n");
+		return true;
+	}
+
+	debugPrintf("Interval (us)  Calls      Late       >= 1ms     Total (ms)  Max (ms)  Name\n");
+	for (uint i = 0; i < stats.size(); i++) {
+		const Common::TimerManager::TimerStats &timer = stats[i];
+		debugPrintf("%13d  %-9u  %-9u  %-9u  %-10u  %-8u  %s\n", timer.interval, timer.calls, timer.lateCalls,
+				timer.slowCalls, timer.totalTime, timer.maxTime, timer.id.c_str());
+	}
+	return true;
+}
+
 // Console handler
 #ifndef USE_TEXT_CONSOLE_FOR_DEBUGGER
 bool Debugger::debuggerInputCallback(GUI::ConsoleDialog *console, const char *input, void *refCon) {
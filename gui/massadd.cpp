@@ -58,42 +58,15 @@ enum {
 
 
 
-MassAddDialog::MassAddDialog(const Common::FSNode &startDir)
-	: Dialog("MassAdd"),
+MassAddScanner::MassAddScanner(const Common::FSNode &startDir, bool recursive)
+	: _recursive(recursive),
 	_dirsScanned(0),
 	_oldGamesCount(0),
-	_dirTotal(0),
-	_okButton(0),
-	_dirProgressText(0),
-	_gameProgressText(0) {
-
-	StringArray l;
+	_dirTotal(0) {
 
 	// The dir we start our scan at
 	_scanStack.push(startDir);
 
-	// Removed for now... Why would you put a title on mass add dialog called "Mass Add Dialog"?
-	// new StaticTextWidget(this, "massadddialog_caption", "Mass Add Dialog");
-
-	_dirProgressText = new StaticTextWidget(this, "MassAdd.DirProgressText",
-	                                       _("... progress ..."));
-
-	_gameProgressText = new StaticTextWidget(this, "MassAdd.GameProgressText",
-	                                         _("... progress ..."));
-
-	_dirProgressText->setAlign(Graphics::kTextAlignCenter);
-	_gameProgressText->setAlign(Graphics::kTextAlignCenter);
-
-	_list = new ListWidget(this, "MassAdd.GameList");
-	_list->setEditable(false);
-	_list->setNumberingMode(kListNumberingOff);
-	_list->setList(l);
-
-	_okButton = new ButtonWidget(this, "MassAdd.Ok", _("OK"), 0, kOkCmd, Common::ASCII_RETURN);
-	_okButton->setEnabled(false);
-
-	new ButtonWidget(this, "MassAdd.Cancel", _("Cancel"), 0, kCancelCmd, Common::ASCII_ESCAPE);
-
 	// Build a map from all configured game paths to the targets using them
 	const Common::ConfigManager::DomainMap &domains = ConfMan.getGameDomains();
 	Common::ConfigManager::DomainMap::const_iterator iter;
@@ -119,6 +92,112 @@ MassAddDialog::MassAddDialog(const Common::FSNode &startDir)
 	}
 }
 
+bool MassAddScanner::scanNextDirectory() {
+	if (_scanStack.empty())
+		return false;
+
+	Common::FSNode dir = _scanStack.pop();
+
+	Common::FSList files;
+	if (!dir.getChildren(files, Common::FSNode::kListAll)) {
+		return true;
+	}
+
+	// Run the detector on the dir
+	GameList candidates(EngineMan.detectGames(files));
+
+	// Just add all detected games / game variants. If we get more than one,
+	// that either means the directory contains multiple games, or the detector
+	// could not fully determine which game variant it was seeing. In either
+	// case, let the user choose which entries he wants to keep.
+	//
+	// However, we only add games which are not already in the config file.
+	for (GameList::const_iterator cand = candidates.begin(); cand != candidates.end(); ++cand) {
+		GameDescriptor result = *cand;
+		Common::String path = dir.getPath();
+
+		// Remove trailing slashes
+		while (path != "/" && path.lastChar() == '/')
+			path.deleteLastChar();
+
+		// Check for existing config entries for this path/gameid/lang/platform combination
+		if (_pathToTargets.contains(path)) {
+			bool duplicate = false;
+			const StringArray &targets = _pathToTargets[path];
+			for (StringArray::const_iterator iter = targets.begin(); iter != targets.end(); ++iter) {
+				// If the gameid, platform and language match -> skip it
+				Common::ConfigManager::Domain *dom = ConfMan.getDomain(*iter);
+				assert(dom);
+
+				if ((*dom)["gameid"] == result["gameid"] &&
+				    (*dom)["platform"] == result["platform"] &&
+				    (*dom)["language"] == result["language"]) {
+					duplicate = true;
+					break;
+				}
+			}
+			if (duplicate) {
+				_oldGamesCount++;
+				break;	// Skip duplicates
+			}
+		}
+		result["path"] = path;
+		_games.push_back(result);
+	}
+
+	_dirsScanned++;
+
+	if (!_recursive)
+		return true;
+
+	// Recurse into all subdirs. They are pushed in reverse order, so that
+	// they are popped, and hence scanned, in alphabetical order.
+	Common::sort(files.begin(), files.end());
+	for (int i = files.size() - 1; i >= 0; --i) {
+		if (files[i].isDirectory()) {
+			_scanStack.push(files[i]);
+
+			_dirTotal++;
+		}
+	}
+
+	return true;
+}
+
+#pragma mark -
+
+MassAddDialog::MassAddDialog(const Common::FSNode &startDir)
+	: Dialog("MassAdd"),
+	_scanner(startDir),
+	_okButton(0),
+	_dirProgressText(0),
+	_gameProgressText(0) {
+
+	Common::Array<Common::String> l;
+
+	// Removed for now... Why would you put a title on mass add dialog called "Mass Add Dialog"?
+	// new StaticTextWidget(this, "massadddialog_caption", "Mass Add Dialog");
+
+	_dirProgressText = new StaticTextWidget(this, "MassAdd.DirProgressText",
+	                                       _("... progress ..."));
+
+	_gameProgressText = new StaticTextWidget(this, "MassAdd.GameProgressText",
+	                                         _("... progress ..."));
+
+	_dirProgressText->setAlign(Graphics::kTextAlignCenter);
+	_gameProgressText->setAlign(Graphics::kTextAlignCenter);
+
+	_list = new ListWidget(this, "MassAdd.GameList");
+	_list->setEditable(false);
+	_list->setNumberingMode(kListNumberingOff);
+	_list->setList(l);
+
+	_okButton = new ButtonWidget(this, "MassAdd.Ok", _("OK"), 0, kOkCmd, Common::ASCII_RETURN);
+	_okButton->setEnabled(false);
+
+	new ButtonWidget(this, "MassAdd.Cancel", _("Cancel"), 0, kCancelCmd, Common::ASCII_ESCAPE);
+}
+
 struct GameTargetLess {
 	bool operator()(const GameDescriptor &x, const GameDescriptor &y) const {
 		return x.preferredtarget().compareToIgnoreCase(y.preferredtarget()) < 0;
@@ -140,12 +219,14 @@ void MassAddDialog::handleCommand(CommandSender *sender, uint32 cmd, uint32 data
 #endif
 
 	// FIXME: It's a really bad thing that we use two arbitrary constants
+	GameList &games = _scanner.getGames();
+
 	if (cmd == kOkCmd) {
 		// Sort the detected games. This is not strictly necessary, but nice for
 		// people who want to edit their config file by hand after a mass add.
-		sort(_games.begin(), _games.end(), GameTargetLess());
+		sort(games.begin(), games.end(), GameTargetLess());
 		// Add all the detected games to the config
-		for (GameList::iterator iter = _games.begin(); iter != _games.end(); ++iter) {
+		for (GameList::iterator iter = games.begin(); iter != games.end(); ++iter) {
 			debug(1, "  Added gameid '%s', desc '%s'\n",
 				(*iter)["gameid"].c_str(),
 				(*iter)["description"].c_str());
@@ -156,15 +237,15 @@ void MassAddDialog::handleCommand(CommandSender *sender, uint32 cmd, uint32 data
 		ConfMan.flushToDisk();
 
 		// And scroll to first detected game
-		if (!_games.empty()) {
-			sort(_games.begin(), _games.end(), GameDescLess());
-			ConfMan.set("temp_selection", _games.front().gameid());
+		if (!games.empty()) {
+			sort(games.begin(), games.end(), GameDescLess());
+			ConfMan.set("temp_selection", games.front().gameid());
 		}
 
 		close();
 	} else if (cmd == kCancelCmd) {
 		// User cancelled, so we don't do anything and just leave.
-		_games.clear();
+		games.clear();
 		close();
 	} else {
 		Dialog::handleCommand(sender, cmd, data);
@@ -172,79 +253,25 @@ void MassAddDialog::handleCommand(CommandSender *sender, uint32 cmd, uint32 data
 }
 
 void MassAddDialog::handleTickle() {
-	if (_scanStack.empty())
+	if (_scanner.isFinished())
 		return;	// We have finished scanning
 
+	const GameList &games = _scanner.getGames();
 	uint32 t = g_system->getMillis();
 
-	// Perform a breadth-first scan of the filesystem.
-	while (!_scanStack.empty() && (g_system->getMillis() - t) < kMaxScanTime) {
-		Common::FSNode dir = _scanStack.pop();
-
-		Common::FSList files;
-		if (!dir.getChildren(files, Common::FSNode::kListAll)) {
-			continue;
-		}
-
-		// Run the detector on the dir
-		GameList candidates(EngineMan.detectGames(files));
-
-		// Just add all detected games / game variants. If we get more than one,
-		// that either means the directory contains multiple games, or the detector
-		// could not fully determine which game variant it was seeing. In either
-		// case, let the user choose which entries he wants to keep.
-		//
-		// However, we only add games which are not already in the config file.
-		for (GameList::const_iterator cand = candidates.begin(); cand != candidates.end(); ++cand) {
-			GameDescriptor result = *cand;
-			Common::String path = dir.getPath();
-
-			// Remove trailing slashes
-			while (path != "/" && path.lastChar() == '/')
-				path.deleteLastChar();
-
-			// Check for existing config entries for this path/gameid/lang/platform combination
-			if (_pathToTargets.contains(path)) {
-				bool duplicate = false;
-				const StringArray &targets = _pathToTargets[path];
-				for (StringArray::const_iterator iter = targets.begin(); iter != targets.end(); ++iter) {
-					// If the gameid, platform and language match -> skip it
-					Common::ConfigManager::Domain *dom = ConfMan.getDomain(*iter);
-					assert(dom);
-
-					if ((*dom)["gameid"] == result["gameid"] &&
-					    (*dom)["platform"] == result["platform"] &&
-					    (*dom)["language"] == result["language"]) {
-						duplicate = true;
-						break;
-					}
-				}
-				if (duplicate) {
-					_oldGamesCount++;
-					break;	// Skip duplicates
-				}
-			}
-			result["path"] = path;
-			_games.push_back(result);
+	// Scan directories until our time slice is used up
+	while ((g_system->getMillis() - t) < kMaxScanTime) {
+		const uint oldGameCount = games.size();
 
-			_list->append(result.description());
-		}
-
-
-		// Recurse into all subdirs
-		for (Common::FSList::const_iterator file = files.begin(); file != files.end(); ++file) {
-			if (file->isDirectory()) {
-				_scanStack.push(*file);
-
-				_dirTotal++;
-			}
-		}
+		if (!_scanner.scanNextDirectory())
+			break;
 
-		_dirsScanned++;
+		for (uint i = oldGameCount; i < games.size(); ++i)
+			_list->append(games[i].description());
 
 #if defined(USE_TASKBAR)
-		g_system->getTaskbarManager()->setProgressValue(_dirsScanned, _dirTotal);
-		g_system->getTaskbarManager()->setCount(_games.size());
+		g_system->getTaskbarManager()->setProgressValue(_scanner.getDirsScanned(), _scanner.getDirTotal());
+		g_system->getTaskbarManager()->setCount(games.size());
 #endif
 	}
 
@@ -252,25 +279,25 @@ void MassAddDialog::handleTickle() {
 	// Update the dialog
 	Common::String buf;
 
-	if (_scanStack.empty()) {
+	if (_scanner.isFinished()) {
 		// Enable the OK button
 		_okButton->setEnabled(true);
 
 		buf = _("Scan complete!");
 		_dirProgressText->setLabel(buf);
 
-		buf = Common::String::format(_("Discovered %d new games, ignored %d previously added games."), _games.size(), _oldGamesCount);
+		buf = Common::String::format(_("Discovered %d new games, ignored %d previously added games."), games.size(), _scanner.getOldGamesCount());
 		_gameProgressText->setLabel(buf);
 
 	} else {
-		buf = Common::String::format(_("Scanned %d directories ..."), _dirsScanned);
+		buf = Common::String::format(_("Scanned %d directories ..."), _scanner.getDirsScanned());
 		_dirProgressText->setLabel(buf);
 
-		buf = Common::String::format(_("Discovered %d new games, ignored %d previously added games ..."), _games.size(), _oldGamesCount);
+		buf = Common::String::format(_("Discovered %d new games, ignored %d previously added games ..."), games.size(), _scanner.getOldGamesCount());
 		_gameProgressText->setLabel(buf);
 	}
 
-	if (_games.size() > 0) {
+	if (games.size() > 0) {
 		_list->scrollToEnd();
 	}
 
@@ -33,24 +33,48 @@ namespace GUI {
 
 class StaticTextWidget;
 
-class MassAddDialog : public Dialog {
+/**
+ * Scans a directory tree for games which are not yet in the config file.
+ *
+ * The scan is performed one directory at a time, so that callers can
+ * interleave it with other work. Directories are visited in a fixed order
+ * (depth-first, children sorted by name), hence the list of games found
+ * does not depend on the order in which the filesystem lists them.
+ *
+ * This is used both by the mass add dialog and by the "--add" command
+ * line option.
+ */
+class MassAddScanner {
 	typedef Common::Array<Common::String> StringArray;
 public:
-	MassAddDialog(const Common::FSNode &startDir);
+	/**
+	 * @param startDir	the directory to start the scan at
+	 * @param recursive	whether to scan the subdirectories of startDir, too
+	 */
+	MassAddScanner(const Common::FSNode &startDir, bool recursive = true);
 
-	//void open();
-	void handleCommand(CommandSender *sender, uint32 cmd, uint32 data);
-	void handleTickle();
+	/**
+	 * Scan the next directory.
+	 *
+	 * @return false if there was no directory left to scan.
+	 */
+	bool scanNextDirectory();
 
-	Common::String getFirstAddedTarget() const {
-		if (!_games.empty())
-			return _games.front().gameid();
-		return Common::String();
-	}
+	/** Whether all directories were scanned. */
+	bool isFinished() const { return _scanStack.empty(); }
+
+	/** The new games found so far, in the order they were found. */
+	GameList &getGames() { return _games; }
+	const GameList &getGames() const { return _games; }
+
+	int getDirsScanned() const { return _dirsScanned; }
+	int getDirTotal() const { return _dirTotal; }
+	int getOldGamesCount() const { return _oldGamesCount; }
 
 private:
 	Common::Stack<Common::FSNode>  _scanStack;
 	GameList _games;
+	bool _recursive;
 
 	/**
 	 * Map each path occuring in the config file to the target(s) using that path.
@@ -62,6 +86,25 @@ private:
 	int _dirsScanned;
 	int _oldGamesCount;
 	int _dirTotal;
+};
+
+class MassAddDialog : public Dialog {
+public:
+	MassAddDialog(const Common::FSNode &startDir);
+
+	//void open();
+	void handleCommand(CommandSender *sender, uint32 cmd, uint32 data);
+	void handleTickle();
+
+	Common::String getFirstAddedTarget() const {
+		const GameList &games = _scanner.getGames();
+		if (!games.empty())
+			return games.front().gameid();
+		return Common::String();
+	}
+
+private:
+	MassAddScanner _scanner;
 
 	Widget *_okButton;
 	StaticTextWidget *_dirProgressText;
@@ -0,0 +1,172 @@
+#include <cxxtest/TestSuite.h>
+
+#include "audio/decoders/raw.h"
+#include "audio/audiostream.h"
+#include "audio/mixer.h"
+#include "audio/rate.h"
+
+#include "common/memstream.h"
+
+class RateConverterTestSuite : public CxxTest::TestSuite
+{
+private:
+	enum {
+		kAmplitude = 16000
+	};
+
+	static Audio::AudioStream *createToneStream(const int sampleRate, const double frequency, const int length) {
+		int16 *tone = (int16 *)malloc(length * sizeof(int16));
+		for (int i = 0; i < length; ++i)
+			tone[i] = (int16)floor(sin(2 * M_PI * frequency * i / sampleRate) * kAmplitude + 0.5);
+
+		Common::SeekableReadStream *s = new Common::MemoryReadStream((const byte *)tone, length * sizeof(int16), DisposeAfterUse::YES);
+		return Audio::makeRawStream(s, sampleRate, Audio::FLAG_16BITS
+#ifdef SCUMM_LITTLE_ENDIAN
+		                            | Audio::FLAG_LITTLE_ENDIAN
+#endif
+		                            );
+	}
+
+	/**
+	 * Convert a tone and return the left channel of the output.
+	 */
+	static int16 *convertTone(const int inRate, const int outRate, const double frequency, const int outLength, Audio::ResamplingQuality quality) {
+		Audio::AudioStream *input = createToneStream(inRate, frequency, (int)((double)outLength * inRate / outRate) + 256);
+		Audio::RateConverter *converter = Audio::makeRateConverter(inRate, outRate, false, false, quality);
+
+		int16 *buffer = new int16[2 * outLength];
+		memset(buffer, 0, 2 * outLength * sizeof(int16));
+		converter->flow(*input, buffer, outLength, Audio::Mixer::kMaxMixerVolume, Audio::Mixer::kMaxMixerVolume);
+
+		int16 *left = new int16[outLength];
+		for (int i = 0; i < outLength; ++i)
+			left[i] = buffer[2 * i];
+
+		delete[] buffer;
+		delete converter;
+		delete input;
+		return left;
+	}
+
+	/**
+	 * Power of the given frequency in a signal, computed with the Goertzel
+	 * algorithm over a Hann window.
+	 */
+	static double tonePower(const int16 *samples, const int length, const int sampleRate, const double frequency) {
+		const double coeff = 2 * cos(2 * M_PI * frequency / sampleRate);
+		double s1 = 0, s2 = 0;
+		for (int i = 0; i < length; ++i) {
+			const double window = 0.5 - 0.5 * cos(2 * M_PI * i / (length - 1));
+			const double s0 = samples[i] * window + coeff * s1 - s2;
+			s2 = s1;
+			s1 = s0;
+		}
+		return s1 * s1 + s2 * s2 - coeff * s1 * s2;
+	}
+
+	/**
+	 * Level of the strongest alias (image) of a tone relative to the tone
+	 * itself, in dB.
+	 */
+	static double aliasLevel(const int inRate, const int outRate, const double frequency, Audio::ResamplingQuality quality) {
+		const int length = 8192;
+		const int skip = 256;
+		int16 *output = convertTone(inRate, outRate, frequency, length + skip, quality);
+
+		const double signal = tonePower(output + skip, length, outRate, frequency);
+		double alias = 0;
+		for (int image = 1; image * inRate - frequency < outRate / 2; ++image) {
+			alias = MAX(alias, tonePower(output + skip, length, outRate, image * inRate - frequency));
+			if (image * inRate + frequency < outRate / 2)
+				alias = MAX(alias, tonePower(output + skip, length, outRate, image * inRate + frequency));
+		}
+
+		delete[] output;
+		return 10 * log10(alias / signal);
+	}
+
+	/**
+	 * Signal to noise and distortion ratio of a converted tone compared to
+	 * the ideal output, in dB.
+	 */
+	static double signalToNoise(const int inRate, const int outRate, const double frequency, Audio::ResamplingQuality quality) {
+		const int length = 8192;
+		const int skip = 256;
+		int16 *output = convertTone(inRate, outRate, frequency, length + skip, quality);
+
+		double signal = 0, noise = 0;
+		for (int i = skip; i < length + skip; ++i) {
+			const double ideal = sin(2 * M_PI * frequency * i / outRate) * kAmplitude;
+			signal += ideal * ideal;
+			noise += (output[i] - ideal) * (output[i] - ideal);
+		}
+
+		delete[] output;
+		return 10 * log10(signal / noise);
+	}
+
+	/**
+	 * Level of a converted tone above the output Nyquist frequency relative
+	 * to its original level, in dB.
+	 */
+	static double rejectionLevel(const int inRate, const int outRate, const double frequency, Audio::ResamplingQuality quality) {
+		const int length = 8192;
+		const int skip = 256;
+		int16 *output = convertTone(inRate, outRate, frequency, length + skip, quality);
+
+		double power = 0;
+		for (int i = skip; i < length + skip; ++i)
+			power += (double)output[i] * output[i];
+
+		delete[] output;
+		return 10 * log10(power / length / (kAmplitude * kAmplitude / 2.0));
+	}
+
+public:
+	void test_polyphase_upsample_aliasing() {
+		// Linear interpolation leaves strong images of an 11 kHz sample
+		TS_ASSERT_LESS_THAN(-30, aliasLevel(11025, 48000, 3000, Audio::kResamplingFast));
+
+		TS_ASSERT_LESS_THAN(aliasLevel(11025, 48000, 3000, Audio::kResamplingMedium), -70);
+		TS_ASSERT_LESS_THAN(aliasLevel(11025, 48000, 3000, Audio::kResamplingHigh), -85);
+		TS_ASSERT_LESS_THAN(aliasLevel(22050, 44100, 8000, Audio::kResamplingMedium), -70);
+	}
+
+	void test_polyphase_upsample_distortion() {
+		TS_ASSERT_LESS_THAN(65, signalToNoise(22050, 48000, 1000, Audio::kResamplingMedium));
+		TS_ASSERT_LESS_THAN(70, signalToNoise(22050, 48000, 1000, Audio::kResamplingHigh));
+		TS_ASSERT_LESS_THAN(70, signalToNoise(11025, 44100, 1000, Audio::kResamplingBest));
+	}
+
+	void test_polyphase_quantized_phases() {
+		// The ratio of these rates needs more phases than the filter table
+		// holds, so the position is quantized.
+		TS_ASSERT_LESS_THAN(45, signalToNoise(22254, 44100, 1000, Audio::kResamplingMedium));
+	}
+
+	void test_polyphase_drain() {
+		Audio::AudioStream *input = createToneStream(22050, 1000, 1000);
+		Audio::RateConverter *converter = Audio::makeRateConverter(22050, 44100, false, false, Audio::kResamplingMedium);
+
+		int16 buffer[2 * 4000];
+		memset(buffer, 0, sizeof(buffer));
+		const int flowed = converter->flow(*input, buffer, 4000, Audio::Mixer::kMaxMixerVolume, Audio::Mixer::kMaxMixerVolume);
+		TS_ASSERT_LESS_THAN(flowed, 2000);
+
+		// The samples held back for the filter come out once the input ended
+		const int drained = converter->drain(buffer + 2 * flowed, 4000 - flowed, Audio::Mixer::kMaxMixerVolume, Audio::Mixer::kMaxMixerVolume);
+		TS_ASSERT_EQUALS(flowed + drained, 2000);
+		TS_ASSERT_EQUALS(converter->drain(buffer, 4000, Audio::Mixer::kMaxMixerVolume, Audio::Mixer::kMaxMixerVolume), 0);
+
+		// The tone goes on until the end
+		TS_ASSERT_LESS_THAN(kAmplitude / 2, ABS(buffer[2 * 1995]) + ABS(buffer[2 * 1985]));
+
+		delete converter;
+		delete input;
+	}
+
+	void test_polyphase_downsample() {
+		TS_ASSERT_LESS_THAN(60, signalToNoise(48000, 22050, 1000, Audio::kResamplingMedium));
+		TS_ASSERT_LESS_THAN(rejectionLevel(48000, 22050, 15000, Audio::kResamplingMedium), -60);
+	}
+};
@@ -0,0 +1,248 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/flathashmap.h"
+#include "common/hashmap.h"
+#include "common/hash-str.h"
+
+/**
+ * Equality functor which counts how often it is called, to compare how
+ * many keys the hash maps have to look at.
+ */
+struct CountingEqualTo {
+	static uint _comparisons;
+	bool operator()(const int &x, const int &y) const { _comparisons++; return x == y; }
+};
+
+uint CountingEqualTo::_comparisons = 0;
+
+/** Hash functor which maps all keys to the same slot. */
+struct ConstantHash {
+	uint operator()(const int &x) const { return 0; }
+};
+
+class FlatHashMapTestSuite : public CxxTest::TestSuite
+{
+	typedef Common::FlatHashMap<Common::String, Common::String, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> FlatStringMap;
+
+	/** Simple linear congruential generator, to get reproducible keys. */
+	static uint nextRandom(uint &seed) {
+		seed = seed * 1103515245 + 12345;
+		return (seed >> 8) & 0xFFFFFF;
+	}
+
+	public:
+	void test_empty_clear() {
+		Common::FlatHashMap<int, int> container;
+		TS_ASSERT(container.empty());
+		container[0] = 17;
+		container[1] = 33;
+		TS_ASSERT(!container.empty());
+		container.clear();
+		TS_ASSERT(container.empty());
+
+		FlatStringMap container2;
+		TS_ASSERT(container2.empty());
+		container2["foo"] = "bar";
+		container2["quux"] = "blub";
+		TS_ASSERT(!container2.empty());
+		container2.clear(true);
+		TS_ASSERT(container2.empty());
+		TS_ASSERT(!container2.contains("foo"));
+	}
+
+	void test_contains() {
+		Common::FlatHashMap<int, int> container;
+		container[0] = 17;
+		container[1] = 33;
+		TS_ASSERT(container.contains(0));
+		TS_ASSERT(container.contains(1));
+		TS_ASSERT(!container.contains(17));
+		TS_ASSERT(!container.contains(-1));
+
+		FlatStringMap container2;
+		container2["foo"] = "bar";
+		container2["quux"] = "blub";
+		TS_ASSERT(container2.contains("foo"));
+		TS_ASSERT(container2.contains("QUUX"));
+		TS_ASSERT(!container2.contains("bar"));
+		TS_ASSERT(!container2.contains("asdf"));
+	}
+
+	void test_add_remove() {
+		Common::FlatHashMap<int, int> container;
+		container[0] = 17;
+		container[1] = 33;
+		container[2] = 45;
+		container[3] = 12;
+		container[4] = 96;
+		TS_ASSERT(container.contains(1));
+		container.erase(1);
+		TS_ASSERT(!container.contains(1));
+		container[1] = 42;
+		TS_ASSERT(container.contains(1));
+		container.erase(container.find(0));
+		TS_ASSERT(!container.empty());
+		container.erase(1);
+		container.erase(2);
+		container.erase(3);
+		TS_ASSERT_EQUALS(container.size(), 1U);
+		container.erase(container.find(4));
+		TS_ASSERT(container.empty());
+		container.erase(4);
+		TS_ASSERT(container.empty());
+	}
+
+	void test_lookup_with_default() {
+		Common::FlatHashMap<int, int> container;
+		container[0] = 17;
+		container[1] = -1;
+		container.setVal(2, 45);
+
+		// We take a const ref now to ensure that the map
+		// is not modified by getVal.
+		const Common::FlatHashMap<int, int> &containerRef = container;
+
+		TS_ASSERT_EQUALS(containerRef[1], -1);
+		TS_ASSERT_EQUALS(containerRef.getVal(2), 45);
+		TS_ASSERT_EQUALS(containerRef.getVal(17), 0);
+		TS_ASSERT_EQUALS(containerRef.getVal(0, -10), 17);
+		TS_ASSERT_EQUALS(containerRef.getVal(17, -10), -10);
+		TS_ASSERT_EQUALS(containerRef.size(), 3U);
+		TS_ASSERT_EQUALS(containerRef.find(17), containerRef.end());
+	}
+
+	void test_collision() {
+		// All these keys share their home slot, and the ones after an
+		// erased key have to be moved back.
+		Common::FlatHashMap<int, int, ConstantHash> h;
+		for (int i = 0; i < 12; ++i)
+			h[i] = i;
+		for (int i = 0; i < 12; i += 3)
+			h.erase(i);
+		for (int i = 0; i < 12; ++i) {
+			TS_ASSERT_EQUALS(h.contains(i), (i % 3) != 0);
+			if (i % 3)
+				TS_ASSERT_EQUALS(h[i], i);
+		}
+
+		// Growing the storage does not help against such keys, but must
+		// not break the map either.
+		for (int i = 0; i < 300; ++i)
+			h[i] = i;
+		TS_ASSERT_EQUALS(h.size(), 300U);
+		TS_ASSERT_EQUALS(h[299], 299);
+	}
+
+	void test_iterator_copy() {
+		Common::FlatHashMap<int, int> container;
+		for (int i = 0; i < 100; ++i)
+			container[i * 7] = i;
+		for (int i = 0; i < 100; i += 2)
+			container.erase(i * 7);
+
+		Common::FlatHashMap<int, int> copy;
+		copy[1000] = 1;
+		copy = container;
+		TS_ASSERT(!copy.contains(1000));
+
+		int sum = 0;
+		uint count = 0;
+		for (Common::FlatHashMap<int, int>::const_iterator i = copy.begin(); i != copy.end(); ++i) {
+			TS_ASSERT_EQUALS(i->_key, i->_value * 7);
+			TS_ASSERT(i->_value & 1);
+			sum += i->_value;
+			count++;
+		}
+		TS_ASSERT_EQUALS(count, 50U);
+		TS_ASSERT_EQUALS(sum, 2500);
+	}
+
+	void test_random_against_hashmap() {
+		// Run the same random mix of insertions and removals on both map
+		// implementations, and compare the results.
+		Common::HashMap<int, int> reference;
+		Common::FlatHashMap<int, int> flat;
+		uint seed = 1;
+
+		for (int i = 0; i < 20000; ++i) {
+			const int key = nextRandom(seed) % 2000;
+			if (nextRandom(seed) % 3) {
+				reference[key] = i;
+				flat[key] = i;
+			} else {
+				reference.erase(key);
+				flat.erase(key);
+			}
+		}
+
+		TS_ASSERT_EQUALS(flat.size(), reference.size());
+		for (int key = 0; key < 2000; ++key) {
+			TS_ASSERT_EQUALS(flat.contains(key), reference.contains(key));
+			TS_ASSERT_EQUALS(flat.getVal(key, -1), reference.getVal(key, -1));
+		}
+	}
+
+	void test_benchmark_probes() {
+		// Compare how many keys the two implementations have to look at for
+		// inserting, looking up and missing keys. With the keys stored in
+		// the table, every comparison of HashMap is a pointer chase while
+		// FlatHashMap reads adjacent slots, so this is what determines the
+		// lookup throughput.
+		const int count = 50000;
+		Common::HashMap<int, int, Common::Hash<int>, CountingEqualTo> reference;
+		Common::FlatHashMap<int, int, Common::Hash<int>, CountingEqualTo> flat;
+		uint referenceComparisons[3], flatComparisons[3];
+		uint seed;
+
+		CountingEqualTo::_comparisons = 0;
+		seed = 2;
+		for (int i = 0; i < count; ++i)
+			reference[nextRandom(seed) * 64] = i;
+		referenceComparisons[0] = CountingEqualTo::_comparisons;
+
+		CountingEqualTo::_comparisons = 0;
+		seed = 2;
+		for (int i = 0; i < count; ++i)
+			flat[nextRandom(seed) * 64] = i;
+		flatComparisons[0] = CountingEqualTo::_comparisons;
+
+		TS_ASSERT_EQUALS(flat.size(), reference.size());
+
+		CountingEqualTo::_comparisons = 0;
+		seed = 2;
+		for (int i = 0; i < count; ++i)
+			TS_ASSERT(reference.contains(nextRandom(seed) * 64));
+		referenceComparisons[1] = CountingEqualTo::_comparisons;
+
+		CountingEqualTo::_comparisons = 0;
+		seed = 2;
+		for (int i = 0; i < count; ++i)
+			TS_ASSERT(flat.contains(nextRandom(seed) * 64));
+		flatComparisons[1] = CountingEqualTo::_comparisons;
+
+		CountingEqualTo::_comparisons = 0;
+		for (int i = 0; i < count; ++i)
+			reference.contains(i * 64 + 1);
+		referenceComparisons[2] = CountingEqualTo::_comparisons;
+
+		CountingEqualTo::_comparisons = 0;
+		for (int i = 0; i < count; ++i)
+			flat.contains(i * 64 + 1);
+		flatComparisons[2] = CountingEqualTo::_comparisons;
+
+		// The keys are multiples of 64, which gives HashMap, which takes the
+		// lowest bits of the hash as slot, many collisions. FlatHashMap
+		// scrambles the hash, and Robin Hood insertion keeps the probe
+		// sequences short despite its higher load factor. Misses only need
+		// to compare keys with the same distance from their home slot.
+		TS_ASSERT_LESS_THAN(flatComparisons[0], referenceComparisons[0]);
+		TS_ASSERT_LESS_THAN(flatComparisons[1], referenceComparisons[1]);
+		TS_ASSERT_LESS_THAN(flatComparisons[2], (uint)count);
+
+		// Iterating visits every entry once
+		int entries = 0;
+		for (Common::FlatHashMap<int, int, Common::Hash<int>, CountingEqualTo>::iterator i = flat.begin(); i != flat.end(); ++i)
+			entries++;
+		TS_ASSERT_EQUALS(entries, (int)flat.size());
+	}
+};
@@ -0,0 +1,127 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/memorypool.h"
+
+class MemoryPoolTestSuite : public CxxTest::TestSuite
+{
+	public:
+	void test_pool_stats() {
+		Common::MemoryPool pool(24);
+		TS_ASSERT_EQUALS(pool.getNumChunks(), 0U);
+
+		void *chunks[20];
+		for (int i = 0; i < 20; ++i)
+			chunks[i] = pool.allocChunk();
+		TS_ASSERT_EQUALS(pool.getNumUsedChunks(), 20U);
+		TS_ASSERT(pool.getNumChunks() >= 20U);
+
+		for (int i = 0; i < 20; ++i)
+			pool.freeChunk(chunks[i]);
+		TS_ASSERT_EQUALS(pool.getNumUsedChunks(), 0U);
+
+		pool.freeUnusedPages();
+		TS_ASSERT_EQUALS(pool.getNumChunks(), 0U);
+	}
+
+	void test_size_classes() {
+		Common::SizeClassAllocator allocator;
+		TS_ASSERT(allocator.allocate(0) == NULL);
+
+		// Blocks of all sizes are distinct and can hold their size
+		const size_t sizes[] = { 1, 8, 16, 17, 100, 256, 257, 4000 };
+		const int numSizes = ARRAYSIZE(sizes);
+		byte *blocks[numSizes];
+		for (int i = 0; i < numSizes; ++i) {
+			blocks[i] = (byte *)allocator.allocate(sizes[i]);
+			memset(blocks[i], i, sizes[i]);
+		}
+		for (int i = 0; i < numSizes; ++i) {
+			TS_ASSERT_EQUALS(blocks[i][0], i);
+			TS_ASSERT_EQUALS(blocks[i][sizes[i] - 1], i);
+		}
+
+		// Sizes are rounded up to the size classes
+		TS_ASSERT_EQUALS(allocator.getUsedBytes(), 16U + 16 + 16 + 32 + 112 + 256 + 257 + 4000);
+
+		for (int i = 0; i < numSizes; ++i)
+			allocator.deallocate(blocks[i], sizes[i]);
+		TS_ASSERT_EQUALS(allocator.getUsedBytes(), 0U);
+		TS_ASSERT(allocator.getReservedBytes() > 0U);
+
+		allocator.freeUnusedPages();
+		TS_ASSERT_EQUALS(allocator.getReservedBytes(), 0U);
+	}
+
+	void test_size_class_reuse() {
+		Common::SizeClassAllocator allocator;
+
+		// Freed chunks are handed out again
+		void *first = allocator.allocate(40);
+		allocator.deallocate(first, 40);
+		TS_ASSERT_EQUALS(allocator.allocate(48), first);
+		allocator.deallocate(first, 48);
+	}
+
+	void test_arena() {
+		Common::MemoryArena arena(256);
+		TS_ASSERT_EQUALS(arena.getReservedBytes(), 0U);
+
+		byte *a = (byte *)arena.allocate(3);
+		byte *b = (byte *)arena.allocate(8);
+		TS_ASSERT_EQUALS(b, a + sizeof(void *));
+		TS_ASSERT_EQUALS(arena.getReservedBytes(), 256U);
+
+		uint16 *c = arena.allocateArray<uint16>(3);
+		TS_ASSERT_EQUALS((byte *)c, b + 8);
+		TS_ASSERT_EQUALS(arena.getUsedBytes(), sizeof(void *) + 8 + 6);
+
+		// Larger allocations than the block size get their own block
+		byte *large = (byte *)arena.allocate(1000);
+		memset(large, 0, 1000);
+		TS_ASSERT_EQUALS(arena.getReservedBytes(), 256U + 1000);
+
+		arena.reset();
+		TS_ASSERT_EQUALS(arena.getUsedBytes(), 0U);
+		TS_ASSERT_EQUALS(arena.allocate(3), a);
+		TS_ASSERT_EQUALS(arena.getPeakUsedBytes(), 256U + 1000);
+
+		arena.freeUnusedBlocks();
+		TS_ASSERT_EQUALS(arena.getReservedBytes(), 256U);
+	}
+
+	void test_arena_markers() {
+		Common::MemoryArena arena(64);
+
+		arena.allocate(40);
+		const Common::MemoryArena::Marker marker = arena.getMarker();
+		void *next = arena.allocate(16);
+
+		// Spill over into several further blocks
+		for (int i = 0; i < 10; ++i)
+			arena.allocate(48);
+		TS_ASSERT_EQUALS(arena.getReservedBytes(), 64U * 11);
+
+		arena.reset(marker);
+		TS_ASSERT_EQUALS(arena.getUsedBytes(), 40U);
+		TS_ASSERT_EQUALS(arena.allocate(16), next);
+
+		// The blocks are reused, rather than allocated again
+		for (int i = 0; i < 10; ++i)
+			arena.allocate(48);
+		TS_ASSERT_EQUALS(arena.getReservedBytes(), 64U * 11);
+	}
+
+	void test_arena_scope() {
+		Common::MemoryArena arena;
+		arena.allocate(100);
+
+		{
+			Common::ArenaScope scope(arena);
+			for (int i = 0; i < 100; ++i)
+				new (arena) int(i);
+			TS_ASSERT(arena.getUsedBytes() > 100U);
+		}
+
+		TS_ASSERT_EQUALS(arena.getUsedBytes(), 100U);
+	}
+};
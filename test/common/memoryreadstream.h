@@ -104,4 +104,20 @@ class MemoryReadStreamTestSuite : public CxxTest::TestSuite {
 		ms.seek(0, SEEK_SET);
 		TS_ASSERT(!ms.eos());
 	}
+
+	void test_borrow_data() {
+		byte contents[] = { 1, 2, 3, 4, 5, 6, 7 };
+		Common::MemoryReadStream ms(contents, sizeof(contents));
+
+		ms.seek(2, SEEK_SET);
+		TS_ASSERT_EQUALS(ms.borrowData(3), contents + 2);
+		TS_ASSERT_EQUALS(ms.pos(), 5);
+		TS_ASSERT_EQUALS(ms.readByte(), 6);
+
+		// Borrowing more than is left fails and keeps the position
+		TS_ASSERT(ms.borrowData(2) == 0);
+		TS_ASSERT_EQUALS(ms.pos(), 6);
+		TS_ASSERT(!ms.eos());
+		TS_ASSERT_EQUALS(ms.borrowData(1), contents + 6);
+	}
 };
@@ -0,0 +1,149 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/archive.h"
+#include "common/memstream.h"
+
+/**
+ * Archive with a fixed list of empty members, which counts how often it is
+ * searched.
+ */
+class TestArchive : public Common::Archive {
+	Common::StringArray _names;
+	bool _indexable;
+
+public:
+	mutable int _searches;
+
+	TestArchive(const char *names, bool indexable) : _indexable(indexable), _searches(0) {
+		Common::String name;
+		for (const char *c = names; ; ++c) {
+			if (*c == ' ' || !*c) {
+				if (!name.empty())
+					_names.push_back(name);
+				name.clear();
+				if (!*c)
+					break;
+			} else {
+				name += *c;
+			}
+		}
+	}
+
+	void removeFile(const Common::String &name) {
+		for (uint i = 0; i < _names.size(); ++i) {
+			if (_names[i].equalsIgnoreCase(name)) {
+				_names.remove_at(i);
+				return;
+			}
+		}
+	}
+
+	virtual bool hasFile(const Common::String &name) const {
+		_searches++;
+		for (uint i = 0; i < _names.size(); ++i) {
+			if (_names[i].equalsIgnoreCase(name))
+				return true;
+		}
+		return false;
+	}
+
+	virtual int listMembers(Common::ArchiveMemberList &list) const {
+		for (uint i = 0; i < _names.size(); ++i)
+			list.push_back(Common::ArchiveMemberPtr(new Common::GenericArchiveMember(_names[i], this)));
+		return _names.size();
+	}
+
+	virtual bool listMemberNames(Common::StringArray &names) const {
+		if (!_indexable)
+			return false;
+		for (uint i = 0; i < _names.size(); ++i)
+			names.push_back(_names[i]);
+		return true;
+	}
+
+	virtual const Common::ArchiveMemberPtr getMember(const Common::String &name) const {
+		return Common::ArchiveMemberPtr(new Common::GenericArchiveMember(name, this));
+	}
+
+	virtual Common::SeekableReadStream *createReadStreamForMember(const Common::String &name) const {
+		if (!hasFile(name))
+			return 0;
+
+		// Tell the archives apart by the stream size
+		return new Common::MemoryReadStream((const byte *)"", _names.size());
+	}
+};
+
+class SearchSetTestSuite : public CxxTest::TestSuite
+{
+	public:
+	void test_priorities() {
+		Common::SearchSet set;
+		TestArchive *low = new TestArchive("a.dat b.dat", true);
+		TestArchive *high = new TestArchive("B.DAT c.dat d.dat", true);
+		TestArchive *probed = new TestArchive("c.dat e.dat f.dat g.dat", false);
+		set.add("low", low, -1);
+		set.add("high", high, 1);
+		set.add("probed", probed, 0);
+
+		TS_ASSERT(set.hasFile("A.dat"));
+		TS_ASSERT(set.hasFile("e.dat"));
+		TS_ASSERT(!set.hasFile("x.dat"));
+
+		// The archive with the highest priority provides the file
+		Common::SeekableReadStream *stream = set.createReadStreamForMember("b.dat");
+		TS_ASSERT(stream);
+		TS_ASSERT_EQUALS(stream->size(), 3);
+		delete stream;
+
+		stream = set.createReadStreamForMember("c.dat");
+		TS_ASSERT(stream);
+		TS_ASSERT_EQUALS(stream->size(), 3);
+		delete stream;
+
+		// Changing the priority invalidates the index
+		set.setPriority("probed", 2);
+		stream = set.createReadStreamForMember("c.dat");
+		TS_ASSERT(stream);
+		TS_ASSERT_EQUALS(stream->size(), 4);
+		delete stream;
+
+		set.remove("probed");
+		TS_ASSERT(!set.hasFile("e.dat"));
+		set.remove("high");
+		TS_ASSERT(!set.hasFile("c.dat"));
+		TS_ASSERT(set.hasFile("b.dat"));
+	}
+
+	void test_index_lookups() {
+		Common::SearchSet set;
+		TestArchive *first = new TestArchive("a.dat", true);
+		TestArchive *probed = new TestArchive("b.dat", false);
+		TestArchive *last = new TestArchive("c.dat d.dat", true);
+		set.add("first", first, 2);
+		set.add("probed", probed, 1);
+		set.add("last", last, 0);
+
+		// Indexed files of the highest priority don't need any probing
+		TS_ASSERT(set.hasFile("a.dat"));
+		TS_ASSERT_EQUALS(first->_searches, 1);
+		TS_ASSERT_EQUALS(probed->_searches, 0);
+		TS_ASSERT_EQUALS(last->_searches, 0);
+
+		// Only the archives without index have to be searched for the rest
+		TS_ASSERT(set.hasFile("d.dat"));
+		TS_ASSERT(!set.hasFile("x.dat"));
+		TS_ASSERT_EQUALS(first->_searches, 1);
+		TS_ASSERT_EQUALS(probed->_searches, 2);
+		TS_ASSERT_EQUALS(last->_searches, 1);
+
+		// Files which are gone since the index was built are still searched
+		// for in the other archives
+		TestArchive *later = new TestArchive("a.dat", false);
+		set.add("later", later, -1);
+		TS_ASSERT(set.hasFile("a.dat"));
+		first->removeFile("a.dat");
+		TS_ASSERT(set.hasFile("a.dat"));
+		TS_ASSERT_EQUALS(later->_searches, 1);
+	}
+};
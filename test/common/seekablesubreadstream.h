@@ -70,4 +70,20 @@ class SeekableSubReadStreamTestSuite : public CxxTest::TestSuite {
 		b = ssrs.readByte();
 		TS_ASSERT_EQUALS(b, 1);
 	}
+
+	void test_borrow_data() {
+		byte contents[10] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+		Common::MemoryReadStream ms(contents, 10);
+		Common::SafeSeekableSubReadStream ssrs(&ms, 1, 9);
+
+		ssrs.seek(2, SEEK_SET);
+		ms.seek(0, SEEK_SET);
+		TS_ASSERT_EQUALS(ssrs.borrowData(4), contents + 3);
+		TS_ASSERT_EQUALS(ssrs.pos(), 6);
+
+		// The end of the substream is respected
+		TS_ASSERT(ssrs.borrowData(3) == 0);
+		TS_ASSERT_EQUALS(ssrs.pos(), 6);
+		TS_ASSERT_EQUALS(ssrs.readByte(), 7);
+	}
 };
@@ -0,0 +1,229 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/archive.h"
+#include "common/memstream.h"
+#include "common/unzip.h"
+#include "common/zlib.h"
+
+class UnzipTestSuite : public CxxTest::TestSuite
+{
+	struct Member {
+		const char *name;
+		const byte *data;
+		uint32 size;
+		bool deflate;
+		// Filled in by makeZip
+		uint32 crc;
+		uint32 compressedSize;
+		uint32 offset;
+	};
+
+	/** Member contents, which are compressible but differ by position. */
+	static byte *makeData(uint32 size) {
+		byte *data = (byte *)malloc(size);
+		uint32 seed = 1;
+		for (uint32 i = 0; i < size; ++i) {
+			seed = seed * 1103515245 + 12345;
+			data[i] = (byte)(((seed >> 16) & 0x0F) + (i >> 12));
+		}
+		return data;
+	}
+
+	/** Create a ZIP file in memory containing the given members. */
+	static Common::SeekableReadStream *makeZip(Member *members, int numMembers) {
+		Common::MemoryWriteStreamDynamic zip(DisposeAfterUse::NO);
+
+		for (int i = 0; i < numMembers; ++i) {
+			Member &m = members[i];
+			m.offset = zip.pos();
+
+			byte *compressed = const_cast<byte *>(m.data);
+			byte *gzipData = 0;
+			m.compressedSize = m.size;
+			m.crc = 0;
+#ifdef USE_ZLIB
+			// Compress the data as gzip file, which is a raw deflate stream
+			// with a 10 byte header and the CRC and the size as trailer
+			Common::MemoryWriteStreamDynamic *gzip = new Common::MemoryWriteStreamDynamic(DisposeAfterUse::NO);
+			Common::WriteStream *compressor = Common::wrapCompressedWriteStream(gzip);
+			compressor->write(m.data, m.size);
+			compressor->finalize();
+			gzipData = gzip->getData();
+			const uint32 gzipSize = gzip->size();
+			delete compressor;
+
+			m.crc = READ_LE_UINT32(gzipData + gzipSize - 8);
+			if (m.deflate) {
+				compressed = gzipData + 10;
+				m.compressedSize = gzipSize - 10 - 8;
+			}
+#endif
+
+			// Local file header
+			zip.writeUint32LE(0x04034b50);
+			zip.writeUint16LE(20);
+			zip.writeUint16LE(0);
+			zip.writeUint16LE(m.deflate ? 8 : 0);
+			zip.writeUint32LE(0);
+			zip.writeUint32LE(m.crc);
+			zip.writeUint32LE(m.compressedSize);
+			zip.writeUint32LE(m.size);
+			zip.writeUint16LE(strlen(m.name));
+			zip.writeUint16LE(0);
+			zip.write(m.name, strlen(m.name));
+			zip.write(compressed, m.compressedSize);
+			free(gzipData);
+		}
+
+		const uint32 centralDirStart = zip.pos();
+		for (int i = 0; i < numMembers; ++i) {
+			const Member &m = members[i];
+			zip.writeUint32LE(0x02014b50);
+			zip.writeUint16LE(20);
+			zip.writeUint16LE(20);
+			zip.writeUint16LE(0);
+			zip.writeUint16LE(m.deflate ? 8 : 0);
+			zip.writeUint32LE(0);
+			zip.writeUint32LE(m.crc);
+			zip.writeUint32LE(m.compressedSize);
+			zip.writeUint32LE(m.size);
+			zip.writeUint16LE(strlen(m.name));
+			zip.writeUint16LE(0);
+			zip.writeUint16LE(0);
+			zip.writeUint16LE(0);
+			zip.writeUint16LE(0);
+			zip.writeUint32LE(0);
+			zip.writeUint32LE(m.offset);
+			zip.write(m.name, strlen(m.name));
+		}
+		const uint32 centralDirEnd = zip.pos();
+
+		zip.writeUint32LE(0x06054b50);
+		zip.writeUint16LE(0);
+		zip.writeUint16LE(0);
+		zip.writeUint16LE(numMembers);
+		zip.writeUint16LE(numMembers);
+		zip.writeUint32LE(centralDirEnd - centralDirStart);
+		zip.writeUint32LE(centralDirStart);
+		zip.writeUint16LE(0);
+
+		return new Common::MemoryReadStream(zip.getData(), zip.size(), DisposeAfterUse::YES);
+	}
+
+	static bool compareRange(Common::SeekableReadStream *stream, const byte *data, uint32 start, uint32 size) {
+		byte *buffer = (byte *)malloc(size);
+		bool result = stream->seek(start, SEEK_SET) && stream->read(buffer, size) == size && !memcmp(buffer, data + start, size);
+		free(buffer);
+		return result;
+	}
+
+	public:
+	void test_stored_member() {
+		byte *data = makeData(5000);
+		byte *other = makeData(300);
+		Member members[] = {
+			{ "stored.bin", data, 5000, false, 0, 0, 0 },
+			{ "other.bin", other, 300, false, 0, 0, 0 }
+		};
+		Common::Archive *archive = Common::makeZipArchive(makeZip(members, 2));
+		TS_ASSERT(archive);
+
+		Common::SeekableReadStream *stream = archive->createReadStreamForMember("STORED.BIN");
+		Common::SeekableReadStream *otherStream = archive->createReadStreamForMember("other.bin");
+		TS_ASSERT(stream && otherStream);
+		TS_ASSERT_EQUALS(stream->size(), 5000);
+		TS_ASSERT(compareRange(stream, data, 0, 5000));
+		TS_ASSERT(compareRange(stream, data, 1234, 100));
+
+		// Reading one member does not disturb the other one
+		TS_ASSERT(stream->seek(100));
+		TS_ASSERT(compareRange(otherStream, other, 10, 100));
+		TS_ASSERT_EQUALS(stream->readByte(), data[100]);
+
+		// Members stay usable after the archive is gone
+		delete archive;
+		TS_ASSERT(compareRange(stream, data, 4000, 1000));
+		delete stream;
+		delete otherStream;
+		free(data);
+		free(other);
+	}
+
+#ifdef USE_ZLIB
+	void test_deflated_member() {
+		const uint32 size = 3 * 1024 * 1024 + 17;
+		byte *data = makeData(size);
+		byte *small = makeData(100);
+		Member members[] = {
+			{ "big.bin", data, size, true, 0, 0, 0 },
+			{ "small.bin", small, 100, true, 0, 0, 0 }
+		};
+		Common::Archive *archive = Common::makeZipArchive(makeZip(members, 2));
+		TS_ASSERT(archive);
+
+		Common::SeekableReadStream *big = archive->createReadStreamForMember("big.bin");
+		Common::SeekableReadStream *other = archive->createReadStreamForMember("small.bin");
+		TS_ASSERT(big && other);
+		TS_ASSERT_EQUALS(big->size(), (int32)size);
+
+		// Read the whole member, interleaved with the other one
+		byte buffer[10000];
+		uint32 pos = 0;
+		while (pos < size) {
+			const uint32 len = big->read(buffer, sizeof(buffer));
+			TS_ASSERT(len > 0);
+			if (!len)
+				break;
+			TS_ASSERT(!memcmp(buffer, data + pos, len));
+			pos += len;
+
+			other->seek(pos % 50, SEEK_SET);
+			TS_ASSERT_EQUALS(other->readByte(), small[pos % 50]);
+		}
+		TS_ASSERT(!big->err());
+		TS_ASSERT_EQUALS(big->read(buffer, 1), 0U);
+		TS_ASSERT(big->eos());
+
+		// Seek backwards and forwards, from and past checkpoints
+		TS_ASSERT(compareRange(big, data, 100, 1000));
+		TS_ASSERT(compareRange(big, data, size - 1000, 1000));
+		TS_ASSERT(compareRange(big, data, 1024 * 1024 + 5, 70000));
+		TS_ASSERT(compareRange(big, data, 512 * 1024 - 10, 20));
+		TS_ASSERT(compareRange(big, data, 2 * 1024 * 1024, 10));
+		TS_ASSERT(!big->eos());
+
+		delete archive;
+		TS_ASSERT(compareRange(big, data, 3, 10));
+		TS_ASSERT(compareRange(other, small, 0, 100));
+		delete big;
+		delete other;
+
+		free(data);
+		free(small);
+	}
+
+	void test_crc_mismatch() {
+		byte *data = makeData(1000);
+		Member members[] = { { "file.bin", data, 1000, true, 0, 0, 0 } };
+		Common::SeekableReadStream *zip = makeZip(members, 1);
+
+		// Corrupt the CRC in the local header and the central directory
+		byte *zipData = (byte *)malloc(zip->size());
+		zip->read(zipData, zip->size());
+		WRITE_LE_UINT32(zipData + 14, members[0].crc ^ 1);
+		WRITE_LE_UINT32(zipData + zip->size() - 22 - 46 - 8 + 16, members[0].crc ^ 1);
+		Common::Archive *archive = Common::makeZipArchive(new Common::MemoryReadStream(zipData, zip->size(), DisposeAfterUse::YES));
+		delete zip;
+
+		Common::SeekableReadStream *stream = archive->createReadStreamForMember("file.bin");
+		TS_ASSERT(stream);
+		byte buffer[1000];
+		stream->read(buffer, 1000);
+		TS_ASSERT(stream->err());
+
+		delete stream;
+		delete archive;
+		free(data);
+	}
+#endif
+};
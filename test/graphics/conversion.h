@@ -0,0 +1,150 @@
+#include <cxxtest/TestSuite.h>
+
+#include "graphics/conversion.h"
+#include "graphics/pixelformat.h"
+
+class ConversionTestSuite : public CxxTest::TestSuite
+{
+	static uint32 nextRandom(uint32 &seed) {
+		seed = seed * 1103515245 + 12345;
+		return (seed >> 16) | (seed << 16);
+	}
+
+	static uint32 readPixel(const byte *src, int bytesPerPixel) {
+		switch (bytesPerPixel) {
+		case 2:
+			return READ_UINT16(src);
+		case 3:
+			return READ_UINT24(src);
+		default:
+			return READ_UINT32(src);
+		}
+	}
+
+	/** Convert a pixel with the colorToARGB and ARGBToColor. */
+	static uint32 convertPixel(uint32 color, const Graphics::PixelFormat &dstFmt, const Graphics::PixelFormat &srcFmt) {
+		byte a, r, g, b;
+		srcFmt.colorToARGB(color, a, r, g, b);
+		return dstFmt.ARGBToColor(a, r, g, b);
+	}
+
+	/**
+	 * Convert random pixels with crossBlit, and compare the result with
+	 * converting every pixel separately.
+	 */
+	static bool checkCrossBlit(const Graphics::PixelFormat &dstFmt, const Graphics::PixelFormat &srcFmt, uint w, uint h) {
+		const uint srcPitch = w * srcFmt.bytesPerPixel + 5;
+		const uint dstPitch = w * dstFmt.bytesPerPixel + 3;
+		byte *src = new byte[srcPitch * h];
+		byte *dst = new byte[dstPitch * h];
+		uint32 seed = w * 31 + h;
+		for (uint i = 0; i < srcPitch * h; ++i)
+			src[i] = nextRandom(seed);
+		memset(dst, 0xAB, dstPitch * h);
+
+		bool result = Graphics::crossBlit(dst, src, dstPitch, srcPitch, w, h, dstFmt, srcFmt);
+
+		for (uint y = 0; y < h; ++y) {
+			for (uint x = 0; x < w; ++x) {
+				const uint32 expected = convertPixel(readPixel(src + y * srcPitch + x * srcFmt.bytesPerPixel, srcFmt.bytesPerPixel), dstFmt, srcFmt);
+				result &= (readPixel(dst + y * dstPitch + x * dstFmt.bytesPerPixel, dstFmt.bytesPerPixel) == expected);
+			}
+			// The padding at the end of the rows is left alone
+			for (uint x = w * dstFmt.bytesPerPixel; x < dstPitch; ++x)
+				result &= (dst[y * dstPitch + x] == 0xAB);
+		}
+
+		delete[] src;
+		delete[] dst;
+		return result;
+	}
+
+	/** Convert random pixels in place, and compare the result. */
+	static bool checkCrossBlitInPlace(const Graphics::PixelFormat &dstFmt, const Graphics::PixelFormat &srcFmt, uint w, uint h) {
+		const uint srcPitch = w * srcFmt.bytesPerPixel;
+		const uint dstPitch = w * dstFmt.bytesPerPixel;
+		byte *src = new byte[srcPitch * h];
+		byte *buffer = new byte[MAX(srcPitch, dstPitch) * h];
+		uint32 seed = w + h;
+		for (uint i = 0; i < srcPitch * h; ++i)
+			src[i] = nextRandom(seed);
+		memcpy(buffer, src, srcPitch * h);
+
+		bool result = Graphics::crossBlit(buffer, buffer, dstPitch, srcPitch, w, h, dstFmt, srcFmt);
+
+		for (uint i = 0; i < w * h; ++i) {
+			const uint32 expected = convertPixel(readPixel(src + i * srcFmt.bytesPerPixel, srcFmt.bytesPerPixel), dstFmt, srcFmt);
+			result &= (readPixel(buffer + i * dstFmt.bytesPerPixel, dstFmt.bytesPerPixel) == expected);
+		}
+
+		delete[] src;
+		delete[] buffer;
+		return result;
+	}
+
+	public:
+	void test_crossblit_formats() {
+		const Graphics::PixelFormat formats[] = {
+			Graphics::PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0),	// RGB565
+			Graphics::PixelFormat(2, 5, 5, 5, 0, 10, 5, 0, 0),	// RGB555
+			Graphics::PixelFormat(2, 5, 5, 5, 1, 10, 5, 0, 15),	// ARGB1555
+			Graphics::PixelFormat(2, 4, 4, 4, 4, 8, 4, 0, 12),	// ARGB4444
+			Graphics::PixelFormat(3, 8, 8, 8, 0, 16, 8, 0, 0),	// RGB888
+			Graphics::PixelFormat(3, 8, 8, 8, 0, 0, 8, 16, 0),	// BGR888
+			Graphics::PixelFormat(4, 8, 8, 8, 0, 16, 8, 0, 0),	// XRGB8888
+			Graphics::PixelFormat(4, 8, 8, 8, 8, 16, 8, 0, 24),	// ARGB8888
+			Graphics::PixelFormat(4, 8, 8, 8, 8, 24, 16, 8, 0),	// RGBA8888
+			Graphics::PixelFormat(4, 8, 8, 8, 8, 0, 8, 16, 24),	// ABGR8888
+			Graphics::PixelFormat(4, 8, 8, 8, 4, 16, 8, 0, 28)	// Only 4 bits of alpha
+		};
+
+		for (int src = 0; src < ARRAYSIZE(formats); ++src) {
+			for (int dst = 0; dst < ARRAYSIZE(formats); ++dst) {
+				// Identical formats are copied, including the unused bits
+				if (formats[dst].bytesPerPixel == 3 || src == dst)
+					continue;
+
+				// Widths which do and do not fit groups of pixels
+				TS_ASSERT(checkCrossBlit(formats[dst], formats[src], 16, 3));
+				TS_ASSERT(checkCrossBlit(formats[dst], formats[src], 13, 5));
+				TS_ASSERT(checkCrossBlit(formats[dst], formats[src], 3, 2));
+				TS_ASSERT(checkCrossBlitInPlace(formats[dst], formats[src], 17, 9));
+				TS_ASSERT(checkCrossBlitInPlace(formats[dst], formats[src], 1, 3));
+			}
+		}
+	}
+
+	void test_crossblit_map() {
+		uint32 map[256];
+		for (int i = 0; i < 256; ++i)
+			map[i] = 0x01000000 * i + 0x030201 * (255 - i);
+
+		const uint w = 19, h = 7;
+		byte src[w * h];
+		uint32 seed = 1;
+		for (uint i = 0; i < w * h; ++i)
+			src[i] = nextRandom(seed);
+
+		uint32 dst[w * h];
+		TS_ASSERT(Graphics::crossBlitMap((byte *)dst, src, w * 4, w, w, h, 4, map));
+		bool matches = true;
+		for (uint i = 0; i < w * h; ++i)
+			matches &= (dst[i] == map[src[i]]);
+		TS_ASSERT(matches);
+
+		uint16 dst16[w * h];
+		TS_ASSERT(Graphics::crossBlitMap((byte *)dst16, src, w * 2, w, w, h, 2, map));
+		matches = true;
+		for (uint i = 0; i < w * h; ++i)
+			matches &= (dst16[i] == (uint16)map[src[i]]);
+		TS_ASSERT(matches);
+
+		// In place
+		byte buffer[w * h * 4];
+		memcpy(buffer, src, w * h);
+		TS_ASSERT(Graphics::crossBlitMap(buffer, buffer, w * 4, w, w, h, 4, map));
+		TS_ASSERT(!memcmp(buffer, dst, w * h * 4));
+
+		TS_ASSERT(!Graphics::crossBlitMap(buffer, src, w * 3, w, w, h, 3, map));
+	}
+};
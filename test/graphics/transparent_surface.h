@@ -0,0 +1,153 @@
+#include <cxxtest/TestSuite.h>
+
+#include "graphics/transparent_surface.h"
+
+class TransparentSurfaceTestSuite : public CxxTest::TestSuite
+{
+	static const Graphics::PixelFormat getFormat() {
+		return Graphics::PixelFormat(4, 8, 8, 8, 8, 24, 16, 8, 0);
+	}
+
+	/**
+	 * Fill a surface with reproducible pixels. A quarter of them is fully
+	 * transparent and another quarter fully opaque.
+	 */
+	static void fill(Graphics::Surface &surface, uint seed) {
+		for (int y = 0; y < surface.h; ++y) {
+			for (int x = 0; x < surface.w; ++x) {
+				seed = seed * 1103515245 + 12345;
+				uint32 pixel = seed >> 4;
+				switch ((seed >> 28) & 3) {
+				case 0:
+					pixel &= ~0xFF;
+					break;
+				case 1:
+					pixel |= 0xFF;
+					break;
+				default:
+					break;
+				}
+				*(uint32 *)surface.getBasePtr(x, y) = pixel;
+			}
+		}
+	}
+
+	static bool equals(const Graphics::Surface &a, const Graphics::Surface &b) {
+		for (int y = 0; y < a.h; ++y) {
+			if (memcmp(a.getBasePtr(0, y), b.getBasePtr(0, y), a.w * 4))
+				return false;
+		}
+		return true;
+	}
+
+	/**
+	 * Blit a sprite scaled to the given size, and compare the result with
+	 * blitting a copy scaled by scale(), which is how blit() used to do it.
+	 */
+	static bool compareScaledBlit(Graphics::TransparentSurface &sprite, int posX, int posY, int width, int height,
+	                              int flipping, uint color, Graphics::TSpriteBlendMode blendMode) {
+		Graphics::Surface target, expected;
+		target.create(120, 90, getFormat());
+		expected.create(120, 90, getFormat());
+		fill(target, 7);
+		fill(expected, 7);
+
+		Common::Rect rect = sprite.blit(target, posX, posY, flipping, 0, color, width, height, blendMode);
+
+		Graphics::TransparentSurface *scaled = sprite.scale(width, height);
+		scaled->setAlphaMode(sprite.getAlphaMode());
+		Common::Rect expectedRect = scaled->blit(expected, posX, posY, flipping, 0, color, -1, -1, blendMode);
+		scaled->free();
+		delete scaled;
+
+		const bool result = equals(target, expected) && rect == expectedRect;
+		target.free();
+		expected.free();
+		return result;
+	}
+
+	public:
+	void test_alpha_blend() {
+		Graphics::TransparentSurface sprite;
+		sprite.create(37, 11, getFormat());
+		fill(sprite, 1);
+
+		Graphics::Surface target, original;
+		target.create(40, 15, getFormat());
+		fill(target, 2);
+		original.copyFrom(target);
+
+		sprite.blit(target, 2, 3);
+
+		// Compare with the blending formula for every pixel
+		bool matches = true;
+		for (int y = 0; y < sprite.h; ++y) {
+			for (int x = 0; x < sprite.w; ++x) {
+				const uint32 in = *(const uint32 *)sprite.getBasePtr(x, y);
+				const uint32 out = *(const uint32 *)original.getBasePtr(x + 2, y + 3);
+				const uint32 a = in & 0xFF;
+				uint32 result = out;
+				if (a) {
+					result = 0xFF;
+					for (int shift = 8; shift < 32; shift += 8)
+						result |= ((((in >> shift) & 0xFF) * a + ((out >> shift) & 0xFF) * (255 - a)) >> 8) << shift;
+				}
+				matches &= (*(const uint32 *)target.getBasePtr(x + 2, y + 3) == result);
+			}
+		}
+		TS_ASSERT(matches);
+
+		sprite.free();
+		target.free();
+		original.free();
+	}
+
+	void test_scaled_blit() {
+		Graphics::TransparentSurface sprite;
+		sprite.create(30, 20, getFormat());
+		fill(sprite, 3);
+
+		const Graphics::AlphaType alphaTypes[] = { Graphics::ALPHA_OPAQUE, Graphics::ALPHA_BINARY, Graphics::ALPHA_FULL };
+		const Graphics::TSpriteBlendMode blendModes[] = { Graphics::BLEND_NORMAL, Graphics::BLEND_ADDITIVE, Graphics::BLEND_SUBTRACTIVE };
+		const uint colors[] = { 0xFFFFFFFF, 0x80C864FF };
+
+		for (int alpha = 0; alpha < ARRAYSIZE(alphaTypes); ++alpha) {
+			sprite.setAlphaMode(alphaTypes[alpha]);
+			for (int blend = 0; blend < ARRAYSIZE(blendModes); ++blend) {
+				for (int color = 0; color < ARRAYSIZE(colors); ++color) {
+					for (int flipping = 0; flipping < 4; ++flipping) {
+						// Enlarged, shrunk and clipped at all sides
+						TS_ASSERT(compareScaledBlit(sprite, 5, 7, 45, 33, flipping, colors[color], blendModes[blend]));
+						TS_ASSERT(compareScaledBlit(sprite, 1, 2, 17, 9, flipping, colors[color], blendModes[blend]));
+						TS_ASSERT(compareScaledBlit(sprite, -13, -5, 60, 41, flipping, colors[color], blendModes[blend]));
+						TS_ASSERT(compareScaledBlit(sprite, 100, 80, 31, 19, flipping, colors[color], blendModes[blend]));
+					}
+				}
+			}
+		}
+
+		sprite.free();
+	}
+
+	void test_sprite_sizes() {
+		// Typical sprite sizes, scaled like the perspective scaling of
+		// the engines using TransparentSurface does
+		const int sizes[] = { 16, 24, 32, 48, 64, 100 };
+		const int percentages[] = { 50, 75, 99, 101, 150, 200 };
+
+		for (int i = 0; i < ARRAYSIZE(sizes); ++i) {
+			Graphics::TransparentSurface sprite;
+			sprite.create(sizes[i], sizes[i] * 3 / 2, getFormat());
+			fill(sprite, i);
+
+			for (int j = 0; j < ARRAYSIZE(percentages); ++j) {
+				const int width = sprite.w * percentages[j] / 100;
+				const int height = sprite.h * percentages[j] / 100;
+				TS_ASSERT(compareScaledBlit(sprite, 3, 1, width, height, Graphics::FLIP_NONE, 0xFFFFFFFF, Graphics::BLEND_NORMAL));
+				TS_ASSERT(compareScaledBlit(sprite, 3, 1, width, height, Graphics::FLIP_H, 0xC8FFFFFF, Graphics::BLEND_NORMAL));
+			}
+
+			sprite.free();
+		}
+	}
+};
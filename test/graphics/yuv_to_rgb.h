@@ -0,0 +1,127 @@
+#include <cxxtest/TestSuite.h>
+
+#include "graphics/surface.h"
+#include "graphics/yuv_to_rgb.h"
+
+class YUVToRGBTestSuite : public CxxTest::TestSuite
+{
+	enum Subsampling {
+		kYUV444,
+		kYUV420,
+		kYUV410
+	};
+
+	static uint32 nextRandom(uint32 &seed) {
+		seed = seed * 1103515245 + 12345;
+		return (seed >> 16) | (seed << 16);
+	}
+
+	static void convert(Graphics::Surface &dst, Subsampling subsampling, Graphics::YUVToRGBManager::LuminanceScale scale, const byte *ySrc, const byte *uSrc, const byte *vSrc, int w, int h, int yPitch, int uvPitch) {
+		switch (subsampling) {
+		case kYUV444:
+			YUVToRGBMan.convert444(&dst, scale, ySrc, uSrc, vSrc, w, h, yPitch, uvPitch);
+			break;
+		case kYUV420:
+			YUVToRGBMan.convert420(&dst, scale, ySrc, uSrc, vSrc, w, h, yPitch, uvPitch);
+			break;
+		case kYUV410:
+			YUVToRGBMan.convert410(&dst, scale, ySrc, uSrc, vSrc, w, h, yPitch, uvPitch);
+			break;
+		}
+	}
+
+	/**
+	 * Convert a random image with and without SIMD, and compare the results.
+	 * The rows of all planes have some padding.
+	 */
+	static bool checkConversion(const Graphics::PixelFormat &format, Subsampling subsampling, Graphics::YUVToRGBManager::LuminanceScale scale, int w, int h) {
+		const int yPitch = w + 3;
+		const int uvWidth = (subsampling == kYUV444) ? w : (subsampling == kYUV420) ? w / 2 : w / 4 + 1;
+		const int uvHeight = (subsampling == kYUV444) ? h : (subsampling == kYUV420) ? h / 2 : h / 4 + 1;
+		const int uvPitch = uvWidth + 1;
+
+		byte *ySrc = new byte[yPitch * h];
+		byte *uSrc = new byte[uvPitch * uvHeight];
+		byte *vSrc = new byte[uvPitch * uvHeight];
+		uint32 seed = w * 7 + h;
+		for (int i = 0; i < yPitch * h; ++i)
+			ySrc[i] = nextRandom(seed);
+		for (int i = 0; i < uvPitch * uvHeight; ++i) {
+			uSrc[i] = nextRandom(seed);
+			vSrc[i] = nextRandom(seed);
+		}
+
+		Graphics::Surface reference, simd;
+		reference.init(w, h, (w + 1) * format.bytesPerPixel, new byte[(w + 1) * h * format.bytesPerPixel], format);
+		simd.init(w, h, (w + 1) * format.bytesPerPixel, new byte[(w + 1) * h * format.bytesPerPixel], format);
+		memset(reference.getPixels(), 0xAB, reference.pitch * h);
+		memset(simd.getPixels(), 0xAB, simd.pitch * h);
+
+		YUVToRGBMan.setUseSIMD(false);
+		convert(reference, subsampling, scale, ySrc, uSrc, vSrc, w, h, yPitch, uvPitch);
+		YUVToRGBMan.setUseSIMD(true);
+		convert(simd, subsampling, scale, ySrc, uSrc, vSrc, w, h, yPitch, uvPitch);
+
+		// This also checks that the padding is left alone
+		const bool result = !memcmp(reference.getPixels(), simd.getPixels(), reference.pitch * h);
+
+		delete[] (byte *)reference.getPixels();
+		delete[] (byte *)simd.getPixels();
+		delete[] ySrc;
+		delete[] uSrc;
+		delete[] vSrc;
+		return result;
+	}
+
+	static const Graphics::PixelFormat *getFormats(int &count) {
+		static const Graphics::PixelFormat formats[] = {
+			Graphics::PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0),	// RGB565
+			Graphics::PixelFormat(2, 5, 5, 5, 1, 10, 5, 0, 15),	// ARGB1555
+			Graphics::PixelFormat(2, 4, 4, 4, 4, 8, 4, 0, 12),	// ARGB4444
+			Graphics::PixelFormat(4, 8, 8, 8, 0, 16, 8, 0, 0),	// XRGB8888
+			Graphics::PixelFormat(4, 8, 8, 8, 8, 24, 16, 8, 0),	// RGBA8888
+			Graphics::PixelFormat(4, 8, 8, 8, 8, 0, 8, 16, 24)	// ABGR8888
+		};
+		count = ARRAYSIZE(formats);
+		return formats;
+	}
+
+	public:
+	void test_conversions() {
+		int numFormats;
+		const Graphics::PixelFormat *formats = getFormats(numFormats);
+		const Graphics::YUVToRGBManager::LuminanceScale scales[] = {
+			Graphics::YUVToRGBManager::kScaleFull,
+			Graphics::YUVToRGBManager::kScaleITU
+		};
+
+		for (int i = 0; i < numFormats; ++i) {
+			for (int j = 0; j < ARRAYSIZE(scales); ++j) {
+				// Widths which do and do not fit groups of pixels
+				TS_ASSERT(checkConversion(formats[i], kYUV444, scales[j], 16, 3));
+				TS_ASSERT(checkConversion(formats[i], kYUV444, scales[j], 29, 5));
+				TS_ASSERT(checkConversion(formats[i], kYUV444, scales[j], 300, 2));
+				TS_ASSERT(checkConversion(formats[i], kYUV420, scales[j], 16, 4));
+				TS_ASSERT(checkConversion(formats[i], kYUV420, scales[j], 30, 6));
+				TS_ASSERT(checkConversion(formats[i], kYUV420, scales[j], 2, 2));
+				TS_ASSERT(checkConversion(formats[i], kYUV410, scales[j], 16, 4));
+				TS_ASSERT(checkConversion(formats[i], kYUV410, scales[j], 44, 8));
+				TS_ASSERT(checkConversion(formats[i], kYUV410, scales[j], 4, 4));
+			}
+		}
+	}
+
+	void test_video_frames() {
+		// Frame sizes of common videos. The test runner cannot time the
+		// conversions, so this only checks the results.
+		int numFormats;
+		const Graphics::PixelFormat *formats = getFormats(numFormats);
+
+		TS_ASSERT(checkConversion(formats[0], kYUV420, Graphics::YUVToRGBManager::kScaleITU, 640, 480));
+		TS_ASSERT(checkConversion(formats[3], kYUV420, Graphics::YUVToRGBManager::kScaleITU, 640, 480));
+		TS_ASSERT(checkConversion(formats[0], kYUV420, Graphics::YUVToRGBManager::kScaleFull, 1280, 720));
+		TS_ASSERT(checkConversion(formats[4], kYUV420, Graphics::YUVToRGBManager::kScaleFull, 1280, 720));
+		TS_ASSERT(checkConversion(formats[3], kYUV444, Graphics::YUVToRGBManager::kScaleFull, 640, 480));
+		TS_ASSERT(checkConversion(formats[3], kYUV410, Graphics::YUVToRGBManager::kScaleITU, 640, 480));
+	}
+};
@@ -0,0 +1,223 @@
+#include <cxxtest/TestSuite.h>
+
+#include "video/video_decoder.h"
+
+#include "common/system.h"
+#include "common/timer.h"
+
+#include "graphics/surface.h"
+
+/**
+ * Runs the timer callbacks only when told to, so the tests decide when
+ * frames are decoded ahead.
+ */
+class TestTimerManager : public Common::TimerManager {
+public:
+	TestTimerManager() : _proc(0), _refCon(0) {}
+
+	bool installTimerProc(TimerProc proc, int32 interval, void *refCon, const Common::String &id) {
+		_proc = proc;
+		_refCon = refCon;
+		return true;
+	}
+
+	void removeTimerProc(TimerProc proc) {
+		if (_proc == proc)
+			_proc = 0;
+	}
+
+	void runTimers() {
+		if (_proc)
+			_proc(_refCon);
+	}
+
+private:
+	TimerProc _proc;
+	void *_refCon;
+};
+
+/**
+ * Just enough of a backend for VideoDecoder: a timer manager, a clock and
+ * mutexes, which may do nothing since the tests run in one thread.
+ */
+class TestSystem : public OSystem {
+public:
+	TestSystem() : _millis(0) { _timerManager = new TestTimerManager(); }
+
+	void runTimers() { ((TestTimerManager *)_timerManager)->runTimers(); }
+
+	const GraphicsMode *getSupportedGraphicsModes() const { return 0; }
+	int getDefaultGraphicsMode() const { return 0; }
+	bool setGraphicsMode(int mode) { return false; }
+	int getGraphicsMode() const { return 0; }
+	Graphics::PixelFormat getScreenFormat() const { return Graphics::PixelFormat::createFormatCLUT8(); }
+	Common::List<Graphics::PixelFormat> getSupportedFormats() const { return Common::List<Graphics::PixelFormat>(); }
+	void initSize(uint width, uint height, const Graphics::PixelFormat *format) {}
+	int16 getHeight() { return 0; }
+	int16 getWidth() { return 0; }
+	PaletteManager *getPaletteManager() { return 0; }
+	void copyRectToScreen(const void *buf, int pitch, int x, int y, int w, int h) {}
+	Graphics::Surface *lockScreen() { return 0; }
+	void unlockScreen() {}
+	void fillScreen(uint32 col) {}
+	void updateScreen() {}
+	void setShakePos(int shakeOffset) {}
+	void showOverlay() {}
+	void hideOverlay() {}
+	Graphics::PixelFormat getOverlayFormat() const { return Graphics::PixelFormat(); }
+	void clearOverlay() {}
+	void grabOverlay(void *buf, int pitch) {}
+	void copyRectToOverlay(const void *buf, int pitch, int x, int y, int w, int h) {}
+	int16 getOverlayHeight() { return 0; }
+	int16 getOverlayWidth() { return 0; }
+	bool showMouse(bool visible) { return false; }
+	void warpMouse(int x, int y) {}
+	void setMouseCursor(const void *buf, uint w, uint h, int hotspotX, int hotspotY, uint32 keycolor, bool dontScale, const Graphics::PixelFormat *format) {}
+	uint32 getMillis(bool skipRecord) { return _millis; }
+	void delayMillis(uint msecs) { _millis += msecs; }
+	void getTimeAndDate(TimeDate &t) const {}
+	MutexRef createMutex() { return (MutexRef)this; }
+	void lockMutex(MutexRef mutex) {}
+	void unlockMutex(MutexRef mutex) {}
+	void deleteMutex(MutexRef mutex) {}
+	Audio::Mixer *getMixer() { return 0; }
+	void quit() {}
+	void displayMessageOnOSD(const char *msg) {}
+	void logMessage(LogMessageType::Type type, const char *message) {}
+
+private:
+	uint32 _millis;
+};
+
+/**
+ * A video of 10 frames at 10 fps, where every pixel of a frame holds the
+ * frame number.
+ */
+class TestVideoDecoder : public Video::VideoDecoder {
+public:
+	TestVideoDecoder(bool decodeAhead) : _decodeAhead(decodeAhead) {}
+	~TestVideoDecoder() { close(); }
+
+	bool loadStream(Common::SeekableReadStream *stream) {
+		addTrack(new TestVideoTrack());
+		return true;
+	}
+
+protected:
+	bool supportsDecodeAhead() const { return _decodeAhead; }
+
+private:
+	class TestVideoTrack : public FixedRateVideoTrack {
+	public:
+		TestVideoTrack() : _curFrame(-1) { _surface.create(4, 4, Graphics::PixelFormat::createFormatCLUT8()); }
+		~TestVideoTrack() { _surface.free(); }
+
+		bool isRewindable() const { return true; }
+		bool rewind() { _curFrame = -1; return true; }
+
+		uint16 getWidth() const { return _surface.w; }
+		uint16 getHeight() const { return _surface.h; }
+		Graphics::PixelFormat getPixelFormat() const { return _surface.format; }
+		int getCurFrame() const { return _curFrame; }
+		int getFrameCount() const { return 10; }
+
+		const Graphics::Surface *decodeNextFrame() {
+			_curFrame++;
+			memset(_surface.getPixels(), _curFrame, _surface.w * _surface.h);
+			return &_surface;
+		}
+
+	protected:
+		Common::Rational getFrameRate() const { return 10; }
+
+	private:
+		int _curFrame;
+		Graphics::Surface _surface;
+	};
+
+	bool _decodeAhead;
+};
+
+class VideoDecoderTestSuite : public CxxTest::TestSuite {
+public:
+	void setUp() {
+		static TestSystem system;
+
+		_oldSystem = g_system;
+		_system = &system;
+		g_system = _system;
+	}
+
+	void tearDown() {
+		g_system = _oldSystem;
+	}
+
+	void test_decode_ahead_unsupported() {
+		TestVideoDecoder video(false);
+		video.loadStream(0);
+
+		TS_ASSERT(!video.setDecodeAhead(4));
+		TS_ASSERT(!video.isDecodingAhead());
+	}
+
+	void test_decode_ahead_order() {
+		TestVideoDecoder video(true);
+		video.loadStream(0);
+
+		TS_ASSERT(video.setDecodeAhead(4));
+		TS_ASSERT(video.isDecodingAhead());
+
+		// One frame per timer tick, up to the number of frames asked for
+		for (int i = 0; i < 6; i++)
+			_system->runTimers();
+
+		Video::VideoDecoder::DecodeAheadStats stats = video.getDecodeAheadStats();
+		TS_ASSERT_EQUALS(stats.framesDecoded, 4u);
+		TS_ASSERT_EQUALS(stats.queueDepth, 4u);
+		TS_ASSERT_EQUALS(video.getCurFrame(), -1);
+
+		for (int i = 0; i < 10; i++) {
+			const Graphics::Surface *surface = video.decodeNextFrame();
+			TS_ASSERT(surface);
+			TS_ASSERT_EQUALS(*(const byte *)surface->getPixels(), i);
+			TS_ASSERT_EQUALS(video.getCurFrame(), i);
+		}
+
+		TS_ASSERT(video.endOfVideo());
+
+		// The frames after the queue ran dry were decoded right away
+		stats = video.getDecodeAheadStats();
+		TS_ASSERT_EQUALS(stats.framesShown, 10u);
+		TS_ASSERT_EQUALS(stats.underruns, 6u);
+	}
+
+	void test_decode_ahead_pause() {
+		TestVideoDecoder video(true);
+		video.loadStream(0);
+		video.start();
+
+		TS_ASSERT(video.setDecodeAhead(4));
+
+		video.pauseVideo(true);
+		_system->runTimers();
+		TS_ASSERT_EQUALS(video.getDecodeAheadStats().framesDecoded, 0u);
+
+		video.pauseVideo(false);
+		_system->runTimers();
+		TS_ASSERT_EQUALS(video.getDecodeAheadStats().framesDecoded, 1u);
+
+		// Stopping a paused video resumes decoding ahead too
+		video.pauseVideo(true);
+		video.stop();
+		_system->runTimers();
+		TS_ASSERT_EQUALS(video.getDecodeAheadStats().framesDecoded, 2u);
+
+		video.setDecodeAhead(0);
+		TS_ASSERT(!video.isDecodingAhead());
+		_system->runTimers();
+	}
+
+private:
+	OSystem *_oldSystem;
+	TestSystem *_system;
+};
@@ -332,6 +332,9 @@ BinkDecoder::BinkVideoTrack::~BinkVideoTrack() {
 void BinkDecoder::BinkVideoTrack::decodePacket(VideoFrame &frame) {
 	assert(frame.bits);
 
+	// BIKi stores a 32-bit field in front of the alpha plane and another
+	// one in front of the YUV planes. There is none between the Y, U and V
+	// planes, so each of them can only be found by decoding the one before.
 	if (_hasAlpha) {
 		if (_id == kBIKiID)
 			frame.bits->skip(32);
@@ -381,6 +384,7 @@ void BinkDecoder::BinkVideoTrack::decodePlane(VideoFrame &video, int planeIdx, b
 	ctx.prevStart = _oldPlanes[planeIdx];
 	ctx.prevEnd   = _oldPlanes[planeIdx] + width * height;
 	ctx.pitch     = width;
+	ctx.blockWidth = blockWidth;
 
 	for (int i = 0; i < 64; i++) {
 		ctx.coordMap[i] = (i & 7) + (i >> 3) * ctx.pitch;
@@ -624,11 +628,26 @@ uint32 BinkDecoder::BinkVideoTrack::readBundleCount(VideoFrame &video, Bundle &b
 }
 
 void BinkDecoder::BinkVideoTrack::blockSkip(DecodeContext &ctx) {
+	// Copy all the following skipped blocks of this row at once, which
+	// are most blocks of still scenes. They only copy the same bytes from
+	// the previous frame, so the order does not matter.
+	Bundle &blockTypes = _bundles[kSourceBlockTypes];
+	uint32 count = 1;
+
+	while ((ctx.blockX + count) < ctx.blockWidth && blockTypes.curPtr < blockTypes.curDec && *blockTypes.curPtr == kBlockSkip) {
+		blockTypes.curPtr++;
+		count++;
+	}
+
 	byte *dest = ctx.dest;
 	byte *prev = ctx.prev;
 
 	for (int j = 0; j < 8; j++, dest += ctx.pitch, prev += ctx.pitch)
-		memcpy(dest, prev, 8);
+		memcpy(dest, prev, 8 * count);
+
+	ctx.blockX += count - 1;
+	ctx.dest   += 8 * (count - 1);
+	ctx.prev   += 8 * (count - 1);
 }
 
 void BinkDecoder::BinkVideoTrack::blockScaledSkip(DecodeContext &ctx) {
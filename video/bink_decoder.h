@@ -166,6 +166,7 @@ private:
 
 			uint32 blockX;
 			uint32 blockY;
+			uint32 blockWidth;
 
 			byte *dest;
 			byte *prev;
@@ -54,6 +54,9 @@ protected:
 	 */
 	virtual void readSoundData(Common::SeekableReadStream *stream);
 
+	// The stream only belongs to the video track once the sound is read
+	bool supportsDecodeAhead() const { return true; }
+
 private:
 	class DXAVideoTrack : public FixedRateVideoTrack {
 	public:
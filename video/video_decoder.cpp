@@ -27,12 +27,84 @@
 
 #include "common/rational.h"
 #include "common/file.h"
+#include "common/singleton.h"
 #include "common/system.h"
+#include "common/timer.h"
 
 #include "graphics/palette.h"
+#include "graphics/surface.h"
+
+namespace Common {
+DECLARE_SINGLETON(Video::DecodeAheadScheduler);
+}
 
 namespace Video {
 
+/**
+ * Decodes the frames ahead for all videos which want it. The timer manager
+ * only allows every callback once, so this installs one for all of them.
+ */
+class DecodeAheadScheduler : public Common::Singleton<DecodeAheadScheduler> {
+public:
+	DecodeAheadScheduler();
+	~DecodeAheadScheduler();
+
+	void addVideo(VideoDecoder *video);
+
+	/**
+	 * Remove a video. It is not accessed by the timer callback anymore
+	 * once this returns.
+	 */
+	void removeVideo(VideoDecoder *video);
+
+private:
+	static void timerProc(void *refCon);
+
+	Common::Mutex _mutex;
+	Common::Array<VideoDecoder *> _videos;
+	uint _next;
+};
+
+DecodeAheadScheduler::DecodeAheadScheduler() {
+	// Decode at most one frame every 10ms, to keep the timer thread
+	// available for the other callbacks
+	_next = 0;
+	g_system->getTimerManager()->installTimerProc(&timerProc, 10000, this, "videoDecodeAhead");
+}
+
+DecodeAheadScheduler::~DecodeAheadScheduler() {
+	g_system->getTimerManager()->removeTimerProc(&timerProc);
+}
+
+void DecodeAheadScheduler::addVideo(VideoDecoder *video) {
+	Common::StackLock lock(_mutex);
+	_videos.push_back(video);
+}
+
+void DecodeAheadScheduler::removeVideo(VideoDecoder *video) {
+	Common::StackLock lock(_mutex);
+
+	for (uint i = 0; i < _videos.size(); i++) {
+		if (_videos[i] == video) {
+			_videos.remove_at(i);
+			break;
+		}
+	}
+}
+
+void DecodeAheadScheduler::timerProc(void *refCon) {
+	DecodeAheadScheduler *scheduler = (DecodeAheadScheduler *)refCon;
+	Common::StackLock lock(scheduler->_mutex);
+
+	// Take turns, so that every video gets its frames
+	for (uint i = 0; i < scheduler->_videos.size(); i++) {
+		scheduler->_next = (scheduler->_next + 1) % scheduler->_videos.size();
+
+		if (scheduler->_videos[scheduler->_next]->decodeAhead())
+			break;
+	}
+}
+
 VideoDecoder::VideoDecoder() {
 	_startTime = 0;
 	_dirtyPalette = false;
@@ -48,6 +120,11 @@ VideoDecoder::VideoDecoder() {
 	_nextVideoTrack = 0;
 	_mainAudioTrack = 0;
 	_canSetDither = true;
+	_aheadFirst = _aheadQueued = _aheadMaxQueued = 0;
+	_aheadSuspended = 0;
+	_aheadTrack = 0;
+	_aheadCurFrame = -1;
+	resetDecodeAheadStats();
 
 	// Find the best format for output
 	_defaultHighColorFormat = g_system->getScreenFormat();
@@ -57,6 +134,8 @@ VideoDecoder::VideoDecoder() {
 }
 
 void VideoDecoder::close() {
+	setDecodeAhead(0);
+
 	if (isPlaying())
 		stop();
 
@@ -112,11 +191,14 @@ void VideoDecoder::pauseVideo(bool pause) {
 	if (_pauseLevel == 1 && pause) {
 		_pauseStartTime = g_system->getMillis(); // Store the starting time from pausing to keep it for later
 
+		// Decoding ahead stays suspended until the video is resumed
+		suspendDecodeAhead();
 		for (TrackList::iterator it = _tracks.begin(); it != _tracks.end(); it++)
 			(*it)->pause(true);
 	} else if (_pauseLevel == 0) {
 		for (TrackList::iterator it = _tracks.begin(); it != _tracks.end(); it++)
 			(*it)->pause(false);
+		resumeDecodeAhead(false);
 
 		_startTime += (g_system->getMillis() - _pauseStartTime);
 	}
@@ -175,6 +257,9 @@ const Graphics::Surface *VideoDecoder::decodeNextFrame() {
 	_needsUpdate = false;
 	_canSetDither = false;
 
+	if (_aheadTrack)
+		return takeFrameAhead();
+
 	readNextPacket();
 
 	// If we have no next video track at this point, there shouldn't be
@@ -200,6 +285,10 @@ bool VideoDecoder::setReverse(bool reverse) {
 	if (reverse && hasAudio())
 		return false;
 
+	// Frames decoded ahead are always decoded forward
+	if (reverse && _aheadTrack)
+		return false;
+
 	// Attempt to make sure all the tracks are in the requested direction
 	for (TrackList::iterator it = _tracks.begin(); it != _tracks.end(); it++) {
 		if ((*it)->getTrackType() == Track::kTrackTypeVideo && ((VideoTrack *)*it)->isReversed() != reverse) {
@@ -224,7 +313,7 @@ int VideoDecoder::getCurFrame() const {
 
 	for (TrackList::const_iterator it = _tracks.begin(); it != _tracks.end(); it++)
 		if ((*it)->getTrackType() == Track::kTrackTypeVideo)
-			frame += ((VideoTrack *)*it)->getCurFrame() + 1;
+			frame += ((*it == _aheadTrack) ? _aheadCurFrame : ((VideoTrack *)*it)->getCurFrame()) + 1;
 
 	return frame;
 }
@@ -265,7 +354,7 @@ uint32 VideoDecoder::getTimeToNextFrame() const {
 		return 0;
 
 	uint32 currentTime = getTime();
-	uint32 nextFrameStartTime = _nextVideoTrack->getNextFrameStartTime();
+	uint32 nextFrameStartTime = getNextFrameStartTime(_nextVideoTrack);
 
 	if (_nextVideoTrack->isReversed()) {
 		// For reversed videos, we need to handle the time difference the opposite way.
@@ -284,7 +373,7 @@ uint32 VideoDecoder::getTimeToNextFrame() const {
 
 bool VideoDecoder::endOfVideo() const {
 	for (TrackList::const_iterator it = _tracks.begin(); it != _tracks.end(); it++)
-		if (!(*it)->endOfTrack() && (!isPlaying() || (*it)->getTrackType() != Track::kTrackTypeVideo || !_endTimeSet || ((VideoTrack *)*it)->getNextFrameStartTime() < (uint)_endTime.msecs()))
+		if (!isTrackEnd(*it) && (!isPlaying() || (*it)->getTrackType() != Track::kTrackTypeVideo || !_endTimeSet || getNextFrameStartTime((VideoTrack *)*it) < (uint)_endTime.msecs()))
 			return false;
 
 	return true;
@@ -309,9 +398,14 @@ bool VideoDecoder::rewind() {
 	if (isPlaying())
 		stopAudio();
 
-	for (TrackList::iterator it = _tracks.begin(); it != _tracks.end(); it++)
-		if (!(*it)->rewind())
+	suspendDecodeAhead();
+	for (TrackList::iterator it = _tracks.begin(); it != _tracks.end(); it++) {
+		if (!(*it)->rewind()) {
+			resumeDecodeAhead(true);
 			return false;
+		}
+	}
+	resumeDecodeAhead(true);
 
 	// Now that we've rewound, start all tracks again
 	if (isPlaying())
@@ -344,13 +438,17 @@ bool VideoDecoder::seek(const Audio::Timestamp &time) {
 		stopAudio();
 
 	// Do the actual seeking
-	if (!seekIntern(time))
-		return false;
+	suspendDecodeAhead();
+	bool result = seekIntern(time);
 
 	// Seek any external track too
-	for (TrackListIterator it = _externalTracks.begin(); it != _externalTracks.end(); it++)
-		if (!(*it)->seek(time))
-			return false;
+	for (TrackListIterator it = _externalTracks.begin(); result && it != _externalTracks.end(); it++)
+		result = (*it)->seek(time);
+
+	resumeDecodeAhead(true);
+
+	if (!result)
+		return false;
 
 	_lastTimeChange = time;
 
@@ -421,11 +519,18 @@ void VideoDecoder::stop() {
 	_needsUpdate = false;
 
 	// Also reset the pause state.
+	bool wasPaused = isPaused();
 	_pauseLevel = 0;
 
 	// Reset the pause state of the tracks too
+	suspendDecodeAhead();
 	for (TrackList::iterator it = _tracks.begin(); it != _tracks.end(); it++)
 		(*it)->pause(false);
+	resumeDecodeAhead(false);
+
+	// Undo the suspension by pauseVideo()
+	if (wasPaused)
+		resumeDecodeAhead(false);
 }
 
 void VideoDecoder::setRate(const Common::Rational &rate) {
@@ -841,7 +946,7 @@ const VideoDecoder::Track *VideoDecoder::getTrack(uint track) const {
 
 bool VideoDecoder::endOfVideoTracks() const {
 	for (TrackList::const_iterator it = _tracks.begin(); it != _tracks.end(); it++)
-		if ((*it)->getTrackType() == Track::kTrackTypeVideo && !(*it)->endOfTrack())
+		if ((*it)->getTrackType() == Track::kTrackTypeVideo && !isTrackEnd(*it))
 			return false;
 
 	return true;
@@ -852,9 +957,9 @@ VideoDecoder::VideoTrack *VideoDecoder::findNextVideoTrack() {
 	uint32 bestTime = 0xFFFFFFFF;
 
 	for (TrackList::iterator it = _tracks.begin(); it != _tracks.end(); it++) {
-		if ((*it)->getTrackType() == Track::kTrackTypeVideo && !(*it)->endOfTrack()) {
+		if ((*it)->getTrackType() == Track::kTrackTypeVideo && !isTrackEnd(*it)) {
 			VideoTrack *track = (VideoTrack *)*it;
-			uint32 time = track->getNextFrameStartTime();
+			uint32 time = getNextFrameStartTime(track);
 
 			if (time < bestTime) {
 				bestTime = time;
@@ -874,21 +979,27 @@ void VideoDecoder::startAudio() {
 		return;
 	}
 
+	suspendDecodeAhead();
 	for (TrackList::iterator it = _tracks.begin(); it != _tracks.end(); it++)
 		if ((*it)->getTrackType() == Track::kTrackTypeAudio)
 			((AudioTrack *)*it)->start();
+	resumeDecodeAhead(false);
 }
 
 void VideoDecoder::stopAudio() {
+	suspendDecodeAhead();
 	for (TrackList::iterator it = _tracks.begin(); it != _tracks.end(); it++)
 		if ((*it)->getTrackType() == Track::kTrackTypeAudio)
 			((AudioTrack *)*it)->stop();
+	resumeDecodeAhead(false);
 }
 
 void VideoDecoder::startAudioLimit(const Audio::Timestamp &limit) {
+	suspendDecodeAhead();
 	for (TrackList::iterator it = _tracks.begin(); it != _tracks.end(); it++)
 		if ((*it)->getTrackType() == Track::kTrackTypeAudio)
 			((AudioTrack *)*it)->start(limit);
+	resumeDecodeAhead(false);
 }
 
 bool VideoDecoder::hasFramesLeft() const {
@@ -896,7 +1007,7 @@ bool VideoDecoder::hasFramesLeft() const {
 	// This is only used for needsUpdate() atm so that setEndTime() works properly
 	// And unlike endOfVideoTracks(), this takes into account _endTime
 	for (TrackList::const_iterator it = _tracks.begin(); it != _tracks.end(); it++)
-		if ((*it)->getTrackType() == Track::kTrackTypeVideo && !(*it)->endOfTrack() && (!isPlaying() || !_endTimeSet || ((VideoTrack *)*it)->getNextFrameStartTime() < (uint)_endTime.msecs()))
+		if ((*it)->getTrackType() == Track::kTrackTypeVideo && !isTrackEnd(*it) && (!isPlaying() || !_endTimeSet || getNextFrameStartTime((VideoTrack *)*it) < (uint)_endTime.msecs()))
 			return true;
 
 	return false;
@@ -910,4 +1021,202 @@ bool VideoDecoder::hasAudio() const {
 	return false;
 }
 
+bool VideoDecoder::setDecodeAhead(uint frames) {
+	if (_aheadTrack) {
+		DecodeAheadScheduler::instance().removeVideo(this);
+		freeDecodeAhead();
+	}
+
+	if (frames == 0)
+		return true;
+
+	if (!supportsDecodeAhead())
+		return false;
+
+	VideoTrack *track = 0;
+
+	for (TrackList::iterator it = _tracks.begin(); it != _tracks.end(); it++) {
+		if ((*it)->getTrackType() == Track::kTrackTypeVideo) {
+			// We only allow decoding ahead when one video track
+			// is present
+			if (track)
+				return false;
+
+			track = (VideoTrack *)*it;
+		}
+	}
+
+	if (!track || track->isReversed())
+		return false;
+
+	_aheadFrames.resize(frames + 1);
+	for (uint i = 0; i < _aheadFrames.size(); i++) {
+		_aheadFrames[i].surface = 0;
+		_aheadFrames[i].hasSurface = false;
+	}
+
+	_aheadFirst = _aheadQueued = 0;
+	_aheadMaxQueued = frames;
+	_aheadSuspended = isPaused() ? 1 : 0;
+	_aheadCurFrame = track->getCurFrame();
+	_aheadTrack = track;
+
+	// The frames are decoded from now on
+	_canSetDither = false;
+
+	DecodeAheadScheduler::instance().addVideo(this);
+	return true;
+}
+
+VideoDecoder::DecodeAheadStats VideoDecoder::getDecodeAheadStats() const {
+	Common::StackLock lock(_aheadMutex);
+	DecodeAheadStats stats = _aheadStats;
+	stats.queueDepth = _aheadQueued;
+	return stats;
+}
+
+void VideoDecoder::resetDecodeAheadStats() {
+	Common::StackLock lock(_aheadMutex);
+	memset(&_aheadStats, 0, sizeof(_aheadStats));
+}
+
+bool VideoDecoder::decodeAhead() {
+	Common::StackLock lock(_aheadMutex);
+
+	// The pause state is covered by _aheadSuspended, since _pauseLevel
+	// belongs to the calling thread
+	if (_aheadSuspended || _aheadQueued >= _aheadMaxQueued || _aheadTrack->endOfTrack())
+		return false;
+
+	decodeFrameAhead();
+	return true;
+}
+
+void VideoDecoder::decodeFrameAhead() {
+	// The slot following the queue is the one of the frame which was taken
+	// last, so it stays valid until the next one is taken
+	DecodeAheadFrame &frame = _aheadFrames[(_aheadFirst + _aheadQueued) % _aheadFrames.size()];
+
+	readNextPacket();
+
+	frame.startTime = _aheadTrack->getNextFrameStartTime();
+	const Graphics::Surface *surface = _aheadTrack->decodeNextFrame();
+	frame.curFrame = _aheadTrack->getCurFrame();
+	frame.endTime = _aheadTrack->getNextFrameStartTime();
+	frame.hasSurface = (surface != 0);
+
+	if (surface) {
+		if (!frame.surface)
+			frame.surface = new Graphics::Surface();
+
+		if (frame.surface->w != surface->w || frame.surface->h != surface->h || frame.surface->format != surface->format) {
+			frame.surface->free();
+			frame.surface->create(surface->w, surface->h, surface->format);
+		}
+
+		for (int y = 0; y < surface->h; y++)
+			memcpy(frame.surface->getBasePtr(0, y), surface->getBasePtr(0, y), surface->w * surface->format.bytesPerPixel);
+	}
+
+	frame.dirtyPalette = _aheadTrack->hasDirtyPalette();
+	if (frame.dirtyPalette)
+		memcpy(frame.palette, _aheadTrack->getPalette(), 256 * 3);
+
+	_aheadQueued++;
+	_aheadStats.framesDecoded++;
+	_aheadStats.maxQueueDepth = MAX<uint32>(_aheadStats.maxQueueDepth, _aheadQueued);
+}
+
+const Graphics::Surface *VideoDecoder::takeFrameAhead() {
+	const Graphics::Surface *surface = 0;
+
+	{
+		Common::StackLock lock(_aheadMutex);
+		_aheadStats.totalQueueDepth += _aheadQueued;
+
+		if (!_aheadQueued) {
+			if (_aheadTrack->endOfTrack())
+				return 0;
+
+			// The timer did not keep up, so decode the frame right here
+			_aheadStats.underruns++;
+			decodeFrameAhead();
+		}
+
+		DecodeAheadFrame &frame = _aheadFrames[_aheadFirst];
+		_aheadFirst = (_aheadFirst + 1) % _aheadFrames.size();
+		_aheadQueued--;
+		_aheadCurFrame = frame.curFrame;
+		_aheadStats.framesShown++;
+
+		if (isPlaying() && !isPaused() && frame.endTime > frame.startTime && getTime() >= frame.endTime)
+			_aheadStats.lateFrames++;
+
+		if (frame.dirtyPalette) {
+			_palette = frame.palette;
+			_dirtyPalette = true;
+		}
+
+		if (frame.hasSurface)
+			surface = frame.surface;
+	}
+
+	findNextVideoTrack();
+	return surface;
+}
+
+void VideoDecoder::freeDecodeAhead() {
+	for (uint i = 0; i < _aheadFrames.size(); i++) {
+		if (_aheadFrames[i].surface) {
+			_aheadFrames[i].surface->free();
+			delete _aheadFrames[i].surface;
+		}
+	}
+
+	_aheadFrames.clear();
+	_aheadFirst = _aheadQueued = _aheadMaxQueued = 0;
+	_aheadTrack = 0;
+	_aheadCurFrame = -1;
+}
+
+void VideoDecoder::suspendDecodeAhead() {
+	if (!_aheadTrack)
+		return;
+
+	Common::StackLock lock(_aheadMutex);
+	_aheadSuspended++;
+}
+
+void VideoDecoder::resumeDecodeAhead(bool flush) {
+	if (!_aheadTrack)
+		return;
+
+	Common::StackLock lock(_aheadMutex);
+	_aheadSuspended--;
+
+	// The frames in the queue are not the next ones anymore
+	if (flush) {
+		_aheadQueued = 0;
+		_aheadCurFrame = _aheadTrack->getCurFrame();
+	}
+}
+
+bool VideoDecoder::isTrackEnd(const Track *track) const {
+	if (track != _aheadTrack)
+		return track->endOfTrack();
+
+	// The track may have reached its end while there are still frames
+	// in the queue
+	Common::StackLock lock(_aheadMutex);
+	return !_aheadQueued && track->endOfTrack();
+}
+
+uint32 VideoDecoder::getNextFrameStartTime(const VideoTrack *track) const {
+	if (track != _aheadTrack)
+		return track->getNextFrameStartTime();
+
+	Common::StackLock lock(_aheadMutex);
+	return _aheadQueued ? _aheadFrames[_aheadFirst].startTime : track->getNextFrameStartTime();
+}
+
 } // End of namespace Video
@@ -26,6 +26,7 @@
 #include "audio/mixer.h"
 #include "audio/timestamp.h"	// TODO: Move this to common/ ?
 #include "common/array.h"
+#include "common/mutex.h"
 #include "common/rational.h"
 #include "common/str.h"
 #include "graphics/pixelformat.h"
@@ -46,6 +47,8 @@ struct Surface;
 
 namespace Video {
 
+class DecodeAheadScheduler;
+
 /**
  * Generic interface for video decoder classes.
  */
@@ -452,6 +455,61 @@ public:
 	 */
 	uint getAudioTrackCount() const;
 
+	/////////////////////////////////////////
+	// Decoding Ahead
+	/////////////////////////////////////////
+
+	/**
+	 * Statistics about decoding frames ahead.
+	 */
+	struct DecodeAheadStats {
+		uint32 framesDecoded;   ///< Frames decoded into the queue
+		uint32 framesShown;     ///< Frames taken from the queue by decodeNextFrame()
+		uint32 lateFrames;      ///< Frames taken when the following frame was due already
+		uint32 underruns;       ///< Frames decoded by decodeNextFrame() because the queue was empty
+		uint32 queueDepth;      ///< Frames in the queue right now
+		uint32 maxQueueDepth;   ///< Most frames in the queue at once
+		uint32 totalQueueDepth; ///< Sum of the queue depths seen by decodeNextFrame(), for the average
+	};
+
+	/**
+	 * Decode frames ahead of time from a timer callback, so that
+	 * decodeNextFrame() only has to take the next frame from a queue.
+	 *
+	 * This only works for decoders which support it (see
+	 * supportsDecodeAhead()) and for videos with one video track which
+	 * plays forward. The track is decoded on the timer thread from now on,
+	 * so the stream given to loadStream() must not be read by anything
+	 * else meanwhile. This rules out members of archives which share one
+	 * file stream between them, like ZIP files. Decoding a frame also
+	 * delays the other timer callbacks, like the music.
+	 *
+	 * Changing the number of frames or disabling it drops the frames which
+	 * are already decoded, and close() disables it.
+	 *
+	 * This should be called after setDitheringPalette().
+	 *
+	 * @param frames	the number of frames to decode ahead, or 0 to disable it
+	 * @return true on success, false otherwise
+	 */
+	bool setDecodeAhead(uint frames);
+
+	/**
+	 * Return if frames are decoded ahead of time.
+	 */
+	bool isDecodingAhead() const { return _aheadTrack != 0; }
+
+	/**
+	 * Get the statistics about decoding ahead since it was enabled or the
+	 * last call to resetDecodeAheadStats().
+	 */
+	DecodeAheadStats getDecodeAheadStats() const;
+
+	/**
+	 * Reset the statistics about decoding ahead.
+	 */
+	void resetDecodeAheadStats();
+
 protected:
 	/**
 	 * An abstract representation of a track in a movie. Since tracks here are designed
@@ -913,6 +971,31 @@ protected:
 	 */
 	virtual AudioTrack *getAudioTrack(int index) { return 0; }
 
+	/**
+	 * Can the frames be decoded ahead of time on the timer thread?
+	 *
+	 * A subclass may only return true if its video track owns the stream
+	 * exclusively after loading, it has no tracks sharing that stream, and
+	 * its frames are cheap to decode. Any other access to the track or its
+	 * stream while decoding ahead has to be between suspendDecodeAhead()
+	 * and resumeDecodeAhead().
+	 */
+	virtual bool supportsDecodeAhead() const { return false; }
+
+	/**
+	 * Stop decoding ahead until resumeDecodeAhead() is called. Calls may
+	 * be nested. This waits for the frame which is being decoded.
+	 */
+	void suspendDecodeAhead();
+
+	/**
+	 * Undo one call to suspendDecodeAhead().
+	 *
+	 * @param flush	whether the frames decoded already are dropped, because
+	 *              the track is at a different position now
+	 */
+	void resumeDecodeAhead(bool flush);
+
 private:
 	// Tracks owned by this VideoDecoder
 	TrackList _tracks;
@@ -950,6 +1033,34 @@ private:
 	int8 _audioBalance;
 
 	AudioTrack *_mainAudioTrack;
+
+	// Decoding ahead
+	friend class DecodeAheadScheduler;
+
+	struct DecodeAheadFrame {
+		Graphics::Surface *surface;
+		bool hasSurface;
+		int curFrame;
+		uint32 startTime;
+		uint32 endTime;
+		bool dirtyPalette;
+		byte palette[256 * 3];
+	};
+
+	Common::Array<DecodeAheadFrame> _aheadFrames;
+	uint _aheadFirst, _aheadQueued, _aheadMaxQueued;
+	uint _aheadSuspended;
+	VideoTrack *_aheadTrack;
+	int _aheadCurFrame;
+	DecodeAheadStats _aheadStats;
+	Common::Mutex _aheadMutex;
+
+	bool decodeAhead();
+	void decodeFrameAhead();
+	const Graphics::Surface *takeFrameAhead();
+	void freeDecodeAhead();
+	bool isTrackEnd(const Track *track) const;
+	uint32 getNextFrameStartTime(const VideoTrack *track) const;
 };
 
 } // End of namespace Video